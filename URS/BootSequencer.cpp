@@ -0,0 +1,324 @@
+/**************************************************/
+/* File name:        BootSequencer.cpp            */
+/* File description: File for the implementation  */
+/*                   of BootSequencer Class, that */
+/*                   orders the boot stages of the*/
+/*                   URS and records their timing.*/
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include "BootSequencer.h"
+
+static const char *cStageNames[BOOT_STAGE_COUNT] = {
+  "servos", "wifi", "camera", "timer", "server", "clients"
+};
+
+/****************************************************/
+/* Creator name:       BootSequencer                */
+/* Method description: Class Object creator, loads  */
+/*                     the URS dependency table.    */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+BootSequencer::BootSequencer()
+{
+  // Camera and WiFi are brought up at the same time
+  uiDependencies[BOOT_STAGE_SERVOS] = 0;
+  uiDependencies[BOOT_STAGE_WIFI] = 0;
+  // The control timer must never drive unparked servos. Its interrupt
+  // is IRAM resident but calls flash code, so it also waits for the
+  // WiFi stage to finish reading and writing the NVS cache
+  uiDependencies[BOOT_STAGE_TIMER] = BOOT_STAGE_MASK(BOOT_STAGE_SERVOS) | BOOT_STAGE_MASK(BOOT_STAGE_WIFI);
+  uiDependencies[BOOT_STAGE_CAMERA] = 0;
+  // Streaming starts as soon as both are up
+  uiDependencies[BOOT_STAGE_SERVER] = BOOT_STAGE_MASK(BOOT_STAGE_WIFI) | BOOT_STAGE_MASK(BOOT_STAGE_CAMERA);
+  uiDependencies[BOOT_STAGE_CLIENTS] = BOOT_STAGE_MASK(BOOT_STAGE_WIFI);
+  for (int iStage = 0; iStage < BOOT_STAGE_COUNT; iStage++) {
+    fnStageStart[iStage] = NULL;
+    fnStageDone[iStage] = NULL;
+  }
+  begin(0);
+}
+
+/****************************************************/
+/* Method name:        begin                        */
+/* Method description: Clears the recorded stages   */
+/*                     and sets the boot origin.    */
+/*                                                  */
+/* Input params:       ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void BootSequencer::begin(unsigned long ulNowMs)
+{
+  ulBootOrigin = ulNowMs;
+  uiStarted = 0;
+  uiFinished = 0;
+  for (int iStage = 0; iStage < BOOT_STAGE_COUNT; iStage++) {
+    ulStageStart[iStage] = 0;
+    ulStageFinish[iStage] = 0;
+  }
+}
+
+/****************************************************/
+/* Method name:        setDependencies              */
+/* Method description: Replaces the dependencies of */
+/*                     a stage.                     */
+/*                                                  */
+/* Input params:       iStage - Stage number. (int) */
+/*                     uiDependencyMask - Mask made */
+/*                     of BOOT_STAGE_MASK of lower  */
+/*                     stages. (unsigned int)       */
+/* Output params:      true if the mask only holds  */
+/*                     lower stages. (bool)         */
+/****************************************************/
+bool BootSequencer::setDependencies(int iStage, unsigned int uiDependencyMask)
+{
+  if (iStage < 0 || BOOT_STAGE_COUNT <= iStage) return false;
+  // Only lower stages keep the table free of cycles
+  if (uiDependencyMask & ~(BOOT_STAGE_MASK(iStage) - 1)) return false;
+  uiDependencies[iStage] = uiDependencyMask;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        setStage                     */
+/* Method description: Sets the functions that run a*/
+/*                     stage.                       */
+/*                                                  */
+/* Input params:       iStage - Stage number. (int) */
+/*                     fnStart - Starts the stage.  */
+/*                     (BootFunction)               */
+/*                     fnDone - Tells if a started  */
+/*                     stage is finished, NULL if it*/
+/*                     finishes when fnStart        */
+/*                     returns. (BootCondition)     */
+/* Output params:      false if the stage does not  */
+/*                     exist. (bool)                */
+/****************************************************/
+bool BootSequencer::setStage(int iStage, BootFunction fnStart, BootCondition fnDone)
+{
+  if (iStage < 0 || BOOT_STAGE_COUNT <= iStage) return false;
+  fnStageStart[iStage] = fnStart;
+  fnStageDone[iStage] = fnDone;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        run                          */
+/* Method description: Starts every stage whose     */
+/*                     dependencies are finished and*/
+/*                     polls the started ones, until*/
+/*                     all of them are finished or  */
+/*                     none can make progress.      */
+/*                                                  */
+/* Input params:       fnClock - Time source.       */
+/*                     (BootClock)                  */
+/*                     fnWait - Called between polls*/
+/*                     of unfinished stages, can be */
+/*                     NULL. (BootFunction)         */
+/*                     piBlockedStage - Receives the*/
+/*                     first stage that can never   */
+/*                     start, can be NULL. (int*)   */
+/* Output params:      true if the boot finished.   */
+/*                     (bool)                       */
+/****************************************************/
+bool BootSequencer::run(BootClock fnClock, BootFunction fnWait, int *piBlockedStage)
+{
+  while (!isBootFinished()) {
+    bool bProgress = false;
+
+    for (int iStage = 0; iStage < BOOT_STAGE_COUNT; iStage++) {
+      if (isStageFinished(iStage)) continue;
+      if (uiStarted & BOOT_STAGE_MASK(iStage)) {
+        if (fnStageDone[iStage] && fnStageDone[iStage]()) {
+          finishStage(iStage, fnClock());
+          bProgress = true;
+        }
+        continue;
+      }
+      if (!fnStageStart[iStage] || !startStage(iStage, fnClock())) continue;
+      fnStageStart[iStage]();
+      if (!fnStageDone[iStage]) finishStage(iStage, fnClock());
+      bProgress = true;
+    }
+
+    if (bProgress) continue;
+    // Only a running stage can still unblock the others
+    if (uiStarted == uiFinished) {
+      if (piBlockedStage) {
+        *piBlockedStage = 0;
+        while (uiStarted & BOOT_STAGE_MASK(*piBlockedStage)) (*piBlockedStage)++;
+      }
+      return false;
+    }
+    if (fnWait) fnWait();
+  }
+  if (piBlockedStage) *piBlockedStage = -1;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        startStage                   */
+/* Method description: Marks a stage as started if  */
+/*                     all of its dependencies are  */
+/*                     finished.                    */
+/*                                                  */
+/* Input params:       iStage - Stage number. (int) */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      true if the stage may run.   */
+/*                     (bool)                       */
+/****************************************************/
+bool BootSequencer::startStage(int iStage, unsigned long ulNowMs)
+{
+  if (iStage < 0 || BOOT_STAGE_COUNT <= iStage) return false;
+  if (uiStarted & BOOT_STAGE_MASK(iStage)) return false;
+  if ((uiFinished & uiDependencies[iStage]) != uiDependencies[iStage]) return false;
+  uiStarted |= BOOT_STAGE_MASK(iStage);
+  ulStageStart[iStage] = ulNowMs - ulBootOrigin;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        finishStage                  */
+/* Method description: Marks a started stage as     */
+/*                     finished.                    */
+/*                                                  */
+/* Input params:       iStage - Stage number. (int) */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void BootSequencer::finishStage(int iStage, unsigned long ulNowMs)
+{
+  if (iStage < 0 || BOOT_STAGE_COUNT <= iStage) return;
+  if (!(uiStarted & BOOT_STAGE_MASK(iStage))) return;
+  if (uiFinished & BOOT_STAGE_MASK(iStage)) return;
+  uiFinished |= BOOT_STAGE_MASK(iStage);
+  ulStageFinish[iStage] = ulNowMs - ulBootOrigin;
+}
+
+/****************************************************/
+/* Method name:        isStageFinished              */
+/* Method description: Tells if a stage is finished.*/
+/*                                                  */
+/* Input params:       iStage - Stage number. (int) */
+/* Output params:      true if finished. (bool)     */
+/****************************************************/
+bool BootSequencer::isStageFinished(int iStage)
+{
+  if (iStage < 0 || BOOT_STAGE_COUNT <= iStage) return false;
+  return (uiFinished & BOOT_STAGE_MASK(iStage)) != 0;
+}
+
+/****************************************************/
+/* Method name:        isBootFinished               */
+/* Method description: Tells if every stage is      */
+/*                     finished.                    */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      true if finished. (bool)     */
+/****************************************************/
+bool BootSequencer::isBootFinished()
+{
+  return uiFinished == BOOT_STAGE_MASK(BOOT_STAGE_COUNT) - 1;
+}
+
+/****************************************************/
+/* Method name:        getStageStart                */
+/* Method description: Start of a stage, in ms after*/
+/*                     the boot origin.             */
+/*                                                  */
+/* Input params:       iStage - Stage number. (int) */
+/* Output params:      Start time in ms.            */
+/****************************************************/
+unsigned long BootSequencer::getStageStart(int iStage)
+{
+  if (iStage < 0 || BOOT_STAGE_COUNT <= iStage) return 0;
+  return ulStageStart[iStage];
+}
+
+/****************************************************/
+/* Method name:        getStageDuration             */
+/* Method description: Duration of a finished stage.*/
+/*                                                  */
+/* Input params:       iStage - Stage number. (int) */
+/* Output params:      Duration in ms, 0 if the     */
+/*                     stage is not finished.       */
+/****************************************************/
+unsigned long BootSequencer::getStageDuration(int iStage)
+{
+  if (!isStageFinished(iStage)) return 0;
+  return ulStageFinish[iStage] - ulStageStart[iStage];
+}
+
+/****************************************************/
+/* Method name:        getBootDuration              */
+/* Method description: Time from the boot origin to */
+/*                     the last finished stage.     */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Duration in ms.              */
+/****************************************************/
+unsigned long BootSequencer::getBootDuration()
+{
+  unsigned long ulLastFinish = 0;
+  for (int iStage = 0; iStage < BOOT_STAGE_COUNT; iStage++) {
+    if (isStageFinished(iStage) && ulLastFinish < ulStageFinish[iStage]) ulLastFinish = ulStageFinish[iStage];
+  }
+  return ulLastFinish;
+}
+
+/****************************************************/
+/* Method name:        getCriticalPath              */
+/* Method description: Longest sum of stage         */
+/*                     durations along a dependency */
+/*                     chain, the lower bound of the*/
+/*                     boot time with the same stage*/
+/*                     durations.                   */
+/*                                                  */
+/* Input params:       piLastStage - Receives the   */
+/*                     stage that ends the chain,   */
+/*                     can be NULL. (int*)          */
+/* Output params:      Duration in ms.              */
+/****************************************************/
+unsigned long BootSequencer::getCriticalPath(int *piLastStage)
+{
+  unsigned long ulChain[BOOT_STAGE_COUNT];
+  unsigned long ulLongest = 0;
+  int iLongestStage = -1;
+
+  // Dependencies always have lower numbers, one pass is enough
+  for (int iStage = 0; iStage < BOOT_STAGE_COUNT; iStage++) {
+    unsigned long ulLongestDependency = 0;
+    for (int iDependency = 0; iDependency < iStage; iDependency++) {
+      if ((uiDependencies[iStage] & BOOT_STAGE_MASK(iDependency)) && ulLongestDependency < ulChain[iDependency]) {
+        ulLongestDependency = ulChain[iDependency];
+      }
+    }
+    ulChain[iStage] = ulLongestDependency + getStageDuration(iStage);
+    if (iLongestStage < 0 || ulLongest < ulChain[iStage]) {
+      ulLongest = ulChain[iStage];
+      iLongestStage = iStage;
+    }
+  }
+  if (piLastStage) *piLastStage = iLongestStage;
+  return ulLongest;
+}
+
+/****************************************************/
+/* Method name:        getStageName                 */
+/* Method description: Printable name of a stage.   */
+/*                                                  */
+/* Input params:       iStage - Stage number. (int) */
+/* Output params:      Stage name. (const char*)    */
+/****************************************************/
+const char *BootSequencer::getStageName(int iStage)
+{
+  if (iStage < 0 || BOOT_STAGE_COUNT <= iStage) return "unknown";
+  return cStageNames[iStage];
+}
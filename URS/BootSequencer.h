@@ -0,0 +1,240 @@
+/**************************************************/
+/* File name:        BootSequencer.h              */
+/* File description: Header File for the          */
+/*                   BootSequencer Class, that    */
+/*                   orders the boot stages of the*/
+/*                   URS and records their timing.*/
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef BootSequencer_h
+#define BootSequencer_h
+#include <stddef.h>
+
+// Defines
+#define BOOT_STAGE_SERVOS                0  // Servos parked in a safe state
+#define BOOT_STAGE_WIFI                  1  // WiFi link up
+#define BOOT_STAGE_CAMERA                2  // Camera sensor initialized
+#define BOOT_STAGE_TIMER                 3  // Control loop timer running
+#define BOOT_STAGE_SERVER                4  // Streaming server listening
+#define BOOT_STAGE_CLIENTS               5  // Cloud HTTP clients ready
+#define BOOT_STAGE_COUNT                 6
+#define BOOT_STAGE_MASK(iStage)          (1U << (iStage))
+
+// Stage start, also used for the wait between polls
+typedef void (*BootFunction)(void);
+// Stage done condition, polled until it is true
+typedef bool (*BootCondition)(void);
+// Time source in ms
+typedef unsigned long (*BootClock)(void);
+
+/****************************************************/
+/* Class name:        BootSequencer                 */
+/* Class description: Class that keeps the          */
+/*                    dependency table between the  */
+/*                    boot stages, refuses to start */
+/*                    a stage before its            */
+/*                    dependencies are finished and */
+/*                    records the start and finish  */
+/*                    time of every stage. Stages   */
+/*                    may overlap in time, a stage  */
+/*                    can only depend on stages with*/
+/*                    a lower number. run starts    */
+/*                    every stage as soon as its    */
+/*                    dependencies are finished, so */
+/*                    the order comes from the      */
+/*                    table alone. Times are given  */
+/*                    by the caller so the class    */
+/*                    runs on the host too.         */
+/****************************************************/
+class BootSequencer
+{
+  private:
+    // Private Variables:
+    unsigned int uiDependencies[BOOT_STAGE_COUNT];
+    BootFunction fnStageStart[BOOT_STAGE_COUNT];
+    BootCondition fnStageDone[BOOT_STAGE_COUNT];
+    unsigned long ulStageStart[BOOT_STAGE_COUNT];
+    unsigned long ulStageFinish[BOOT_STAGE_COUNT];
+    unsigned int uiStarted;
+    unsigned int uiFinished;
+    unsigned long ulBootOrigin;
+
+  public:
+
+    /****************************************************/
+    /* Creator name:       BootSequencer                */
+    /* Method description: Class Object creator, loads  */
+    /*                     the URS dependency table.    */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    BootSequencer();
+
+    /****************************************************/
+    /* Method name:        begin                        */
+    /* Method description: Clears the recorded stages   */
+    /*                     and sets the boot origin.    */
+    /*                                                  */
+    /* Input params:       ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void begin(unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        setDependencies              */
+    /* Method description: Replaces the dependencies of */
+    /*                     a stage.                     */
+    /*                                                  */
+    /* Input params:       iStage - Stage number. (int) */
+    /*                     uiDependencyMask - Mask made */
+    /*                     of BOOT_STAGE_MASK of lower  */
+    /*                     stages. (unsigned int)       */
+    /* Output params:      true if the mask only holds  */
+    /*                     lower stages. (bool)         */
+    /****************************************************/
+    bool setDependencies(int iStage, unsigned int uiDependencyMask);
+
+    /****************************************************/
+    /* Method name:        setStage                     */
+    /* Method description: Sets the functions that run a*/
+    /*                     stage.                       */
+    /*                                                  */
+    /* Input params:       iStage - Stage number. (int) */
+    /*                     fnStart - Starts the stage.  */
+    /*                     (BootFunction)               */
+    /*                     fnDone - Tells if a started  */
+    /*                     stage is finished, NULL if it*/
+    /*                     finishes when fnStart        */
+    /*                     returns. (BootCondition)     */
+    /* Output params:      false if the stage does not  */
+    /*                     exist. (bool)                */
+    /****************************************************/
+    bool setStage(int iStage, BootFunction fnStart, BootCondition fnDone);
+
+    /****************************************************/
+    /* Method name:        run                          */
+    /* Method description: Starts every stage whose     */
+    /*                     dependencies are finished and*/
+    /*                     polls the started ones, until*/
+    /*                     all of them are finished or  */
+    /*                     none can make progress.      */
+    /*                                                  */
+    /* Input params:       fnClock - Time source.       */
+    /*                     (BootClock)                  */
+    /*                     fnWait - Called between polls*/
+    /*                     of unfinished stages, can be */
+    /*                     NULL. (BootFunction)         */
+    /*                     piBlockedStage - Receives the*/
+    /*                     first stage that can never   */
+    /*                     start, can be NULL. (int*)   */
+    /* Output params:      true if the boot finished.   */
+    /*                     (bool)                       */
+    /****************************************************/
+    bool run(BootClock fnClock, BootFunction fnWait, int *piBlockedStage);
+
+    /****************************************************/
+    /* Method name:        startStage                   */
+    /* Method description: Marks a stage as started if  */
+    /*                     all of its dependencies are  */
+    /*                     finished.                    */
+    /*                                                  */
+    /* Input params:       iStage - Stage number. (int) */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      true if the stage may run.   */
+    /*                     (bool)                       */
+    /****************************************************/
+    bool startStage(int iStage, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        finishStage                  */
+    /* Method description: Marks a started stage as     */
+    /*                     finished.                    */
+    /*                                                  */
+    /* Input params:       iStage - Stage number. (int) */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void finishStage(int iStage, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        isStageFinished              */
+    /* Method description: Tells if a stage is finished.*/
+    /*                                                  */
+    /* Input params:       iStage - Stage number. (int) */
+    /* Output params:      true if finished. (bool)     */
+    /****************************************************/
+    bool isStageFinished(int iStage);
+
+    /****************************************************/
+    /* Method name:        isBootFinished               */
+    /* Method description: Tells if every stage is      */
+    /*                     finished.                    */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      true if finished. (bool)     */
+    /****************************************************/
+    bool isBootFinished();
+
+    /****************************************************/
+    /* Method name:        getStageStart                */
+    /* Method description: Start of a stage, in ms after*/
+    /*                     the boot origin.             */
+    /*                                                  */
+    /* Input params:       iStage - Stage number. (int) */
+    /* Output params:      Start time in ms.            */
+    /****************************************************/
+    unsigned long getStageStart(int iStage);
+
+    /****************************************************/
+    /* Method name:        getStageDuration             */
+    /* Method description: Duration of a finished stage.*/
+    /*                                                  */
+    /* Input params:       iStage - Stage number. (int) */
+    /* Output params:      Duration in ms, 0 if the     */
+    /*                     stage is not finished.       */
+    /****************************************************/
+    unsigned long getStageDuration(int iStage);
+
+    /****************************************************/
+    /* Method name:        getBootDuration              */
+    /* Method description: Time from the boot origin to */
+    /*                     the last finished stage.     */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Duration in ms.              */
+    /****************************************************/
+    unsigned long getBootDuration();
+
+    /****************************************************/
+    /* Method name:        getCriticalPath              */
+    /* Method description: Longest sum of stage         */
+    /*                     durations along a dependency */
+    /*                     chain, the lower bound of the*/
+    /*                     boot time with the same stage*/
+    /*                     durations.                   */
+    /*                                                  */
+    /* Input params:       piLastStage - Receives the   */
+    /*                     stage that ends the chain,   */
+    /*                     can be NULL. (int*)          */
+    /* Output params:      Duration in ms.              */
+    /****************************************************/
+    unsigned long getCriticalPath(int *piLastStage);
+
+    /****************************************************/
+    /* Method name:        getStageName                 */
+    /* Method description: Printable name of a stage.   */
+    /*                                                  */
+    /* Input params:       iStage - Stage number. (int) */
+    /* Output params:      Stage name. (const char*)    */
+    /****************************************************/
+    const char *getStageName(int iStage);
+};
+
+#endif
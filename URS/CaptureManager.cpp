@@ -0,0 +1,388 @@
+/**************************************************/
+/* File name:        CaptureManager.cpp           */
+/* File description: File for the implementation  */
+/*                   of CaptureManager Class, that*/
+/*                   runs the camera only while   */
+/*                   there are stream consumers.  */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include "CaptureManager.h"
+
+static const char *cStateNames[CAPTURE_STATE_COUNT] = {
+  "parked", "keepalive", "idle", "streaming", "resuming"
+};
+
+/****************************************************/
+/* Creator name:       CaptureManager               */
+/* Method description: Class Object creator         */
+/*                                                  */
+/* Input params:       pCameraDriver - Camera to    */
+/*                     manage. (OV2640*)            */
+/* Output params:                                   */
+/****************************************************/
+CaptureManager::CaptureManager(OV2640 *pCameraDriver)
+{
+  pCamera = pCameraDriver;
+  iState = CAPTURE_STATE_PARKED;
+  iConsumers = 0;
+  bKeepAlive = false;
+  bCameraOk = false;
+  bKeepAliveGrabbing = false;
+  bResumeStopPending = false;
+  iResumeFramesLeft = 0;
+  ulResumeStartMs = 0;
+  fnKeepAliveFrame = NULL;
+  iFullXclkHz = 0;
+  stFullFrameBuffers = 0;
+  ulStateSinceMs = 0;
+  for (int iStateNumber = 0; iStateNumber < CAPTURE_STATE_COUNT; iStateNumber++) ulStateTimeMs[iStateNumber] = 0;
+  ulLastCaptureMs = 0;
+  ulLastFirstFrameMs = 0;
+  ulMaxFirstFrameMs = 0;
+  ulResumes = 0;
+}
+
+/****************************************************/
+/* Method name:        begin                        */
+/* Method description: Takes the camera already     */
+/*                     initialized at full rate.    */
+/*                                                  */
+/* Input params:       bCameraStarted - Result of   */
+/*                     the camera init. (bool)      */
+/*                     bKeepAliveMode - Keeps a low */
+/*                     rate capture instead of      */
+/*                     parking. (bool)              */
+/*                     fnFrame - Gets each keep     */
+/*                     alive frame, NULL drops them.*/
+/*                     (CaptureFrameFunction)       */
+/* Output params:                                   */
+/****************************************************/
+void CaptureManager::begin(bool bCameraStarted, bool bKeepAliveMode, CaptureFrameFunction fnFrame)
+{
+  bCameraOk = bCameraStarted;
+  bKeepAlive = bKeepAliveMode;
+  fnKeepAliveFrame = fnFrame;
+  iFullXclkHz = pCamera->getXclkFrequency();
+  stFullFrameBuffers = pCamera->getFrameBufferCount();
+  ulStateSinceMs = millis();
+  iState = CAPTURE_STATE_IDLE;
+}
+
+/****************************************************/
+/* Method name:        acquire                      */
+/* Method description: Registers a stream consumer, */
+/*                     resuming the camera if it was*/
+/*                     parked or in keep alive, or  */
+/*                     grabbing a fresh frame if it */
+/*                     was idle. Returns at once,   */
+/*                     frames can be read once the  */
+/*                     state is streaming. A failed */
+/*                     resume drops the consumers.  */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void CaptureManager::acquire()
+{
+  iConsumers++;
+  if (iState == CAPTURE_STATE_STREAMING || iState == CAPTURE_STATE_RESUMING) return;
+  if (iState == CAPTURE_STATE_IDLE && bCameraOk) {
+    // Do not hand a frame left from the last consumer
+    beginResume(false, 1);
+  } else {
+    // The first frames after a sensor reset are badly exposed
+    ulResumes++;
+    beginResume(true, CAPTURE_WARMUP_FRAMES + 1);
+  }
+}
+
+/****************************************************/
+/* Method name:        release                      */
+/* Method description: Unregisters a stream         */
+/*                     consumer.                    */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void CaptureManager::release()
+{
+  if (0 < iConsumers) iConsumers--;
+  if (iConsumers == 0 && iState == CAPTURE_STATE_STREAMING) setState(CAPTURE_STATE_IDLE);
+}
+
+/****************************************************/
+/* Method name:        update                       */
+/* Method description: Runs the resume, parks the   */
+/*                     camera after the idle timeout*/
+/*                     and runs the keep alive      */
+/*                     capture. Must be called from */
+/*                     the main loop.               */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void CaptureManager::update()
+{
+  unsigned long ulNowMs = millis();
+
+  if (iState == CAPTURE_STATE_RESUMING) {
+    updateResume(ulNowMs);
+  } else if (iState == CAPTURE_STATE_IDLE && CAPTURE_IDLE_TIMEOUT_MS <= ulNowMs - ulStateSinceMs) {
+    // A stream grab in flight ends by the driver timeout, a later call parks
+    if (!stopCamera(0)) return;
+    if (bKeepAlive) {
+      // One buffer stops the continuous DMA, the lower clock slows the sensor
+      startCamera(CAPTURE_KEEPALIVE_XCLK_HZ, 1);
+      ulLastCaptureMs = ulNowMs;
+      bKeepAliveGrabbing = false;
+      setState(CAPTURE_STATE_KEEPALIVE);
+    } else {
+      setState(CAPTURE_STATE_PARKED);
+    }
+  } else if (iState == CAPTURE_STATE_KEEPALIVE && bCameraOk) {
+    // A single frame at the low clock takes long, the loop must not wait for it
+    if (!bKeepAliveGrabbing) {
+      if (ulNowMs - ulLastCaptureMs < CAPTURE_KEEPALIVE_PERIOD_MS) return;
+      ulLastCaptureMs = ulNowMs;
+      bKeepAliveGrabbing = true;
+    }
+    if (!pCamera->runFor(0)) return;
+    bKeepAliveGrabbing = false;
+    if (fnKeepAliveFrame) fnKeepAliveFrame(pCamera->getfb(), pCamera->getSize());
+  }
+}
+
+/****************************************************/
+/* Method name:        getState                     */
+/* Method description: Current state.               */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      CAPTURE_STATE value. (int)   */
+/****************************************************/
+int CaptureManager::getState()
+{
+  return iState;
+}
+
+/****************************************************/
+/* Method name:        getConsumerCount             */
+/* Method description: Registered stream consumers. */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Consumers. (int)             */
+/****************************************************/
+int CaptureManager::getConsumerCount()
+{
+  return iConsumers;
+}
+
+/****************************************************/
+/* Method name:        getStateName                 */
+/* Method description: Printable name of a state.   */
+/*                                                  */
+/* Input params:       iStateNumber - State. (int)  */
+/* Output params:      State name. (const char*)    */
+/****************************************************/
+const char *CaptureManager::getStateName(int iStateNumber)
+{
+  if (iStateNumber < 0 || CAPTURE_STATE_COUNT <= iStateNumber) return "unknown";
+  return cStateNames[iStateNumber];
+}
+
+/****************************************************/
+/* Method name:        getStateTime                 */
+/* Method description: Total time spent in a state, */
+/*                     including the current one.   */
+/*                                                  */
+/* Input params:       iStateNumber - State. (int)  */
+/* Output params:      Time in ms.                  */
+/****************************************************/
+unsigned long CaptureManager::getStateTime(int iStateNumber)
+{
+  if (iStateNumber < 0 || CAPTURE_STATE_COUNT <= iStateNumber) return 0;
+  unsigned long ulTimeMs = ulStateTimeMs[iStateNumber];
+  if (iStateNumber == iState) ulTimeMs += millis() - ulStateSinceMs;
+  return ulTimeMs;
+}
+
+/****************************************************/
+/* Method name:        getLastFirstFrameLatency     */
+/* Method description: Time the last resume took to */
+/*                     deliver its first frame.     */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Time in ms.                  */
+/****************************************************/
+unsigned long CaptureManager::getLastFirstFrameLatency()
+{
+  return ulLastFirstFrameMs;
+}
+
+/****************************************************/
+/* Method name:        getMaxFirstFrameLatency      */
+/* Method description: Longest first frame latency. */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Time in ms.                  */
+/****************************************************/
+unsigned long CaptureManager::getMaxFirstFrameLatency()
+{
+  return ulMaxFirstFrameMs;
+}
+
+/****************************************************/
+/* Method name:        getResumeCount               */
+/* Method description: Number of camera resumes.    */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Resumes. (unsigned long)     */
+/****************************************************/
+unsigned long CaptureManager::getResumeCount()
+{
+  return ulResumes;
+}
+
+/****************************************************/
+/* Method name:        setState                     */
+/* Method description: Changes the state, adding the*/
+/*                     time spent in the old one.   */
+/*                                                  */
+/* Input params:       iNewState - New state. (int) */
+/* Output params:                                   */
+/****************************************************/
+void CaptureManager::setState(int iNewState)
+{
+  unsigned long ulNowMs = millis();
+  ulStateTimeMs[iState] += ulNowMs - ulStateSinceMs;
+  ulStateSinceMs = ulNowMs;
+  iState = iNewState;
+}
+
+/****************************************************/
+/* Method name:        stopCamera                   */
+/* Method description: Stops the camera driver,     */
+/*                     unless a grab is still in    */
+/*                     flight after the given wait. */
+/*                                                  */
+/* Input params:       ulWaitMs - Longest wait for a*/
+/*                     grab in flight. (unsigned    */
+/*                     long)                        */
+/* Output params:      true if the camera is        */
+/*                     stopped. (bool)              */
+/****************************************************/
+bool CaptureManager::stopCamera(unsigned long ulWaitMs)
+{
+  if (bCameraOk && pCamera->deinit(ulWaitMs) == ESP_ERR_TIMEOUT) return false;
+  bCameraOk = false;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        startCamera                  */
+/* Method description: Starts the stopped camera    */
+/*                     driver with the given clock  */
+/*                     and buffers.                 */
+/*                                                  */
+/* Input params:       iXclkHz - Sensor clock. (int)*/
+/*                     stFrameBuffers - Number of   */
+/*                     frame buffers. (size_t)      */
+/* Output params:      true if the camera is up.    */
+/*                     (bool)                       */
+/****************************************************/
+bool CaptureManager::startCamera(int iXclkHz, size_t stFrameBuffers)
+{
+  pCamera->setXclkFrequency(iXclkHz);
+  pCamera->setFrameBufferCount(stFrameBuffers);
+  bCameraOk = (pCamera->reinit() == ESP_OK);
+  return bCameraOk;
+}
+
+/****************************************************/
+/* Method name:        beginResume                  */
+/* Method description: Starts getting an exposed    */
+/*                     frame, run by update.        */
+/*                                                  */
+/* Input params:       bRestart - Puts the camera   */
+/*                     back at full rate first.     */
+/*                     (bool)                       */
+/*                     iFrames - Frames grabbed, the*/
+/*                     last is handed. (int)        */
+/* Output params:                                   */
+/****************************************************/
+void CaptureManager::beginResume(bool bRestart, int iFrames)
+{
+  ulResumeStartMs = millis();
+  bResumeStopPending = bRestart;
+  iResumeFramesLeft = iFrames;
+  setState(CAPTURE_STATE_RESUMING);
+}
+
+/****************************************************/
+/* Method name:        updateResume                 */
+/* Method description: Polls the resume: the stop of*/
+/*                     the camera, which waits for a*/
+/*                     keep alive grab in flight,   */
+/*                     then its start and the warm  */
+/*                     up frames. Gives up at the   */
+/*                     resume timeout, so a hung    */
+/*                     driver can not hold it.      */
+/*                                                  */
+/* Input params:       ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void CaptureManager::updateResume(unsigned long ulNowMs)
+{
+  if (CAPTURE_RESUME_TIMEOUT_MS <= ulNowMs - ulResumeStartMs) {
+    endResume(false);
+    return;
+  }
+
+  if (bResumeStopPending) {
+    if (!stopCamera(0)) return;
+    bResumeStopPending = false;
+    // The driver init still runs here, it does not wait on the sensor
+    if (!startCamera(iFullXclkHz, stFullFrameBuffers)) {
+      endResume(false);
+      return;
+    }
+  }
+
+  if (!pCamera->runFor(0)) return;
+  if (0 < pCamera->getSize()) iResumeFramesLeft--;
+  if (iResumeFramesLeft <= 0) endResume(true);
+}
+
+/****************************************************/
+/* Method name:        endResume                    */
+/* Method description: Keeps the first frame latency*/
+/*                     and leaves the resume. On a  */
+/*                     failure the consumers are    */
+/*                     dropped and the state is the */
+/*                     one the camera is left in.   */
+/*                                                  */
+/* Input params:       bExposed - A frame is ready. */
+/*                     (bool)                       */
+/* Output params:                                   */
+/****************************************************/
+void CaptureManager::endResume(bool bExposed)
+{
+  ulLastFirstFrameMs = millis() - ulResumeStartMs;
+  if (ulMaxFirstFrameMs < ulLastFirstFrameMs) ulMaxFirstFrameMs = ulLastFirstFrameMs;
+
+  if (bExposed) {
+    setState(0 < iConsumers ? CAPTURE_STATE_STREAMING : CAPTURE_STATE_IDLE);
+    return;
+  }
+  iConsumers = 0;
+  if (bResumeStopPending) {
+    // The keep alive grab is still in flight, its update collects it
+    bResumeStopPending = false;
+    setState(CAPTURE_STATE_KEEPALIVE);
+  } else {
+    setState(bCameraOk ? CAPTURE_STATE_IDLE : CAPTURE_STATE_PARKED);
+  }
+}
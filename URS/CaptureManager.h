@@ -0,0 +1,285 @@
+/**************************************************/
+/* File name:        CaptureManager.h             */
+/* File description: Header File for the          */
+/*                   CaptureManager Class, that   */
+/*                   runs the camera only while   */
+/*                   there are stream consumers.  */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef CaptureManager_h
+#define CaptureManager_h
+#include "Arduino.h"
+#include "OV2640.h"
+
+// Defines
+#define CAPTURE_STATE_PARKED             0    // Driver stopped, sensor powered down
+#define CAPTURE_STATE_KEEPALIVE          1    // Down-clocked, single frame on demand
+#define CAPTURE_STATE_IDLE               2    // Full rate, waiting before parking
+#define CAPTURE_STATE_STREAMING          3    // Full rate, clients connected
+#define CAPTURE_STATE_RESUMING           4    // Back to full rate, no exposed frame yet
+#define CAPTURE_STATE_COUNT              5
+#define CAPTURE_IDLE_TIMEOUT_MS          5000 // Avoids restarting on quick reconnects
+#define CAPTURE_KEEPALIVE_PERIOD_MS      1000
+#define CAPTURE_KEEPALIVE_XCLK_HZ        6000000 // OV2640 minimum input clock
+#define CAPTURE_WARMUP_FRAMES            2    // Dropped while exposure settles
+#define CAPTURE_RESUME_TIMEOUT_MS        1000 // Bound of the first frame latency
+
+typedef void (*CaptureFrameFunction)(const uint8_t *pJpeg, size_t stLength);
+
+/****************************************************/
+/* Class name:        CaptureManager                */
+/* Class description: Class that parks the camera   */
+/*                    when the stream has no        */
+/*                    consumers and resumes it with */
+/*                    an already exposed frame when */
+/*                    one connects, a step per      */
+/*                    update so the caller is never */
+/*                    held. Optionally keeps a low  */
+/*                    rate capture instead of       */
+/*                    parking, handing each frame to*/
+/*                    a function without blocking   */
+/*                    the caller. Keeps the time    */
+/*                    spent in each state and the   */
+/*                    first frame latency.          */
+/****************************************************/
+class CaptureManager
+{
+  private:
+    // Private Variables:
+    OV2640 *pCamera;
+    int iState;
+    int iConsumers;
+    boolean bKeepAlive;
+    boolean bCameraOk;
+    boolean bKeepAliveGrabbing;
+    boolean bResumeStopPending;
+    int iResumeFramesLeft;
+    unsigned long ulResumeStartMs;
+    CaptureFrameFunction fnKeepAliveFrame;
+    int iFullXclkHz;
+    size_t stFullFrameBuffers;
+    unsigned long ulStateSinceMs;
+    unsigned long ulStateTimeMs[CAPTURE_STATE_COUNT];
+    unsigned long ulLastCaptureMs;
+    unsigned long ulLastFirstFrameMs;
+    unsigned long ulMaxFirstFrameMs;
+    unsigned long ulResumes;
+
+    /****************************************************/
+    /* Method name:        setState                     */
+    /* Method description: Changes the state, adding the*/
+    /*                     time spent in the old one.   */
+    /*                                                  */
+    /* Input params:       iNewState - New state. (int) */
+    /* Output params:                                   */
+    /****************************************************/
+    void setState(int iNewState);
+
+    /****************************************************/
+    /* Method name:        stopCamera                   */
+    /* Method description: Stops the camera driver,     */
+    /*                     unless a grab is still in    */
+    /*                     flight after the given wait. */
+    /*                                                  */
+    /* Input params:       ulWaitMs - Longest wait for a*/
+    /*                     grab in flight. (unsigned    */
+    /*                     long)                        */
+    /* Output params:      true if the camera is        */
+    /*                     stopped. (bool)              */
+    /****************************************************/
+    bool stopCamera(unsigned long ulWaitMs);
+
+    /****************************************************/
+    /* Method name:        startCamera                  */
+    /* Method description: Starts the stopped camera    */
+    /*                     driver with the given clock  */
+    /*                     and buffers.                 */
+    /*                                                  */
+    /* Input params:       iXclkHz - Sensor clock. (int)*/
+    /*                     stFrameBuffers - Number of   */
+    /*                     frame buffers. (size_t)      */
+    /* Output params:      true if the camera is up.    */
+    /*                     (bool)                       */
+    /****************************************************/
+    bool startCamera(int iXclkHz, size_t stFrameBuffers);
+
+    /****************************************************/
+    /* Method name:        beginResume                  */
+    /* Method description: Starts getting an exposed    */
+    /*                     frame, run by update.        */
+    /*                                                  */
+    /* Input params:       bRestart - Puts the camera   */
+    /*                     back at full rate first.     */
+    /*                     (bool)                       */
+    /*                     iFrames - Frames grabbed, the*/
+    /*                     last is handed. (int)        */
+    /* Output params:                                   */
+    /****************************************************/
+    void beginResume(bool bRestart, int iFrames);
+
+    /****************************************************/
+    /* Method name:        updateResume                 */
+    /* Method description: Polls the resume: the stop of*/
+    /*                     the camera, which waits for a*/
+    /*                     keep alive grab in flight,   */
+    /*                     then its start and the warm  */
+    /*                     up frames. Gives up at the   */
+    /*                     resume timeout.              */
+    /*                                                  */
+    /* Input params:       ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void updateResume(unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        endResume                    */
+    /* Method description: Keeps the first frame latency*/
+    /*                     and leaves the resume. On a  */
+    /*                     failure the consumers are    */
+    /*                     dropped.                     */
+    /*                                                  */
+    /* Input params:       bExposed - A frame is ready. */
+    /*                     (bool)                       */
+    /* Output params:                                   */
+    /****************************************************/
+    void endResume(bool bExposed);
+
+  public:
+
+    /****************************************************/
+    /* Creator name:       CaptureManager               */
+    /* Method description: Class Object creator         */
+    /*                                                  */
+    /* Input params:       pCameraDriver - Camera to    */
+    /*                     manage. (OV2640*)            */
+    /* Output params:                                   */
+    /****************************************************/
+    CaptureManager(OV2640 *pCameraDriver);
+
+    /****************************************************/
+    /* Method name:        begin                        */
+    /* Method description: Takes the camera already     */
+    /*                     initialized at full rate.    */
+    /*                                                  */
+    /* Input params:       bCameraStarted - Result of   */
+    /*                     the camera init. (bool)      */
+    /*                     bKeepAliveMode - Keeps a low */
+    /*                     rate capture instead of      */
+    /*                     parking. (bool)              */
+    /*                     fnFrame - Gets each keep     */
+    /*                     alive frame, NULL drops them.*/
+    /*                     (CaptureFrameFunction)       */
+    /* Output params:                                   */
+    /****************************************************/
+    void begin(bool bCameraStarted, bool bKeepAliveMode, CaptureFrameFunction fnFrame);
+
+    /****************************************************/
+    /* Method name:        acquire                      */
+    /* Method description: Registers a stream consumer, */
+    /*                     resuming the camera if it was*/
+    /*                     parked or in keep alive, or  */
+    /*                     grabbing a fresh frame if it */
+    /*                     was idle. Returns at once,   */
+    /*                     frames can be read once the  */
+    /*                     state is streaming. A failed */
+    /*                     resume drops the consumers.  */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    void acquire();
+
+    /****************************************************/
+    /* Method name:        release                      */
+    /* Method description: Unregisters a stream         */
+    /*                     consumer.                    */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    void release();
+
+    /****************************************************/
+    /* Method name:        update                       */
+    /* Method description: Runs the resume, parks the   */
+    /*                     camera after the idle timeout*/
+    /*                     and runs the keep alive      */
+    /*                     capture. Must be called from */
+    /*                     the main loop.               */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    void update();
+
+    /****************************************************/
+    /* Method name:        getState                     */
+    /* Method description: Current state.               */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      CAPTURE_STATE value. (int)   */
+    /****************************************************/
+    int getState();
+
+    /****************************************************/
+    /* Method name:        getConsumerCount             */
+    /* Method description: Registered stream consumers. */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Consumers. (int)             */
+    /****************************************************/
+    int getConsumerCount();
+
+    /****************************************************/
+    /* Method name:        getStateName                 */
+    /* Method description: Printable name of a state.   */
+    /*                                                  */
+    /* Input params:       iStateNumber - State. (int)  */
+    /* Output params:      State name. (const char*)    */
+    /****************************************************/
+    const char *getStateName(int iStateNumber);
+
+    /****************************************************/
+    /* Method name:        getStateTime                 */
+    /* Method description: Total time spent in a state, */
+    /*                     including the current one.   */
+    /*                                                  */
+    /* Input params:       iStateNumber - State. (int)  */
+    /* Output params:      Time in ms.                  */
+    /****************************************************/
+    unsigned long getStateTime(int iStateNumber);
+
+    /****************************************************/
+    /* Method name:        getLastFirstFrameLatency     */
+    /* Method description: Time the last resume took to */
+    /*                     deliver its first frame.     */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Time in ms.                  */
+    /****************************************************/
+    unsigned long getLastFirstFrameLatency();
+
+    /****************************************************/
+    /* Method name:        getMaxFirstFrameLatency      */
+    /* Method description: Longest first frame latency. */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Time in ms.                  */
+    /****************************************************/
+    unsigned long getMaxFirstFrameLatency();
+
+    /****************************************************/
+    /* Method name:        getResumeCount               */
+    /* Method description: Number of camera resumes.    */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Resumes. (unsigned long)     */
+    /****************************************************/
+    unsigned long getResumeCount();
+};
+
+#endif
@@ -0,0 +1,469 @@
+/**************************************************/
+/* File name:        HttpGetClient.cpp            */
+/* File description: File for the implementation  */
+/*                   of HttpGetClient Class, a non*/
+/*                   blocking HTTP GET client over*/
+/*                   lwIP sockets, polled from the*/
+/*                   main loop.                   */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include "HttpGetClient.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#ifdef ARDUINO
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#else
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/****************************************************/
+/* Method name:        findHeader                   */
+/* Method description: Finds the value of a header, */
+/*                     ignoring the name case.      */
+/*                                                  */
+/* Input params:       cHeaders - Header lines, each*/
+/*                     ending with CRLF.            */
+/*                     (const char*)                */
+/*                     cName - Header name.         */
+/*                     (const char*)                */
+/* Output params:      Value start or NULL.         */
+/*                     (const char*)                */
+/****************************************************/
+static const char *findHeader(const char *cHeaders, const char *cName)
+{
+  size_t stNameLength = strlen(cName);
+  const char *pLine = cHeaders;
+  while (pLine && *pLine && *pLine != '\r') {
+    if (strncasecmp(pLine, cName, stNameLength) == 0 && pLine[stNameLength] == ':') {
+      const char *pValue = pLine + stNameLength + 1;
+      while (*pValue == ' ') pValue++;
+      return pValue;
+    }
+    pLine = strstr(pLine, "\r\n");
+    if (pLine) pLine += 2;
+  }
+  return NULL;
+}
+
+/****************************************************/
+/* Method name:        decodeChunks                 */
+/* Method description: Joins a chunked body in      */
+/*                     place once its last chunk    */
+/*                     arrived.                     */
+/*                                                  */
+/* Input params:       pBody - Chunked body, NUL    */
+/*                     terminated. (char*)          */
+/*                     stLength - Its size. (size_t)*/
+/* Output params:      false if not all there, the  */
+/*                     body is left as it was.      */
+/*                     (bool)                       */
+/****************************************************/
+static bool decodeChunks(char *pBody, size_t stLength)
+{
+  char *pEnd = pBody + stLength;
+  char *pRead;
+  char *pWrite = pBody;
+
+  // First only check, the body must not change until it is whole
+  for (int iPass = 0; iPass < 2; iPass++) {
+    pRead = pBody;
+    while (true) {
+      char *pSizeEnd = strstr(pRead, "\r\n");
+      if (!pSizeEnd) return false;
+      size_t stChunk = strtoul(pRead, NULL, 16);
+      pRead = pSizeEnd + 2;
+      if (stChunk == 0) break;
+      if ((size_t)(pEnd - pRead) < stChunk + 2) return false;
+      if (iPass == 1) {
+        memmove(pWrite, pRead, stChunk);
+        pWrite += stChunk;
+      }
+      pRead += stChunk + 2;
+    }
+  }
+  *pWrite = '\0';
+  return true;
+}
+
+/****************************************************/
+/* Creator name:       HttpGetClient                */
+/* Method description: Class Object creator         */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+HttpGetClient::HttpGetClient()
+{
+  cHost[0] = '\0';
+  ui16Port = 80;
+  stRequestLength = 0;
+  stRequestSent = 0;
+  stResponseLength = 0;
+  pBody = NULL;
+  iStatus = 0;
+  ui32Address = 0;
+  bResolved = false;
+  ulResolveMs = 0;
+  iSocket = -1;
+  iState = HTTP_GET_IDLE;
+  bConnecting = false;
+  bReused = false;
+  bKeepAlive = false;
+  ulStartMs = 0;
+  ulLastLatencyMs = 0;
+  ulFailed = 0;
+}
+
+/****************************************************/
+/* Method name:        begin                        */
+/* Method description: Sets the URL and looks its   */
+/*                     host up.                     */
+/*                                                  */
+/* Input params:       cUrl - http://host[:port]/   */
+/*                     path. (const char*)          */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      false if the URL is not valid*/
+/*                     or the host was not found.   */
+/*                     (bool)                       */
+/****************************************************/
+bool HttpGetClient::begin(const char *cUrl, unsigned long ulNowMs)
+{
+  const char *pHost = cUrl;
+  if (strncmp(pHost, "http://", 7) == 0) pHost += 7;
+  const char *pSlash = strchr(pHost, '/');
+  const char *pPath = pSlash ? pSlash : "/";
+  size_t stHostLength = pSlash ? (size_t)(pSlash - pHost) : strlen(pHost);
+  const char *pPort = (const char *)memchr(pHost, ':', stHostLength);
+
+  ui16Port = 80;
+  if (pPort) {
+    ui16Port = strtoul(pPort + 1, NULL, 10);
+    stHostLength = pPort - pHost;
+  }
+  if (stHostLength == 0 || HTTP_GET_HOST_SIZE <= stHostLength) return false;
+  memcpy(cHost, pHost, stHostLength);
+  cHost[stHostLength] = '\0';
+
+  int iLength = snprintf(cRequest, sizeof(cRequest),
+                         "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n", pPath, cHost);
+  if (iLength < 0 || (int)sizeof(cRequest) <= iLength) return false;
+  stRequestLength = iLength;
+  closeSocket();
+  return resolve(ulNowMs);
+}
+
+/****************************************************/
+/* Method name:        request                      */
+/* Method description: Starts a GET of the URL.     */
+/*                                                  */
+/* Input params:       ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      false if one is running or   */
+/*                     it failed at once. (bool)    */
+/****************************************************/
+bool HttpGetClient::request(unsigned long ulNowMs)
+{
+  char cPeek;
+
+  if (iState == HTTP_GET_BUSY || stRequestLength == 0) return false;
+  stRequestSent = 0;
+  stResponseLength = 0;
+  pBody = NULL;
+  iStatus = 0;
+  ulStartMs = ulNowMs;
+
+  // A kept connection the server closed meanwhile reads as end of file
+  if (0 <= iSocket) {
+    int iPeeked = recv(iSocket, &cPeek, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (0 <= iPeeked || (errno != EAGAIN && errno != EWOULDBLOCK)) closeSocket();
+  }
+  bReused = (0 <= iSocket);
+  if (!bReused) {
+    if (!bResolved && (HTTP_GET_RESOLVE_RETRY_MS <= ulNowMs - ulResolveMs)) resolve(ulNowMs);
+    if (!bResolved || !connectSocket()) {
+      ulFailed++;
+      return false;
+    }
+  }
+  iState = HTTP_GET_BUSY;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        poll                         */
+/* Method description: Moves the request on, never  */
+/*                     blocking.                    */
+/*                                                  */
+/* Input params:       ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      HTTP_GET_ state. (int)       */
+/****************************************************/
+int HttpGetClient::poll(unsigned long ulNowMs)
+{
+  int iError;
+
+  if (iState != HTTP_GET_BUSY) return HTTP_GET_IDLE;
+  if (HTTP_GET_TIMEOUT_MS <= ulNowMs - ulStartMs) {
+    // Not retried, a kept connection is not the cause of a silent server
+    bReused = false;
+    return fail();
+  }
+
+  if (bConnecting) {
+    if (!isConnectDone(&iError)) return HTTP_GET_BUSY;
+    if (iError) return fail();
+    bConnecting = false;
+  }
+
+  while (stRequestSent < stRequestLength) {
+    int iSent = send(iSocket, cRequest + stRequestSent, stRequestLength - stRequestSent, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (iSent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return HTTP_GET_BUSY;
+      return fail();
+    }
+    stRequestSent += iSent;
+  }
+
+  bool bClosed = false;
+  while (!bClosed) {
+    size_t stRoom = HTTP_GET_RESPONSE_SIZE - stResponseLength;
+    if (stRoom == 0) {
+      // Longer than the buffer, a reused connection would not help
+      bReused = false;
+      return fail();
+    }
+    int iReceived = recv(iSocket, cResponse + stResponseLength, stRoom, MSG_DONTWAIT);
+    if (iReceived == 0) bClosed = true;
+    else if (iReceived < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    else if (iReceived < 0) return fail();
+    else stResponseLength += iReceived;
+  }
+
+  if (!isResponseComplete(bClosed)) {
+    if (bClosed) return fail();
+    return HTTP_GET_BUSY;
+  }
+  if (!bKeepAlive || bClosed) closeSocket();
+  ulLastLatencyMs = ulNowMs - ulStartMs;
+  iState = HTTP_GET_IDLE;
+  return HTTP_GET_DONE;
+}
+
+/****************************************************/
+/* Method name:        getStatus, getBody           */
+/* Method description: Status code and body of the  */
+/*                     last response, valid until   */
+/*                     the next request.            */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Status. (int)                */
+/*                     Body. (const char*)          */
+/****************************************************/
+int HttpGetClient::getStatus()
+{
+  return iStatus;
+}
+
+const char *HttpGetClient::getBody()
+{
+  return pBody ? pBody : "";
+}
+
+/****************************************************/
+/* Method name:        getLastLatency               */
+/* Method description: Time from request to the     */
+/*                     whole response of the last   */
+/*                     one received.                */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Time in ms.                  */
+/****************************************************/
+unsigned long HttpGetClient::getLastLatency()
+{
+  return ulLastLatencyMs;
+}
+
+/****************************************************/
+/* Method name:        getFailedCount               */
+/* Method description: Requests lost to errors and  */
+/*                     timeouts.                    */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Requests. (unsigned long)    */
+/****************************************************/
+unsigned long HttpGetClient::getFailedCount()
+{
+  return ulFailed;
+}
+
+/****************************************************/
+/* Method name:        resolve                      */
+/* Method description: Looks the host name up.      */
+/*                                                  */
+/* Input params:       ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      true if found. (bool)        */
+/****************************************************/
+bool HttpGetClient::resolve(unsigned long ulNowMs)
+{
+  struct addrinfo aiHints;
+  struct addrinfo *pResult = NULL;
+
+  ulResolveMs = ulNowMs;
+  memset(&aiHints, 0, sizeof(aiHints));
+  aiHints.ai_family = AF_INET;
+  aiHints.ai_socktype = SOCK_STREAM;
+  bResolved = (getaddrinfo(cHost, NULL, &aiHints, &pResult) == 0 && pResult);
+  if (bResolved) ui32Address = ((struct sockaddr_in *)pResult->ai_addr)->sin_addr.s_addr;
+  if (pResult) freeaddrinfo(pResult);
+  return bResolved;
+}
+
+/****************************************************/
+/* Method name:        connectSocket                */
+/* Method description: Starts a connection to the   */
+/*                     server.                      */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      false if it failed at once.  */
+/*                     (bool)                       */
+/****************************************************/
+bool HttpGetClient::connectSocket()
+{
+  struct sockaddr_in saAddress;
+
+  closeSocket();
+  iSocket = socket(AF_INET, SOCK_STREAM, 0);
+  if (iSocket < 0) return false;
+  fcntl(iSocket, F_SETFL, fcntl(iSocket, F_GETFL, 0) | O_NONBLOCK);
+  memset(&saAddress, 0, sizeof(saAddress));
+  saAddress.sin_family = AF_INET;
+  saAddress.sin_addr.s_addr = ui32Address;
+  saAddress.sin_port = htons(ui16Port);
+  if (connect(iSocket, (struct sockaddr *)&saAddress, sizeof(saAddress)) == 0) return true;
+  if (errno != EINPROGRESS) {
+    closeSocket();
+    return false;
+  }
+  bConnecting = true;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        closeSocket                  */
+/* Method description: Closes the connection.       */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void HttpGetClient::closeSocket()
+{
+  if (0 <= iSocket) close(iSocket);
+  iSocket = -1;
+  bConnecting = false;
+}
+
+/****************************************************/
+/* Method name:        isConnectDone                */
+/* Method description: Tells if a connection being  */
+/*                     made is up or refused.       */
+/*                                                  */
+/* Input params:       pError - Set to the error,   */
+/*                     0 if up. (int*)              */
+/* Output params:      true if done. (bool)         */
+/****************************************************/
+bool HttpGetClient::isConnectDone(int *pError)
+{
+  fd_set fsWrite;
+  struct timeval tvNoWait = {0, 0};
+  socklen_t slLength = sizeof(*pError);
+
+  FD_ZERO(&fsWrite);
+  FD_SET(iSocket, &fsWrite);
+  if (select(iSocket + 1, NULL, &fsWrite, NULL, &tvNoWait) <= 0) return false;
+  if (getsockopt(iSocket, SOL_SOCKET, SO_ERROR, pError, &slLength) < 0) *pError = errno;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        isResponseComplete           */
+/* Method description: Parses what was received and */
+/*                     tells if the whole response  */
+/*                     is in the buffer.            */
+/*                                                  */
+/* Input params:       bClosed - Server closed the  */
+/*                     connection. (bool)           */
+/* Output params:      true if complete. (bool)     */
+/****************************************************/
+bool HttpGetClient::isResponseComplete(bool bClosed)
+{
+  cResponse[stResponseLength] = '\0';
+  char *pHeadersEnd = strstr(cResponse, "\r\n\r\n");
+  if (!pHeadersEnd) return false;
+  char *pBodyStart = pHeadersEnd + 4;
+  size_t stBodyLength = stResponseLength - (pBodyStart - cResponse);
+
+  const char *pStatus = strchr(cResponse, ' ');
+  iStatus = pStatus ? atoi(pStatus + 1) : 0;
+  const char *pHeaders = strstr(cResponse, "\r\n") + 2;
+  const char *pConnection = findHeader(pHeaders, "Connection");
+  const char *pContentLength = findHeader(pHeaders, "Content-Length");
+  const char *pEncoding = findHeader(pHeaders, "Transfer-Encoding");
+  bKeepAlive = strncmp(cResponse, "HTTP/1.1", 8) == 0 && !(pConnection && strncasecmp(pConnection, "close", 5) == 0);
+
+  if (pContentLength) {
+    size_t stContentLength = strtoul(pContentLength, NULL, 10);
+    if (stBodyLength < stContentLength) return false;
+    pBodyStart[stContentLength] = '\0';
+  } else if (pEncoding && strncasecmp(pEncoding, "chunked", 7) == 0) {
+    if (!decodeChunks(pBodyStart, stBodyLength)) return false;
+  } else {
+    // Only the end of the connection tells where the body ends
+    bKeepAlive = false;
+    if (!bClosed) return false;
+  }
+  pBody = pBodyStart;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        fail                         */
+/* Method description: Drops the request, or sends  */
+/*                     it again on a new connection */
+/*                     if a kept one was closed by  */
+/*                     the server before answering. */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Next state. (int)            */
+/****************************************************/
+int HttpGetClient::fail()
+{
+  if (bReused && stResponseLength == 0) {
+    bReused = false;
+    stRequestSent = 0;
+    if (connectSocket()) return HTTP_GET_BUSY;
+  }
+  closeSocket();
+  pBody = NULL;
+  ulFailed++;
+  iState = HTTP_GET_IDLE;
+  return HTTP_GET_FAILED;
+}
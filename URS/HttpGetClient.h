@@ -0,0 +1,216 @@
+/**************************************************/
+/* File name:        HttpGetClient.h              */
+/* File description: Header File for the          */
+/*                   HttpGetClient Class, a non   */
+/*                   blocking HTTP GET client over*/
+/*                   lwIP sockets, polled from the*/
+/*                   main loop.                   */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef HttpGetClient_h
+#define HttpGetClient_h
+#include <stddef.h>
+#include <stdint.h>
+
+// Defines
+#define HTTP_GET_HOST_SIZE               64
+#define HTTP_GET_REQUEST_SIZE            256  // Request line and headers
+#define HTTP_GET_RESPONSE_SIZE           512  // Headers and body, longer ones fail
+#define HTTP_GET_TIMEOUT_MS              2000 // Whole request, connect included
+#define HTTP_GET_RESOLVE_RETRY_MS        30000 // Between lookups of a host not found
+
+#define HTTP_GET_IDLE                    0    // No request, nothing to report
+#define HTTP_GET_BUSY                    1    // Connecting, sending or receiving
+#define HTTP_GET_DONE                    2    // Response received, reported once
+#define HTTP_GET_FAILED                  3    // Request lost, reported once
+
+/****************************************************/
+/* Class name:        HttpGetClient                 */
+/* Class description: Class that sends GET requests */
+/*                    to one URL without blocking,  */
+/*                    each poll moves the request as*/
+/*                    far as the socket allows. The */
+/*                    connection is kept between    */
+/*                    requests when the server      */
+/*                    allows it. The host name is   */
+/*                    looked up by begin, which     */
+/*                    waits for the DNS, and again  */
+/*                    only after a failed lookup.   */
+/****************************************************/
+class HttpGetClient
+{
+  private:
+    // Private Variables:
+    char cHost[HTTP_GET_HOST_SIZE];
+    uint16_t ui16Port;
+    char cRequest[HTTP_GET_REQUEST_SIZE];
+    size_t stRequestLength;
+    size_t stRequestSent;
+    char cResponse[HTTP_GET_RESPONSE_SIZE + 1];
+    size_t stResponseLength;
+    const char *pBody;
+    int iStatus;
+    uint32_t ui32Address;
+    bool bResolved;
+    unsigned long ulResolveMs;
+    int iSocket;
+    int iState;
+    bool bConnecting;
+    bool bReused;
+    bool bKeepAlive;
+    unsigned long ulStartMs;
+    unsigned long ulLastLatencyMs;
+    unsigned long ulFailed;
+
+    /****************************************************/
+    /* Method name:        resolve                      */
+    /* Method description: Looks the host name up.      */
+    /*                                                  */
+    /* Input params:       ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      true if found. (bool)        */
+    /****************************************************/
+    bool resolve(unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        connectSocket                */
+    /* Method description: Starts a connection to the   */
+    /*                     server.                      */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      false if it failed at once.  */
+    /*                     (bool)                       */
+    /****************************************************/
+    bool connectSocket();
+
+    /****************************************************/
+    /* Method name:        closeSocket                  */
+    /* Method description: Closes the connection.       */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    void closeSocket();
+
+    /****************************************************/
+    /* Method name:        isConnectDone                */
+    /* Method description: Tells if a connection being  */
+    /*                     made is up or refused.       */
+    /*                                                  */
+    /* Input params:       pError - Set to the error,   */
+    /*                     0 if up. (int*)              */
+    /* Output params:      true if done. (bool)         */
+    /****************************************************/
+    bool isConnectDone(int *pError);
+
+    /****************************************************/
+    /* Method name:        isResponseComplete           */
+    /* Method description: Parses what was received and */
+    /*                     tells if the whole response  */
+    /*                     is in the buffer.            */
+    /*                                                  */
+    /* Input params:       bClosed - Server closed the  */
+    /*                     connection. (bool)           */
+    /* Output params:      true if complete. (bool)     */
+    /****************************************************/
+    bool isResponseComplete(bool bClosed);
+
+    /****************************************************/
+    /* Method name:        fail                         */
+    /* Method description: Drops the request, or sends  */
+    /*                     it again on a new connection */
+    /*                     if a kept one was closed by  */
+    /*                     the server before answering. */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Next state. (int)            */
+    /****************************************************/
+    int fail();
+
+  public:
+
+    /****************************************************/
+    /* Creator name:       HttpGetClient                */
+    /* Method description: Class Object creator         */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    HttpGetClient();
+
+    /****************************************************/
+    /* Method name:        begin                        */
+    /* Method description: Sets the URL and looks its   */
+    /*                     host up.                     */
+    /*                                                  */
+    /* Input params:       cUrl - http://host[:port]/   */
+    /*                     path. (const char*)          */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      false if the URL is not valid*/
+    /*                     or the host was not found.   */
+    /*                     (bool)                       */
+    /****************************************************/
+    bool begin(const char *cUrl, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        request                      */
+    /* Method description: Starts a GET of the URL.     */
+    /*                                                  */
+    /* Input params:       ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      false if one is running or   */
+    /*                     it failed at once. (bool)    */
+    /****************************************************/
+    bool request(unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        poll                         */
+    /* Method description: Moves the request on, never  */
+    /*                     blocking.                    */
+    /*                                                  */
+    /* Input params:       ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      HTTP_GET_ state. (int)       */
+    /****************************************************/
+    int poll(unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        getStatus, getBody           */
+    /* Method description: Status code and body of the  */
+    /*                     last response, valid until   */
+    /*                     the next request.            */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Status. (int)                */
+    /*                     Body. (const char*)          */
+    /****************************************************/
+    int getStatus();
+    const char *getBody();
+
+    /****************************************************/
+    /* Method name:        getLastLatency               */
+    /* Method description: Time from request to the     */
+    /*                     whole response of the last   */
+    /*                     one received.                */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Time in ms.                  */
+    /****************************************************/
+    unsigned long getLastLatency();
+
+    /****************************************************/
+    /* Method name:        getFailedCount               */
+    /* Method description: Requests lost to errors and  */
+    /*                     timeouts.                    */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Requests. (unsigned long)    */
+    /****************************************************/
+    unsigned long getFailedCount();
+};
+
+#endif
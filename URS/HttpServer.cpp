@@ -0,0 +1,870 @@
+/**************************************************/
+/* File name:        HttpServer.cpp               */
+/* File description: File for the implementation  */
+/*                   of HttpServer Class, a non   */
+/*                   blocking HTTP server over    */
+/*                   lwIP sockets that serves many*/
+/*                   connections from the main    */
+/*                   loop.                        */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include "HttpServer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#ifdef ARDUINO
+#include "lwip/sockets.h"
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static const char cRejectResponse[] = "HTTP/1.1 503 Service Unavailable\r\n" \
+                                      "Content-Length: 0\r\nConnection: close\r\n\r\n";
+
+/****************************************************/
+/* Method name:        getStatusText                */
+/* Method description: Reason phrase of a status.   */
+/*                                                  */
+/* Input params:       iCode - HTTP status. (int)   */
+/* Output params:      Reason. (const char*)        */
+/****************************************************/
+static const char *getStatusText(int iCode)
+{
+  switch (iCode) {
+    case 200: return "OK";
+    case 404: return "Not Found";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default:  return "Unknown";
+  }
+}
+
+/****************************************************/
+/* Method name:        findHeader                   */
+/* Method description: Finds the value of a header, */
+/*                     ignoring the name case.      */
+/*                                                  */
+/* Input params:       cHeaders - Header lines, each*/
+/*                     ending with CRLF.            */
+/*                     (const char*)                */
+/*                     cName - Header name.         */
+/*                     (const char*)                */
+/* Output params:      Value start or NULL.         */
+/*                     (const char*)                */
+/****************************************************/
+static const char *findHeader(const char *cHeaders, const char *cName)
+{
+  size_t stNameLength = strlen(cName);
+  const char *pLine = cHeaders;
+  while (pLine && *pLine && *pLine != '\r') {
+    if (strncasecmp(pLine, cName, stNameLength) == 0 && pLine[stNameLength] == ':') {
+      const char *pValue = pLine + stNameLength + 1;
+      while (*pValue == ' ') pValue++;
+      return pValue;
+    }
+    pLine = strstr(pLine, "\r\n");
+    if (pLine) pLine += 2;
+  }
+  return NULL;
+}
+
+/****************************************************/
+/* Creator name:       HttpServer                   */
+/* Method description: Class Object creator         */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+HttpServer::HttpServer()
+{
+  iListenSocket = -1;
+  iRouteCount = 0;
+  fnNotFound = NULL;
+  iConnectionCount = 0;
+  iPeakConnectionCount = 0;
+  ulAccepted = 0;
+  ulRejected = 0;
+  ulSkippedParts = 0;
+  ulLastPollMs = 0;
+  ulLastAcceptPollIntervalMs = 0;
+  ulMaxAcceptPollIntervalMs = 0;
+  ulMaxResponseLatencyMs = 0;
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    hcConnections[iConnection].iSocket = -1;
+    hcConnections[iConnection].iState = HTTP_CONN_FREE;
+  }
+}
+
+/****************************************************/
+/* Method name:        on                           */
+/* Method description: Adds a handler for GET       */
+/*                     requests to a path.          */
+/*                                                  */
+/* Input params:       cPath - Path without query.  */
+/*                     (const char*)                */
+/*                     fnHandler - Handler.         */
+/*                     (HttpHandler)                */
+/* Output params:      false if the table is full.  */
+/*                     (bool)                       */
+/****************************************************/
+bool HttpServer::on(const char *cPath, HttpHandler fnHandler)
+{
+  if (HTTP_MAX_ROUTES <= iRouteCount) return false;
+  cRoutePaths[iRouteCount] = cPath;
+  fnRouteHandlers[iRouteCount] = fnHandler;
+  iRouteCount++;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        onNotFound                   */
+/* Method description: Sets the handler of every    */
+/*                     other request.               */
+/*                                                  */
+/* Input params:       fnHandler - Handler.         */
+/*                     (HttpHandler)                */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::onNotFound(HttpHandler fnHandler)
+{
+  fnNotFound = fnHandler;
+}
+
+/****************************************************/
+/* Method name:        begin                        */
+/* Method description: Starts listening.            */
+/*                                                  */
+/* Input params:       ui16Port - TCP port.         */
+/*                     (uint16_t)                   */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      true if listening. (bool)    */
+/****************************************************/
+bool HttpServer::begin(uint16_t ui16Port, unsigned long ulNowMs)
+{
+  struct sockaddr_in saAddress;
+  int iReuse = 1;
+
+  iListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+  if (iListenSocket < 0) return false;
+  setsockopt(iListenSocket, SOL_SOCKET, SO_REUSEADDR, &iReuse, sizeof(iReuse));
+  memset(&saAddress, 0, sizeof(saAddress));
+  saAddress.sin_family = AF_INET;
+  saAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+  saAddress.sin_port = htons(ui16Port);
+  if (bind(iListenSocket, (struct sockaddr *)&saAddress, sizeof(saAddress)) < 0 ||
+      listen(iListenSocket, HTTP_LISTEN_BACKLOG) < 0) {
+    close(iListenSocket);
+    iListenSocket = -1;
+    return false;
+  }
+  fcntl(iListenSocket, F_SETFL, fcntl(iListenSocket, F_GETFL, 0) | O_NONBLOCK);
+  // The first accept interval counts from here, not from boot
+  ulLastPollMs = ulNowMs;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        poll                         */
+/* Method description: Runs accept, read and write  */
+/*                     on every connection once,    */
+/*                     never blocking. Must be      */
+/*                     called from the main loop.   */
+/*                                                  */
+/* Input params:       ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::poll(unsigned long ulNowMs)
+{
+  if (iListenSocket < 0) return;
+  acceptConnections(ulNowMs);
+
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    HttpConnection *pConnection = &hcConnections[iConnection];
+    if (pConnection->iState == HTTP_CONN_FREE) continue;
+
+    // No reading while writing, a slow client holds its own requests back
+    if (pConnection->iState != HTTP_CONN_WRITING) readConnection(iConnection, ulNowMs);
+    if (pConnection->iState == HTTP_CONN_READING) dispatchRequest(iConnection, ulNowMs);
+    if (pConnection->iState == HTTP_CONN_WRITING || pConnection->iState == HTTP_CONN_STREAMING) {
+      writeConnection(iConnection, ulNowMs);
+    }
+
+    if (pConnection->iState == HTTP_CONN_READING && HTTP_IDLE_TIMEOUT_MS < ulNowMs - pConnection->ulActivityMs) {
+      closeConnection(iConnection, true);
+    } else if ((pConnection->iState == HTTP_CONN_WRITING || pConnection->iState == HTTP_CONN_STREAMING) &&
+               !isOutputDone(iConnection) && HTTP_SEND_TIMEOUT_MS < ulNowMs - pConnection->ulActivityMs) {
+      closeConnection(iConnection, false);
+    }
+  }
+  ulLastPollMs = ulNowMs;
+}
+
+/****************************************************/
+/* Method name:        getMethod, getPath, getQuery */
+/* Method description: Parts of the request being   */
+/*                     handled, valid only inside   */
+/*                     the handler.                 */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/* Output params:      Text, empty if missing.      */
+/*                     (const char*)                */
+/****************************************************/
+const char *HttpServer::getMethod(int iConnection)
+{
+  if (!isValidResponder(iConnection) || !hcConnections[iConnection].pMethod) return "";
+  return hcConnections[iConnection].pMethod;
+}
+
+const char *HttpServer::getPath(int iConnection)
+{
+  if (!isValidResponder(iConnection) || !hcConnections[iConnection].pPath) return "";
+  return hcConnections[iConnection].pPath;
+}
+
+const char *HttpServer::getQuery(int iConnection)
+{
+  if (!isValidResponder(iConnection) || !hcConnections[iConnection].pQuery) return "";
+  return hcConnections[iConnection].pQuery;
+}
+
+/****************************************************/
+/* Method name:        getArgCount                  */
+/* Method description: Number of query arguments of */
+/*                     the request being handled.   */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/* Output params:      Arguments. (int)             */
+/****************************************************/
+int HttpServer::getArgCount(int iConnection)
+{
+  const char *pQuery = getQuery(iConnection);
+  if (!*pQuery) return 0;
+  int iArgs = 1;
+  for (; *pQuery; pQuery++) {
+    if (*pQuery == '&') iArgs++;
+  }
+  return iArgs;
+}
+
+/****************************************************/
+/* Method name:        send                         */
+/* Method description: Answers with a copy of a text*/
+/*                     body, cut at the response    */
+/*                     buffer size.                 */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/*                     iCode - HTTP status. (int)   */
+/*                     cContentType - Content type. */
+/*                     (const char*)                */
+/*                     cText - Body. (const char*)  */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::send(int iConnection, int iCode, const char *cContentType, const char *cText)
+{
+  if (!isValidResponder(iConnection)) return;
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  size_t stLength = strlen(cText);
+  if (HTTP_RESPONSE_BUFFER_SIZE < stLength) stLength = HTTP_RESPONSE_BUFFER_SIZE;
+  memcpy(pConnection->cBody, cText, stLength);
+  sendData(iConnection, iCode, cContentType, (const uint8_t *)pConnection->cBody, stLength, NULL);
+}
+
+/****************************************************/
+/* Method name:        sendData                     */
+/* Method description: Answers with a body that is  */
+/*                     not copied, it must stay     */
+/*                     valid until fnDone is called.*/
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/*                     iCode - HTTP status. (int)   */
+/*                     cContentType - Content type. */
+/*                     (const char*)                */
+/*                     pData - Body. (const         */
+/*                     uint8_t*)                    */
+/*                     stLength - Body size.        */
+/*                     (size_t)                     */
+/*                     fnDone - Callback, can be    */
+/*                     NULL. (HttpDoneCallback)     */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::sendData(int iConnection, int iCode, const char *cContentType, const uint8_t *pData, size_t stLength, HttpDoneCallback fnDone)
+{
+  if (!isValidResponder(iConnection)) return;
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  int iHeadLength = snprintf(pConnection->cHead, HTTP_HEAD_BUFFER_SIZE,
+                             "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\nConnection: %s\r\n\r\n",
+                             iCode, getStatusText(iCode), cContentType, (unsigned int)stLength,
+                             pConnection->bKeepAlive ? "keep-alive" : "close");
+  if (HTTP_HEAD_BUFFER_SIZE <= iHeadLength) iHeadLength = HTTP_HEAD_BUFFER_SIZE - 1;
+  setOutput(iConnection, pConnection->cHead, iHeadLength, pData, stLength, NULL, 0);
+  pConnection->fnDone = fnDone;
+  pConnection->iState = HTTP_CONN_WRITING;
+}
+
+/****************************************************/
+/* Method name:        beginStream                  */
+/* Method description: Turns the connection into a  */
+/*                     stream that receives every   */
+/*                     pushed part. All the strings */
+/*                     must stay valid.             */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/*                     cResponseHead - Status line  */
+/*                     and headers. (const char*)   */
+/*                     cPartPrefix - Written before */
+/*                     the part size of each part.  */
+/*                     (const char*)                */
+/*                     cPartTail - Written after    */
+/*                     the head and each part.      */
+/*                     (const char*)                */
+/*                     fnDone - Called when the     */
+/*                     stream closes, can be NULL.  */
+/*                     (HttpDoneCallback)           */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::beginStream(int iConnection, const char *cResponseHead, const char *cPartPrefix, const char *cPartTail, HttpDoneCallback fnDone)
+{
+  if (!isValidResponder(iConnection)) return;
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  setOutput(iConnection, cResponseHead, strlen(cResponseHead), NULL, 0, cPartTail, strlen(cPartTail));
+  pConnection->pPartPrefix = cPartPrefix;
+  pConnection->pPartTail = cPartTail;
+  pConnection->fnDone = fnDone;
+  pConnection->bKeepAlive = false;
+  pConnection->iState = HTTP_CONN_STREAMING;
+}
+
+/****************************************************/
+/* Method name:        isStreamWaiting              */
+/* Method description: Tells if a stream sent its   */
+/*                     last part and waits for the  */
+/*                     next one.                    */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      true if waiting. (bool)      */
+/****************************************************/
+bool HttpServer::isStreamWaiting()
+{
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    if (hcConnections[iConnection].iState == HTTP_CONN_STREAMING && isOutputDone(iConnection)) return true;
+  }
+  return false;
+}
+
+/****************************************************/
+/* Method name:        isPartInUse                  */
+/* Method description: Tells if a stream is still   */
+/*                     sending a part, so it can not*/
+/*                     be released or overwritten.  */
+/*                                                  */
+/* Input params:       pData - Part. (const         */
+/*                     uint8_t*)                    */
+/* Output params:      true if in use. (bool)       */
+/****************************************************/
+bool HttpServer::isPartInUse(const uint8_t *pData)
+{
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    HttpConnection *pConnection = &hcConnections[iConnection];
+    // Past the body only the tail is left, the part is no longer read
+    if (pConnection->iState == HTTP_CONN_STREAMING && pConnection->pOutput[1] == pData &&
+        pConnection->iOutputSegment <= 1 && !isOutputDone(iConnection)) return true;
+  }
+  return false;
+}
+
+/****************************************************/
+/* Method name:        pushStreamPart               */
+/* Method description: Queues a part on every       */
+/*                     waiting stream, the ones     */
+/*                     still sending skip it. The   */
+/*                     data is not copied.          */
+/*                                                  */
+/* Input params:       pData - Part. (const         */
+/*                     uint8_t*)                    */
+/*                     stLength - Part size.        */
+/*                     (size_t)                     */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::pushStreamPart(const uint8_t *pData, size_t stLength)
+{
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    HttpConnection *pConnection = &hcConnections[iConnection];
+    if (pConnection->iState != HTTP_CONN_STREAMING) continue;
+    if (!isOutputDone(iConnection)) {
+      ulSkippedParts++;
+      continue;
+    }
+    int iHeadLength = snprintf(pConnection->cHead, HTTP_HEAD_BUFFER_SIZE, "%s%u\r\n\r\n",
+                               pConnection->pPartPrefix, (unsigned int)stLength);
+    if (HTTP_HEAD_BUFFER_SIZE <= iHeadLength) iHeadLength = HTTP_HEAD_BUFFER_SIZE - 1;
+    setOutput(iConnection, pConnection->cHead, iHeadLength, pData, stLength,
+              pConnection->pPartTail, strlen(pConnection->pPartTail));
+  }
+}
+
+/****************************************************/
+/* Method name:        endStreams                   */
+/* Method description: Closes every stream, as not  */
+/*                     complete, when no more parts */
+/*                     will come.                   */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::endStreams()
+{
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    if (hcConnections[iConnection].iState == HTTP_CONN_STREAMING) closeConnection(iConnection, false);
+  }
+}
+
+/****************************************************/
+/* Method name:        getStreamCount               */
+/* Method description: Number of open streams.      */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Streams. (int)               */
+/****************************************************/
+int HttpServer::getStreamCount()
+{
+  int iStreams = 0;
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    if (hcConnections[iConnection].iState == HTTP_CONN_STREAMING) iStreams++;
+  }
+  return iStreams;
+}
+
+/****************************************************/
+/* Method name:        getConnectionCount           */
+/* Method description: Number of open connections.  */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Connections. (int)           */
+/****************************************************/
+int HttpServer::getConnectionCount()
+{
+  return iConnectionCount;
+}
+
+/****************************************************/
+/* Method name:        getPeakConnectionCount       */
+/* Method description: Most connections open at the */
+/*                     same time.                   */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Connections. (int)           */
+/****************************************************/
+int HttpServer::getPeakConnectionCount()
+{
+  return iPeakConnectionCount;
+}
+
+/****************************************************/
+/* Method name:        getAcceptedCount             */
+/* Method description: Connections accepted into a  */
+/*                     free slot.                   */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Connections. (unsigned long) */
+/****************************************************/
+unsigned long HttpServer::getAcceptedCount()
+{
+  return ulAccepted;
+}
+
+/****************************************************/
+/* Method name:        getRejectedCount             */
+/* Method description: Connections answered 503     */
+/*                     because all slots were taken.*/
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Connections. (unsigned long) */
+/****************************************************/
+unsigned long HttpServer::getRejectedCount()
+{
+  return ulRejected;
+}
+
+/****************************************************/
+/* Method name:        getSkippedPartCount          */
+/* Method description: Parts a stream did not get   */
+/*                     because it was still sending */
+/*                     the one before.              */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Parts. (unsigned long)       */
+/****************************************************/
+unsigned long HttpServer::getSkippedPartCount()
+{
+  return ulSkippedParts;
+}
+
+/****************************************************/
+/* Method name:        getLastAcceptPollInterval,   */
+/*                     getMaxAcceptPollInterval     */
+/* Method description: Interval between the poll    */
+/*                     that accepted a connection   */
+/*                     and the one before it, or    */
+/*                     begin. It bounds the time the*/
+/*                     connection waited in the     */
+/*                     backlog, it is not measured  */
+/*                     per connection.              */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Time in ms.                  */
+/****************************************************/
+unsigned long HttpServer::getLastAcceptPollInterval()
+{
+  return ulLastAcceptPollIntervalMs;
+}
+
+unsigned long HttpServer::getMaxAcceptPollInterval()
+{
+  return ulMaxAcceptPollIntervalMs;
+}
+
+/****************************************************/
+/* Method name:        getMaxResponseLatency        */
+/* Method description: Longest time from accept to  */
+/*                     the first response byte      */
+/*                     queued.                      */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Time in ms.                  */
+/****************************************************/
+unsigned long HttpServer::getMaxResponseLatency()
+{
+  return ulMaxResponseLatencyMs;
+}
+
+/****************************************************/
+/* Method name:        acceptConnections            */
+/* Method description: Accepts every pending        */
+/*                     connection.                  */
+/*                                                  */
+/* Input params:       ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::acceptConnections(unsigned long ulNowMs)
+{
+  while (true) {
+    int iSocket = accept(iListenSocket, NULL, NULL);
+    if (iSocket < 0) return;
+
+    int iFree = -1;
+    for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+      if (hcConnections[iConnection].iState == HTTP_CONN_FREE) {
+        iFree = iConnection;
+        break;
+      }
+    }
+    if (iFree < 0) {
+      // Best effort, a full send buffer only loses the status line
+      ::send(iSocket, cRejectResponse, sizeof(cRejectResponse) - 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+      close(iSocket);
+      ulRejected++;
+      continue;
+    }
+
+    fcntl(iSocket, F_SETFL, fcntl(iSocket, F_GETFL, 0) | O_NONBLOCK);
+    // Headers and body go in separate sends, Nagle would hold the body for the delayed ACK
+    int iNoDelay = 1;
+    setsockopt(iSocket, IPPROTO_TCP, TCP_NODELAY, &iNoDelay, sizeof(iNoDelay));
+    HttpConnection *pConnection = &hcConnections[iFree];
+    pConnection->iSocket = iSocket;
+    pConnection->iState = HTTP_CONN_READING;
+    pConnection->bKeepAlive = false;
+    pConnection->bResponded = false;
+    pConnection->stRequestLength = 0;
+    pConnection->stSkipBytes = 0;
+    pConnection->fnDone = NULL;
+    pConnection->pMethod = NULL;
+    pConnection->pPath = NULL;
+    pConnection->pQuery = NULL;
+    pConnection->ulAcceptMs = ulNowMs;
+    pConnection->ulActivityMs = ulNowMs;
+    setOutput(iFree, NULL, 0, NULL, 0, NULL, 0);
+
+    ulAccepted++;
+    iConnectionCount++;
+    if (iPeakConnectionCount < iConnectionCount) iPeakConnectionCount = iConnectionCount;
+    ulLastAcceptPollIntervalMs = ulNowMs - ulLastPollMs;
+    if (ulMaxAcceptPollIntervalMs < ulLastAcceptPollIntervalMs) ulMaxAcceptPollIntervalMs = ulLastAcceptPollIntervalMs;
+  }
+}
+
+/****************************************************/
+/* Method name:        readConnection               */
+/* Method description: Reads what the client sent   */
+/*                     and runs the handler of a    */
+/*                     complete request.            */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::readConnection(int iConnection, unsigned long ulNowMs)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  char cDiscard[64];
+
+  while (true) {
+    char *pInto = pConnection->cRequest + pConnection->stRequestLength;
+    size_t stRoom = HTTP_REQUEST_BUFFER_SIZE - pConnection->stRequestLength;
+    // Streams and request bodies are read only to see the client closing
+    if (pConnection->iState == HTTP_CONN_STREAMING || 0 < pConnection->stSkipBytes) {
+      pInto = cDiscard;
+      stRoom = sizeof(cDiscard);
+      if (0 < pConnection->stSkipBytes && pConnection->stSkipBytes < stRoom) stRoom = pConnection->stSkipBytes;
+    }
+    if (stRoom == 0) return;
+
+    int iReceived = recv(pConnection->iSocket, pInto, stRoom, MSG_DONTWAIT);
+    if (iReceived == 0) {
+      closeConnection(iConnection, pConnection->iState == HTTP_CONN_READING);
+      return;
+    }
+    if (iReceived < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(iConnection, false);
+      return;
+    }
+
+    pConnection->ulActivityMs = ulNowMs;
+    if (pInto != cDiscard) pConnection->stRequestLength += iReceived;
+    else if (0 < pConnection->stSkipBytes) pConnection->stSkipBytes -= iReceived;
+  }
+}
+
+/****************************************************/
+/* Method name:        dispatchRequest              */
+/* Method description: Parses the request in the    */
+/*                     buffer, if complete, and     */
+/*                     calls its handler.           */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::dispatchRequest(int iConnection, unsigned long ulNowMs)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  char *pRequest = pConnection->cRequest;
+  pRequest[pConnection->stRequestLength] = '\0';
+
+  char *pHeadersEnd = strstr(pRequest, "\r\n\r\n");
+  if (!pHeadersEnd) {
+    if (pConnection->stRequestLength == HTTP_REQUEST_BUFFER_SIZE) {
+      pConnection->bKeepAlive = false;
+      pConnection->pMethod = NULL;
+      send(iConnection, 431, "text/plain", "");
+    }
+    return;
+  }
+  size_t stConsumed = pHeadersEnd + 4 - pRequest;
+
+  // Request line, split in place
+  char *pLineEnd = strstr(pRequest, "\r\n");
+  *pLineEnd = '\0';
+  char *pHeaders = pLineEnd + 2;
+  char *pPath = strchr(pRequest, ' ');
+  char *pVersion = pPath ? strchr(pPath + 1, ' ') : NULL;
+  if (pPath) *pPath++ = '\0';
+  if (pVersion) *pVersion++ = '\0';
+  char *pQuery = pPath ? strchr(pPath, '?') : NULL;
+  if (pQuery) *pQuery++ = '\0';
+  pConnection->pMethod = pRequest;
+  pConnection->pPath = pPath;
+  pConnection->pQuery = pQuery;
+
+  // HTTP/1.1 keeps the connection unless told otherwise, HTTP/1.0 only when asked
+  const char *pConnectionHeader = findHeader(pHeaders, "Connection");
+  bool bHttp11 = pVersion && strcmp(pVersion, "HTTP/1.1") == 0;
+  if (pConnectionHeader && strncasecmp(pConnectionHeader, "close", 5) == 0) pConnection->bKeepAlive = false;
+  else if (pConnectionHeader && strncasecmp(pConnectionHeader, "keep-alive", 10) == 0) pConnection->bKeepAlive = true;
+  else pConnection->bKeepAlive = bHttp11;
+  const char *pContentLength = findHeader(pHeaders, "Content-Length");
+  size_t stBodyLength = pContentLength ? strtoul(pContentLength, NULL, 10) : 0;
+
+  HttpHandler fnHandler = fnNotFound;
+  if (pPath && strcmp(pRequest, "GET") == 0) {
+    for (int iRoute = 0; iRoute < iRouteCount; iRoute++) {
+      if (strcmp(pPath, cRoutePaths[iRoute]) == 0) {
+        fnHandler = fnRouteHandlers[iRoute];
+        break;
+      }
+    }
+  }
+  if (fnHandler) fnHandler(this, iConnection);
+  if (pConnection->iState == HTTP_CONN_READING) send(iConnection, fnHandler ? 500 : 404, "text/plain", "");
+  if (pConnection->iState == HTTP_CONN_FREE) return;
+  pConnection->pMethod = NULL;
+  pConnection->pPath = NULL;
+  pConnection->pQuery = NULL;
+
+  // Keep what follows the request, dropping its body
+  size_t stBodyInBuffer = pConnection->stRequestLength - stConsumed;
+  if (stBodyLength < stBodyInBuffer) stBodyInBuffer = stBodyLength;
+  stConsumed += stBodyInBuffer;
+  pConnection->stSkipBytes = stBodyLength - stBodyInBuffer;
+  memmove(pRequest, pRequest + stConsumed, pConnection->stRequestLength - stConsumed);
+  pConnection->stRequestLength -= stConsumed;
+
+  if (!pConnection->bResponded) {
+    pConnection->bResponded = true;
+    if (ulMaxResponseLatencyMs < ulNowMs - pConnection->ulAcceptMs) ulMaxResponseLatencyMs = ulNowMs - pConnection->ulAcceptMs;
+  }
+}
+
+/****************************************************/
+/* Method name:        writeConnection              */
+/* Method description: Sends as much of the pending */
+/*                     output as the socket takes.  */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::writeConnection(int iConnection, unsigned long ulNowMs)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+
+  while (!isOutputDone(iConnection)) {
+    int iSegment = pConnection->iOutputSegment;
+    size_t stLeft = pConnection->stOutputLength[iSegment] - pConnection->stOutputSent;
+    if (stLeft == 0) {
+      pConnection->iOutputSegment++;
+      pConnection->stOutputSent = 0;
+      continue;
+    }
+    int iSent = ::send(pConnection->iSocket, pConnection->pOutput[iSegment] + pConnection->stOutputSent,
+                       stLeft, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (iSent < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(iConnection, false);
+      return;
+    }
+    pConnection->stOutputSent += iSent;
+    pConnection->ulActivityMs = ulNowMs;
+  }
+
+  // A sent response either waits for the next request or closes
+  if (pConnection->iState != HTTP_CONN_WRITING) return;
+  HttpDoneCallback fnDone = pConnection->fnDone;
+  pConnection->fnDone = NULL;
+  if (fnDone) fnDone(iConnection, true);
+  if (pConnection->bKeepAlive) pConnection->iState = HTTP_CONN_READING;
+  else closeConnection(iConnection, true);
+}
+
+/****************************************************/
+/* Method name:        setOutput                    */
+/* Method description: Sets the head, body and tail */
+/*                     to be sent.                  */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/*                     pHead, pBody, pTail - Data,  */
+/*                     can be NULL. (const void*)   */
+/*                     stHeadLength, stBodyLength,  */
+/*                     stTailLength - Sizes.        */
+/*                     (size_t)                     */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::setOutput(int iConnection, const void *pHead, size_t stHeadLength, const void *pBody, size_t stBodyLength, const void *pTail, size_t stTailLength)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  pConnection->pOutput[0] = (const uint8_t *)pHead;
+  pConnection->stOutputLength[0] = pHead ? stHeadLength : 0;
+  pConnection->pOutput[1] = (const uint8_t *)pBody;
+  pConnection->stOutputLength[1] = pBody ? stBodyLength : 0;
+  pConnection->pOutput[2] = (const uint8_t *)pTail;
+  pConnection->stOutputLength[2] = pTail ? stTailLength : 0;
+  pConnection->iOutputSegment = 0;
+  pConnection->stOutputSent = 0;
+}
+
+/****************************************************/
+/* Method name:        isOutputDone                 */
+/* Method description: Tells if all the output was  */
+/*                     sent.                        */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/* Output params:      true if sent. (bool)         */
+/****************************************************/
+bool HttpServer::isOutputDone(int iConnection)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  for (int iSegment = pConnection->iOutputSegment; iSegment < HTTP_OUTPUT_SEGMENTS; iSegment++) {
+    size_t stSent = (iSegment == pConnection->iOutputSegment) ? pConnection->stOutputSent : 0;
+    if (stSent < pConnection->stOutputLength[iSegment]) return false;
+  }
+  return true;
+}
+
+/****************************************************/
+/* Method name:        closeConnection              */
+/* Method description: Closes the socket and frees  */
+/*                     the connection.              */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/*                     bComplete - Response was     */
+/*                     fully sent. (bool)           */
+/* Output params:                                   */
+/****************************************************/
+void HttpServer::closeConnection(int iConnection, bool bComplete)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  if (pConnection->iState == HTTP_CONN_FREE) return;
+  HttpDoneCallback fnDone = pConnection->fnDone;
+  pConnection->fnDone = NULL;
+  close(pConnection->iSocket);
+  pConnection->iSocket = -1;
+  pConnection->iState = HTTP_CONN_FREE;
+  iConnectionCount--;
+  if (fnDone) fnDone(iConnection, bComplete);
+}
+
+/****************************************************/
+/* Method name:        isValidResponder             */
+/* Method description: Tells if a handler may still */
+/*                     answer on the connection.    */
+/*                                                  */
+/* Input params:       iConnection - Connection.    */
+/*                     (int)                        */
+/* Output params:      true if it may. (bool)       */
+/****************************************************/
+bool HttpServer::isValidResponder(int iConnection)
+{
+  if (iConnection < 0 || HTTP_MAX_CONNECTIONS <= iConnection) return false;
+  return hcConnections[iConnection].iState == HTTP_CONN_READING;
+}
@@ -0,0 +1,501 @@
+/**************************************************/
+/* File name:        HttpServer.h                 */
+/* File description: Header File for the          */
+/*                   HttpServer Class, a non      */
+/*                   blocking HTTP server over    */
+/*                   lwIP sockets that serves many*/
+/*                   connections from the main    */
+/*                   loop.                        */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef HttpServer_h
+#define HttpServer_h
+#include <stddef.h>
+#include <stdint.h>
+
+// Defines
+#ifndef HTTP_MAX_CONNECTIONS
+#define HTTP_MAX_CONNECTIONS             8    // Bounded by the lwIP socket count
+#endif
+#define HTTP_MAX_ROUTES                  8
+#ifndef HTTP_LISTEN_BACKLOG
+#define HTTP_LISTEN_BACKLOG              4    // Connections waiting between polls
+#endif
+#define HTTP_REQUEST_BUFFER_SIZE         512  // Request line and headers
+#define HTTP_HEAD_BUFFER_SIZE            192  // Response or stream part header
+#define HTTP_RESPONSE_BUFFER_SIZE        1024 // Text responses, longer ones are cut
+#define HTTP_IDLE_TIMEOUT_MS             5000 // Waiting for a request, also keep alive
+#define HTTP_SEND_TIMEOUT_MS             3000 // Without any send progress
+#define HTTP_OUTPUT_SEGMENTS             3    // Head, body and tail
+
+#define HTTP_CONN_FREE                   0
+#define HTTP_CONN_READING                1    // Waiting for a whole request
+#define HTTP_CONN_WRITING                2    // Sending a response
+#define HTTP_CONN_STREAMING              3    // Sending parts as they are pushed
+
+class HttpServer;
+
+// Request handler, must answer with send, sendData or beginStream
+typedef void (*HttpHandler)(HttpServer *pServer, int iConnection);
+// Called once when a response is sent or its connection is lost
+typedef void (*HttpDoneCallback)(int iConnection, bool bComplete);
+
+/****************************************************/
+/* Struct name:       HttpConnection                */
+/* Struct description: State and fixed buffers of   */
+/*                    one client connection.        */
+/****************************************************/
+struct HttpConnection
+{
+  int iSocket;
+  int iState;
+  bool bKeepAlive;
+  bool bResponded;
+  char cRequest[HTTP_REQUEST_BUFFER_SIZE + 1];
+  size_t stRequestLength;
+  size_t stSkipBytes;
+  const char *pMethod;
+  const char *pPath;
+  const char *pQuery;
+  char cHead[HTTP_HEAD_BUFFER_SIZE];
+  char cBody[HTTP_RESPONSE_BUFFER_SIZE];
+  const uint8_t *pOutput[HTTP_OUTPUT_SEGMENTS];
+  size_t stOutputLength[HTTP_OUTPUT_SEGMENTS];
+  int iOutputSegment;
+  size_t stOutputSent;
+  const char *pPartPrefix;
+  const char *pPartTail;
+  HttpDoneCallback fnDone;
+  unsigned long ulAcceptMs;
+  unsigned long ulActivityMs;
+};
+
+/****************************************************/
+/* Class name:        HttpServer                    */
+/* Class description: Class that accepts, reads and */
+/*                    writes all of its connections */
+/*                    without blocking, each time   */
+/*                    poll is called. Every         */
+/*                    connection has fixed buffers, */
+/*                    connections past the limit are*/
+/*                    answered 503 and closed.      */
+/*                    Streams are multipart         */
+/*                    responses, a part is pushed to*/
+/*                    the streams that sent their   */
+/*                    last one, the others skip it, */
+/*                    so a slow client only slows   */
+/*                    itself. A part must stay valid*/
+/*                    while isPartInUse tells so.   */
+/****************************************************/
+class HttpServer
+{
+  private:
+    // Private Variables:
+    int iListenSocket;
+    HttpConnection hcConnections[HTTP_MAX_CONNECTIONS];
+    const char *cRoutePaths[HTTP_MAX_ROUTES];
+    HttpHandler fnRouteHandlers[HTTP_MAX_ROUTES];
+    int iRouteCount;
+    HttpHandler fnNotFound;
+    int iConnectionCount;
+    int iPeakConnectionCount;
+    unsigned long ulAccepted;
+    unsigned long ulRejected;
+    unsigned long ulSkippedParts;
+    unsigned long ulLastPollMs;
+    unsigned long ulLastAcceptPollIntervalMs;
+    unsigned long ulMaxAcceptPollIntervalMs;
+    unsigned long ulMaxResponseLatencyMs;
+
+    /****************************************************/
+    /* Method name:        acceptConnections            */
+    /* Method description: Accepts every pending        */
+    /*                     connection.                  */
+    /*                                                  */
+    /* Input params:       ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void acceptConnections(unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        readConnection               */
+    /* Method description: Reads what the client sent   */
+    /*                     and runs the handler of a    */
+    /*                     complete request.            */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void readConnection(int iConnection, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        dispatchRequest              */
+    /* Method description: Parses the request in the    */
+    /*                     buffer, if complete, and     */
+    /*                     calls its handler.           */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void dispatchRequest(int iConnection, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        writeConnection              */
+    /* Method description: Sends as much of the pending */
+    /*                     output as the socket takes.  */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void writeConnection(int iConnection, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        setOutput                    */
+    /* Method description: Sets the head, body and tail */
+    /*                     to be sent.                  */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /*                     pHead, pBody, pTail - Data,  */
+    /*                     can be NULL. (const void*)   */
+    /*                     stHeadLength, stBodyLength,  */
+    /*                     stTailLength - Sizes.        */
+    /*                     (size_t)                     */
+    /* Output params:                                   */
+    /****************************************************/
+    void setOutput(int iConnection, const void *pHead, size_t stHeadLength, const void *pBody, size_t stBodyLength, const void *pTail, size_t stTailLength);
+
+    /****************************************************/
+    /* Method name:        isOutputDone                 */
+    /* Method description: Tells if all the output was  */
+    /*                     sent.                        */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /* Output params:      true if sent. (bool)         */
+    /****************************************************/
+    bool isOutputDone(int iConnection);
+
+    /****************************************************/
+    /* Method name:        closeConnection              */
+    /* Method description: Closes the socket and frees  */
+    /*                     the connection.              */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /*                     bComplete - Response was     */
+    /*                     fully sent. (bool)           */
+    /* Output params:                                   */
+    /****************************************************/
+    void closeConnection(int iConnection, bool bComplete);
+
+    /****************************************************/
+    /* Method name:        isValidResponder             */
+    /* Method description: Tells if a handler may still */
+    /*                     answer on the connection.    */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /* Output params:      true if it may. (bool)       */
+    /****************************************************/
+    bool isValidResponder(int iConnection);
+
+  public:
+
+    /****************************************************/
+    /* Creator name:       HttpServer                   */
+    /* Method description: Class Object creator         */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    HttpServer();
+
+    /****************************************************/
+    /* Method name:        on                           */
+    /* Method description: Adds a handler for GET       */
+    /*                     requests to a path.          */
+    /*                                                  */
+    /* Input params:       cPath - Path without query.  */
+    /*                     (const char*)                */
+    /*                     fnHandler - Handler.         */
+    /*                     (HttpHandler)                */
+    /* Output params:      false if the table is full.  */
+    /*                     (bool)                       */
+    /****************************************************/
+    bool on(const char *cPath, HttpHandler fnHandler);
+
+    /****************************************************/
+    /* Method name:        onNotFound                   */
+    /* Method description: Sets the handler of every    */
+    /*                     other request.               */
+    /*                                                  */
+    /* Input params:       fnHandler - Handler.         */
+    /*                     (HttpHandler)                */
+    /* Output params:                                   */
+    /****************************************************/
+    void onNotFound(HttpHandler fnHandler);
+
+    /****************************************************/
+    /* Method name:        begin                        */
+    /* Method description: Starts listening.            */
+    /*                                                  */
+    /* Input params:       ui16Port - TCP port.         */
+    /*                     (uint16_t)                   */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      true if listening. (bool)    */
+    /****************************************************/
+    bool begin(uint16_t ui16Port, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        poll                         */
+    /* Method description: Runs accept, read and write  */
+    /*                     on every connection once,    */
+    /*                     never blocking. Must be      */
+    /*                     called from the main loop.   */
+    /*                                                  */
+    /* Input params:       ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void poll(unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        getMethod, getPath, getQuery */
+    /* Method description: Parts of the request being   */
+    /*                     handled, valid only inside   */
+    /*                     the handler.                 */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /* Output params:      Text, empty if missing.      */
+    /*                     (const char*)                */
+    /****************************************************/
+    const char *getMethod(int iConnection);
+    const char *getPath(int iConnection);
+    const char *getQuery(int iConnection);
+
+    /****************************************************/
+    /* Method name:        getArgCount                  */
+    /* Method description: Number of query arguments of */
+    /*                     the request being handled.   */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /* Output params:      Arguments. (int)             */
+    /****************************************************/
+    int getArgCount(int iConnection);
+
+    /****************************************************/
+    /* Method name:        send                         */
+    /* Method description: Answers with a copy of a text*/
+    /*                     body, cut at the response    */
+    /*                     buffer size.                 */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /*                     iCode - HTTP status. (int)   */
+    /*                     cContentType - Content type. */
+    /*                     (const char*)                */
+    /*                     cText - Body. (const char*)  */
+    /* Output params:                                   */
+    /****************************************************/
+    void send(int iConnection, int iCode, const char *cContentType, const char *cText);
+
+    /****************************************************/
+    /* Method name:        sendData                     */
+    /* Method description: Answers with a body that is  */
+    /*                     not copied, it must stay     */
+    /*                     valid until fnDone is called.*/
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /*                     iCode - HTTP status. (int)   */
+    /*                     cContentType - Content type. */
+    /*                     (const char*)                */
+    /*                     pData - Body. (const         */
+    /*                     uint8_t*)                    */
+    /*                     stLength - Body size.        */
+    /*                     (size_t)                     */
+    /*                     fnDone - Callback, can be    */
+    /*                     NULL. (HttpDoneCallback)     */
+    /* Output params:                                   */
+    /****************************************************/
+    void sendData(int iConnection, int iCode, const char *cContentType, const uint8_t *pData, size_t stLength, HttpDoneCallback fnDone);
+
+    /****************************************************/
+    /* Method name:        beginStream                  */
+    /* Method description: Turns the connection into a  */
+    /*                     stream that receives every   */
+    /*                     pushed part. All the strings */
+    /*                     must stay valid.             */
+    /*                                                  */
+    /* Input params:       iConnection - Connection.    */
+    /*                     (int)                        */
+    /*                     cResponseHead - Status line  */
+    /*                     and headers. (const char*)   */
+    /*                     cPartPrefix - Written before */
+    /*                     the part size of each part.  */
+    /*                     (const char*)                */
+    /*                     cPartTail - Written after    */
+    /*                     the head and each part.      */
+    /*                     (const char*)                */
+    /*                     fnDone - Called when the     */
+    /*                     stream closes, can be NULL.  */
+    /*                     (HttpDoneCallback)           */
+    /* Output params:                                   */
+    /****************************************************/
+    void beginStream(int iConnection, const char *cResponseHead, const char *cPartPrefix, const char *cPartTail, HttpDoneCallback fnDone);
+
+    /****************************************************/
+    /* Method name:        isStreamWaiting              */
+    /* Method description: Tells if a stream sent its   */
+    /*                     last part and waits for the  */
+    /*                     next one.                    */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      true if waiting. (bool)      */
+    /****************************************************/
+    bool isStreamWaiting();
+
+    /****************************************************/
+    /* Method name:        isPartInUse                  */
+    /* Method description: Tells if a stream is still   */
+    /*                     sending a part, so it can not*/
+    /*                     be released or overwritten.  */
+    /*                                                  */
+    /* Input params:       pData - Part. (const         */
+    /*                     uint8_t*)                    */
+    /* Output params:      true if in use. (bool)       */
+    /****************************************************/
+    bool isPartInUse(const uint8_t *pData);
+
+    /****************************************************/
+    /* Method name:        pushStreamPart               */
+    /* Method description: Queues a part on every       */
+    /*                     waiting stream, the ones     */
+    /*                     still sending skip it. The   */
+    /*                     data is not copied.          */
+    /*                                                  */
+    /* Input params:       pData - Part. (const         */
+    /*                     uint8_t*)                    */
+    /*                     stLength - Part size.        */
+    /*                     (size_t)                     */
+    /* Output params:                                   */
+    /****************************************************/
+    void pushStreamPart(const uint8_t *pData, size_t stLength);
+
+    /****************************************************/
+    /* Method name:        endStreams                   */
+    /* Method description: Closes every stream, as not  */
+    /*                     complete, when no more parts */
+    /*                     will come.                   */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    void endStreams();
+
+    /****************************************************/
+    /* Method name:        getStreamCount               */
+    /* Method description: Number of open streams.      */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Streams. (int)               */
+    /****************************************************/
+    int getStreamCount();
+
+    /****************************************************/
+    /* Method name:        getConnectionCount           */
+    /* Method description: Number of open connections.  */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Connections. (int)           */
+    /****************************************************/
+    int getConnectionCount();
+
+    /****************************************************/
+    /* Method name:        getPeakConnectionCount       */
+    /* Method description: Most connections open at the */
+    /*                     same time.                   */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Connections. (int)           */
+    /****************************************************/
+    int getPeakConnectionCount();
+
+    /****************************************************/
+    /* Method name:        getAcceptedCount             */
+    /* Method description: Connections accepted into a  */
+    /*                     free slot.                   */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Connections. (unsigned long) */
+    /****************************************************/
+    unsigned long getAcceptedCount();
+
+    /****************************************************/
+    /* Method name:        getRejectedCount             */
+    /* Method description: Connections answered 503     */
+    /*                     because all slots were taken.*/
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Connections. (unsigned long) */
+    /****************************************************/
+    unsigned long getRejectedCount();
+
+    /****************************************************/
+    /* Method name:        getSkippedPartCount          */
+    /* Method description: Parts a stream did not get   */
+    /*                     because it was still sending */
+    /*                     the one before.              */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Parts. (unsigned long)       */
+    /****************************************************/
+    unsigned long getSkippedPartCount();
+
+    /****************************************************/
+    /* Method name:        getLastAcceptPollInterval,   */
+    /*                     getMaxAcceptPollInterval     */
+    /* Method description: Interval between the poll    */
+    /*                     that accepted a connection   */
+    /*                     and the one before it, or    */
+    /*                     begin. It bounds the time the*/
+    /*                     connection waited in the     */
+    /*                     backlog, it is not measured  */
+    /*                     per connection.              */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Time in ms.                  */
+    /****************************************************/
+    unsigned long getLastAcceptPollInterval();
+    unsigned long getMaxAcceptPollInterval();
+
+    /****************************************************/
+    /* Method name:        getMaxResponseLatency        */
+    /* Method description: Longest time from accept to  */
+    /*                     the first response byte      */
+    /*                     queued.                      */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Time in ms.                  */
+    /****************************************************/
+    unsigned long getMaxResponseLatency();
+};
+
+#endif
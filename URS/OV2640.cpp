@@ -10,7 +10,7 @@
 /*                                                */
 /* Author name:      Sachin Soni                  */
 /* Creation date:    20/11/2020                   */
-/* Revision date:    18/12/2020                   */
+/* Revision date:    19/10/2026                   */
 /**************************************************/
 #include "OV2640.h"
 
@@ -117,6 +117,13 @@ camera_config_t esp32cam_ttgo_t_config{
 
 void OV2640::run(void)
 {
+  // a grab left by runFor is the next frame
+  if (_grab_pending)
+  {
+    collectGrab(portMAX_DELAY);
+    return;
+  }
+
   if (fb)
     //return the frame buffer back to the driver for reuse
     esp_camera_fb_return(fb);
@@ -124,6 +131,60 @@ void OV2640::run(void)
   fb = esp_camera_fb_get();
 }
 
+bool OV2640::runFor(unsigned long timeout_ms)
+{
+  // esp_camera_fb_get blocks up to the driver timeout (4 s), so the grab
+  // runs in its own task and only the wait for it is bounded
+  if (!_grab_queue)
+  {
+    _grab_queue = xQueueCreate(1, sizeof(camera_fb_t *));
+    if (!_grab_queue)
+      return false;
+    if (xTaskCreatePinnedToCore(grabTask, "ov2640_grab", OV2640_GRAB_TASK_STACK, this, OV2640_GRAB_TASK_PRIORITY, &_grab_task, 1) != pdPASS)
+    {
+      vQueueDelete(_grab_queue);
+      _grab_queue = NULL;
+      return false;
+    }
+  }
+
+  if (!_grab_pending)
+  {
+    if (fb)
+    {
+      esp_camera_fb_return(fb);
+      fb = NULL;
+    }
+    _grab_pending = true;
+    xTaskNotifyGive(_grab_task);
+  }
+
+  return collectGrab(pdMS_TO_TICKS(timeout_ms));
+}
+
+bool OV2640::collectGrab(TickType_t wait_ticks)
+{
+  camera_fb_t *grabbed;
+
+  if (xQueueReceive(_grab_queue, &grabbed, wait_ticks) != pdTRUE)
+    return false;
+  _grab_pending = false;
+  fb = grabbed;
+  return fb != NULL;
+}
+
+void OV2640::grabTask(void *param)
+{
+  OV2640 *cam = (OV2640 *)param;
+
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    camera_fb_t *grabbed = esp_camera_fb_get();
+    xQueueSend(cam->_grab_queue, &grabbed, portMAX_DELAY);
+  }
+}
+
 void OV2640::runIfNeeded(void)
 {
   if (!fb)
@@ -190,6 +251,27 @@ void OV2640::setPixelFormat(pixformat_t format)
   }
 }
 
+int OV2640::getXclkFrequency(void)
+{
+  return _cam_config.xclk_freq_hz;
+}
+
+void OV2640::setXclkFrequency(int freq_hz)
+{
+  _cam_config.xclk_freq_hz = freq_hz;
+}
+
+size_t OV2640::getFrameBufferCount(void)
+{
+  return _cam_config.fb_count;
+}
+
+void OV2640::setFrameBufferCount(size_t count)
+{
+  // a single buffer makes the driver capture on demand instead of continuously
+  _cam_config.fb_count = count < 1 ? 1 : count;
+}
+
 esp_err_t OV2640::init(camera_config_t config)
 {
   memset(&_cam_config, 0, sizeof(_cam_config));
@@ -205,3 +287,44 @@ esp_err_t OV2640::init(camera_config_t config)
 
   return ESP_OK;
 }
+
+esp_err_t OV2640::reinit(void)
+{
+  esp_err_t err = esp_camera_init(&_cam_config);
+  if (err != ESP_OK)
+  {
+    printf("Camera probe failed with error 0x%x", err);
+    return err;
+  }
+
+  return ESP_OK;
+}
+
+esp_err_t OV2640::deinit(unsigned long timeout_ms)
+{
+  // the driver must not be stopped under a grab, it ends by the driver
+  // timeout (4 s) at the latest and a later call stops it then
+  if (_grab_pending)
+  {
+    collectGrab(pdMS_TO_TICKS(timeout_ms));
+    if (_grab_pending)
+      return ESP_ERR_TIMEOUT;
+  }
+
+  if (fb)
+  {
+    esp_camera_fb_return(fb);
+    fb = NULL;
+  }
+
+  esp_err_t err = esp_camera_deinit();
+
+  // the driver leaves the sensor powered, esp_camera_init drives it low again
+  if (_cam_config.pin_pwdn >= 0)
+  {
+    pinMode(_cam_config.pin_pwdn, OUTPUT);
+    digitalWrite(_cam_config.pin_pwdn, HIGH);
+  }
+
+  return err;
+}
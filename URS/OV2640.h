@@ -10,7 +10,7 @@
 /*                                                */
 /* Author name:      Sachin Soni                  */
 /* Creation date:    20/11/2020                   */
-/* Revision date:    18/12/2020                   */
+/* Revision date:    19/10/2026                   */
 /**************************************************/
 #ifndef OV2640_H_
 #define OV2640_H_
@@ -21,6 +21,12 @@
 #include "esp_log.h"
 #include "esp_attr.h"
 #include "esp_camera.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#define OV2640_GRAB_TASK_STACK 2048
+#define OV2640_GRAB_TASK_PRIORITY 2
 
 extern camera_config_t esp32cam_config, esp32cam_aithinker_config, esp32cam_ttgo_t_config;
 
@@ -29,11 +35,21 @@ class OV2640
   public:
     OV2640() {
       fb = NULL;
+      _grab_task = NULL;
+      _grab_queue = NULL;
+      _grab_pending = false;
     };
     ~OV2640() {
     };
     esp_err_t init(camera_config_t config);
+    esp_err_t reinit(void); // init again with the last configuration
+    // stop the capture and power down the sensor; a grab in flight is waited
+    // for at most timeout_ms, then ESP_ERR_TIMEOUT leaves the camera running
+    esp_err_t deinit(unsigned long timeout_ms);
     void run(void);
+    // run, but wait at most timeout_ms; on false the frame is still being
+    // grabbed and the next call picks it up, 0 only polls
+    bool runFor(unsigned long timeout_ms);
     size_t getSize(void);
     uint8_t *getfb(void);
     int getWidth(void);
@@ -44,14 +60,25 @@ class OV2640
     void setFrameSize(framesize_t size);
     void setPixelFormat(pixformat_t format);
 
+    // applied on the next reinit
+    int getXclkFrequency(void);
+    void setXclkFrequency(int freq_hz);
+    size_t getFrameBufferCount(void);
+    void setFrameBufferCount(size_t count);
+
   private:
     void runIfNeeded(); // grab a frame if we don't already have one
+    static void grabTask(void *param); // esp_camera_fb_get off the caller's task
+    bool collectGrab(TickType_t wait_ticks); // take a pending grab
 
     // camera_framesize_t _frame_size;
     // camera_pixelformat_t _pixel_format;
     camera_config_t _cam_config;
 
     camera_fb_t *fb;
+    TaskHandle_t _grab_task;
+    QueueHandle_t _grab_queue;
+    bool _grab_pending;
 };
 
 #endif //OV2640_H_
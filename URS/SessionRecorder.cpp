@@ -0,0 +1,365 @@
+/**************************************************/
+/* File name:        SessionRecorder.cpp          */
+/* File description: File for the implementation  */
+/*                   of SessionRecorder Class,    */
+/*                   that records the inputs of a */
+/*                   session so it can be replayed*/
+/*                   later.                       */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include "SessionRecorder.h"
+
+/****************************************************/
+/* Creator name:       SessionRecorder              */
+/* Method description: Class Object creator, the    */
+/*                     recorder drops every record  */
+/*                     until begin is called.       */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+SessionRecorder::SessionRecorder()
+{
+  bHeld = false;
+  begin(NULL, 0, 0);
+}
+
+/****************************************************/
+/* Method name:        begin                        */
+/* Method description: Sets the record buffer.      */
+/*                                                  */
+/* Input params:       pRecordBuffer - Buffer, NULL */
+/*                     disables the recording.      */
+/*                     (uint8_t*)                   */
+/*                     stRecordBufferSize - Buffer  */
+/*                     size. (size_t)               */
+/*                     iFrameContentPeriod - One in */
+/*                     how many frames also has its */
+/*                     contents recorded, 0 records */
+/*                     sizes only. (int)            */
+/* Output params:                                   */
+/****************************************************/
+void SessionRecorder::begin(uint8_t *pRecordBuffer, size_t stRecordBufferSize, int iFrameContentPeriod)
+{
+  pBuffer = pRecordBuffer;
+  stSize = pRecordBuffer ? stRecordBufferSize : 0;
+  iFrameContentEvery = iFrameContentPeriod;
+  clear();
+}
+
+/****************************************************/
+/* Method name:        clear                        */
+/* Method description: Empties the buffer, the next */
+/*                     record holds the time since  */
+/*                     boot.                        */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void SessionRecorder::clear()
+{
+  stLength = 0;
+  ulLastRecordMs = 0;
+  ulDroppedRecords = 0;
+  iFramesToContent = 0;
+  if (stSize < SESSION_HEADER_SIZE) return;
+  memcpy(pBuffer, SESSION_MAGIC, SESSION_HEADER_SIZE - 1);
+  pBuffer[SESSION_HEADER_SIZE - 1] = SESSION_VERSION;
+  stLength = SESSION_HEADER_SIZE;
+}
+
+/****************************************************/
+/* Method name:        consume                      */
+/* Method description: Drops the first bytes of the */
+/*                     buffer, as sent by a         */
+/*                     download, and keeps what was */
+/*                     recorded after them. The kept*/
+/*                     first record gets its time   */
+/*                     since boot, so the buffer is */
+/*                     again a whole session.       */
+/*                                                  */
+/* Input params:       stConsumed - Bytes from the  */
+/*                     start, must end at a record. */
+/*                     (size_t)                     */
+/* Output params:      false if it does not end at a*/
+/*                     record, nothing is dropped.  */
+/*                     (bool)                       */
+/****************************************************/
+bool SessionRecorder::consume(size_t stConsumed)
+{
+  size_t stOffset = SESSION_HEADER_SIZE;
+  unsigned long ulConsumedMs = 0;
+  uint8_t ui8Time[SESSION_VARINT_MAX_SIZE];
+  size_t stTimeLength = 0;
+
+  if (stConsumed < SESSION_HEADER_SIZE || stLength < stConsumed) return false;
+  // Time of the last dropped record, the base of the first kept one
+  while (stOffset < stConsumed) {
+    stOffset++;
+    ulConsumedMs += getVarint(&stOffset);
+    stOffset += getVarint(&stOffset);
+  }
+  if (stOffset != stConsumed) return false;
+  ulDroppedRecords = 0;
+  if (stConsumed == stLength) {
+    clear();
+    return true;
+  }
+
+  uint8_t ui8Type = pBuffer[stOffset++];
+  unsigned long ulValue = ulConsumedMs + getVarint(&stOffset);
+  do {
+    ui8Time[stTimeLength] = ulValue & 0x7F;
+    ulValue >>= 7;
+    if (ulValue) ui8Time[stTimeLength] |= 0x80;
+    stTimeLength++;
+  } while (ulValue && stTimeLength < SESSION_VARINT_MAX_SIZE);
+
+  // The kept records move down behind the header and the new time
+  size_t stKeep = stLength - stOffset;
+  size_t stKeepAt = SESSION_HEADER_SIZE + 1 + stTimeLength;
+  if (stSize < stKeepAt + stKeep) {
+    // Only if a longer time does not fit, the record is lost
+    stOffset += getVarint(&stOffset);
+    bool bKept = consume(stOffset);
+    ulDroppedRecords++;
+    return bKept;
+  }
+  memmove(pBuffer + stKeepAt, pBuffer + stOffset, stKeep);
+  pBuffer[SESSION_HEADER_SIZE] = ui8Type;
+  memcpy(pBuffer + SESSION_HEADER_SIZE + 1, ui8Time, stTimeLength);
+  stLength = stKeepAt + stKeep;
+  return true;
+}
+
+/****************************************************/
+/* Method name:        hold                         */
+/* Method description: Keeps the recorded bytes in  */
+/*                     place while a download sends */
+/*                     them from the buffer. Frame  */
+/*                     contents then leave a part of*/
+/*                     it to the other records.     */
+/*                                                  */
+/* Input params:       bHold - Held. (bool)         */
+/* Output params:                                   */
+/****************************************************/
+void SessionRecorder::hold(bool bHold)
+{
+  bHeld = bHold;
+}
+
+/****************************************************/
+/* Method name:        recordText                   */
+/* Method description: Records a text payload.      */
+/*                                                  */
+/* Input params:       ui8Type - Record type.       */
+/*                     (uint8_t)                    */
+/*                     cText - Text. (const char*)  */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      true if recorded. (bool)     */
+/****************************************************/
+bool SessionRecorder::recordText(uint8_t ui8Type, const char *cText, unsigned long ulNowMs)
+{
+  return writeRecord(ui8Type, ulNowMs, (const uint8_t *)cText, strlen(cText));
+}
+
+/****************************************************/
+/* Method name:        recordValue                  */
+/* Method description: Records a varint payload.    */
+/*                                                  */
+/* Input params:       ui8Type - Record type.       */
+/*                     (uint8_t)                    */
+/*                     ulValue - Value.             */
+/*                     (unsigned long)              */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      true if recorded. (bool)     */
+/****************************************************/
+bool SessionRecorder::recordValue(uint8_t ui8Type, unsigned long ulValue, unsigned long ulNowMs)
+{
+  uint8_t ui8Varint[SESSION_VARINT_MAX_SIZE];
+  size_t stVarintLength = 0;
+  do {
+    ui8Varint[stVarintLength] = ulValue & 0x7F;
+    ulValue >>= 7;
+    if (ulValue) ui8Varint[stVarintLength] |= 0x80;
+    stVarintLength++;
+  } while (ulValue && stVarintLength < SESSION_VARINT_MAX_SIZE);
+  return writeRecord(ui8Type, ulNowMs, ui8Varint, stVarintLength);
+}
+
+/****************************************************/
+/* Method name:        recordFrame                  */
+/* Method description: Records the size of a frame  */
+/*                     and, once every content      */
+/*                     period, its contents.        */
+/*                                                  */
+/* Input params:       pJpeg - Frame. (const        */
+/*                     uint8_t*)                    */
+/*                     stJpegLength - Frame size.   */
+/*                     (size_t)                     */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      true if recorded. (bool)     */
+/****************************************************/
+bool SessionRecorder::recordFrame(const uint8_t *pJpeg, size_t stJpegLength, unsigned long ulNowMs)
+{
+  if (!recordValue(SESSION_RECORD_FRAME_SIZE, stJpegLength, ulNowMs)) return false;
+  if (iFrameContentEvery <= 0 || !pJpeg) return true;
+  if (0 < iFramesToContent--) return true;
+  iFramesToContent = iFrameContentEvery - 1;
+  return writeRecord(SESSION_RECORD_FRAME, ulNowMs, pJpeg, stJpegLength);
+}
+
+/****************************************************/
+/* Method name:        getData                      */
+/* Method description: Recorded bytes.              */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Buffer. (const uint8_t*)     */
+/****************************************************/
+const uint8_t *SessionRecorder::getData()
+{
+  return pBuffer;
+}
+
+/****************************************************/
+/* Method name:        getLength                    */
+/* Method description: Number of recorded bytes.    */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Length. (size_t)             */
+/****************************************************/
+size_t SessionRecorder::getLength()
+{
+  return stLength;
+}
+
+/****************************************************/
+/* Method name:        getDroppedRecords            */
+/* Method description: Records lost since the last  */
+/*                     clear or consume for lack of */
+/*                     space, the oldest dropped    */
+/*                     ones included.               */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Records. (unsigned long)     */
+/****************************************************/
+unsigned long SessionRecorder::getDroppedRecords()
+{
+  return ulDroppedRecords;
+}
+
+/****************************************************/
+/* Method name:        putVarint                    */
+/* Method description: Writes a varint at the end of*/
+/*                     the buffer, space must be    */
+/*                     checked by the caller.       */
+/*                                                  */
+/* Input params:       ulValue - Value to write.    */
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void SessionRecorder::putVarint(unsigned long ulValue)
+{
+  while (0x7F < ulValue) {
+    pBuffer[stLength++] = (ulValue & 0x7F) | 0x80;
+    ulValue >>= 7;
+  }
+  pBuffer[stLength++] = ulValue;
+}
+
+/****************************************************/
+/* Method name:        getVarint                    */
+/* Method description: Reads a varint of the buffer.*/
+/*                                                  */
+/* Input params:       pOffset - Where it starts,   */
+/*                     moved past it. (size_t*)     */
+/* Output params:      Value. (unsigned long)       */
+/****************************************************/
+unsigned long SessionRecorder::getVarint(size_t *pOffset)
+{
+  unsigned long ulValue = 0;
+  int iShift = 0;
+  while (*pOffset < stLength) {
+    uint8_t ui8Byte = pBuffer[(*pOffset)++];
+    ulValue |= (unsigned long)(ui8Byte & 0x7F) << iShift;
+    iShift += 7;
+    if (!(ui8Byte & 0x80) || 7 * SESSION_VARINT_MAX_SIZE <= iShift) break;
+  }
+  return ulValue;
+}
+
+/****************************************************/
+/* Method name:        dropOldest                   */
+/* Method description: Drops the oldest records     */
+/*                     until there is room for a    */
+/*                     record and a part of the     */
+/*                     buffer more, so the next ones*/
+/*                     do not move it again.        */
+/*                                                  */
+/* Input params:       stNeeded - Room for the      */
+/*                     record. (size_t)             */
+/* Output params:                                   */
+/****************************************************/
+void SessionRecorder::dropOldest(size_t stNeeded)
+{
+  size_t stWanted = stNeeded + stSize / SESSION_DROP_PART;
+  size_t stOffset = SESSION_HEADER_SIZE;
+  unsigned long ulDropped = ulDroppedRecords;
+
+  while (stOffset < stLength && stSize - stLength + (stOffset - SESSION_HEADER_SIZE) < stWanted) {
+    stOffset++;
+    getVarint(&stOffset);
+    stOffset += getVarint(&stOffset);
+    ulDropped++;
+  }
+  // Dropping them as a download would keeps the first time since boot
+  consume(stOffset);
+  ulDroppedRecords += ulDropped;
+}
+
+/****************************************************/
+/* Method name:        writeRecord                  */
+/* Method description: Appends a whole record or    */
+/*                     nothing, dropping the oldest */
+/*                     ones for room unless held.   */
+/*                                                  */
+/* Input params:       ui8Type - Record type.       */
+/*                     (uint8_t)                    */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/*                     pPayload - Payload bytes.    */
+/*                     (const uint8_t*)             */
+/*                     stPayloadLength - Payload    */
+/*                     size. (size_t)               */
+/* Output params:      true if recorded. (bool)     */
+/****************************************************/
+bool SessionRecorder::writeRecord(uint8_t ui8Type, unsigned long ulNowMs, const uint8_t *pPayload, size_t stPayloadLength)
+{
+  // Worst case of the type, time and length fields
+  size_t stRecordLength = 1 + 2 * SESSION_VARINT_MAX_SIZE + stPayloadLength;
+  size_t stNeeded = stRecordLength;
+  // Held bytes can not move, the control and sonar records keep a part of the room
+  if (bHeld && ui8Type == SESSION_RECORD_FRAME) stNeeded += stSize / SESSION_RESERVE_PART;
+  if (stSize < SESSION_HEADER_SIZE || stSize - SESSION_HEADER_SIZE < stNeeded) {
+    ulDroppedRecords++;
+    return false;
+  }
+  if (stSize - stLength < stNeeded && !bHeld) dropOldest(stNeeded);
+  if (stSize - stLength < stNeeded) {
+    ulDroppedRecords++;
+    return false;
+  }
+  pBuffer[stLength++] = ui8Type;
+  putVarint(ulNowMs - ulLastRecordMs);
+  putVarint(stPayloadLength);
+  memcpy(pBuffer + stLength, pPayload, stPayloadLength);
+  stLength += stPayloadLength;
+  ulLastRecordMs = ulNowMs;
+  return true;
+}
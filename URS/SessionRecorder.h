@@ -0,0 +1,265 @@
+/**************************************************/
+/* File name:        SessionRecorder.h            */
+/* File description: Header File for the          */
+/*                   SessionRecorder Class, that  */
+/*                   records the inputs of a      */
+/*                   session so it can be replayed*/
+/*                   later.                       */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef SessionRecorder_h
+#define SessionRecorder_h
+#include "Arduino.h"
+
+// Defines
+#define SESSION_MAGIC                    "URSR"
+#define SESSION_VERSION                  1
+#define SESSION_HEADER_SIZE              5   // Magic and version
+#define SESSION_RECORD_PANTILT           1   // Pan Tilt HTTP payload, text
+#define SESSION_RECORD_MOVEMENT          2   // Movement HTTP payload, text
+#define SESSION_RECORD_SONAR             3   // Sonar echo duration in us, varint
+#define SESSION_RECORD_FRAME_SIZE        4   // JPEG frame size in bytes, varint
+#define SESSION_RECORD_FRAME             5   // JPEG frame contents
+#define SESSION_VARINT_MAX_SIZE          5   // 32 bit value in 7 bit groups
+#define SESSION_DROP_PART                8   // Part of the buffer freed at once when full
+#define SESSION_RESERVE_PART             16  // Part kept from frame contents while held
+
+/****************************************************/
+/* Class name:        SessionRecorder               */
+/* Class description: Class that appends timestamped*/
+/*                    records of the hardware and   */
+/*                    cloud inputs to a buffer. The */
+/*                    buffer starts with the magic  */
+/*                    and version, then each record */
+/*                    is its type byte, the ms since*/
+/*                    the last record, the payload  */
+/*                    length and the payload. Times */
+/*                    and lengths are little endian */
+/*                    varints (7 bits per byte, high*/
+/*                    bit set when more follow).    */
+/*                    When full, the oldest records */
+/*                    are dropped so the last ones  */
+/*                    are kept. While a download    */
+/*                    holds the buffer, records that*/
+/*                    do not fit are dropped, frame */
+/*                    contents first. Dropped       */
+/*                    records are counted.          */
+/****************************************************/
+class SessionRecorder
+{
+  private:
+    // Private Variables:
+    uint8_t *pBuffer;
+    size_t stSize;
+    size_t stLength;
+    unsigned long ulLastRecordMs;
+    unsigned long ulDroppedRecords;
+    boolean bHeld;
+    int iFrameContentEvery;
+    int iFramesToContent;
+
+    /****************************************************/
+    /* Method name:        putVarint                    */
+    /* Method description: Writes a varint at the end of*/
+    /*                     the buffer, space must be    */
+    /*                     checked by the caller.       */
+    /*                                                  */
+    /* Input params:       ulValue - Value to write.    */
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void putVarint(unsigned long ulValue);
+
+    /****************************************************/
+    /* Method name:        getVarint                    */
+    /* Method description: Reads a varint of the buffer.*/
+    /*                                                  */
+    /* Input params:       pOffset - Where it starts,   */
+    /*                     moved past it. (size_t*)     */
+    /* Output params:      Value. (unsigned long)       */
+    /****************************************************/
+    unsigned long getVarint(size_t *pOffset);
+
+    /****************************************************/
+    /* Method name:        dropOldest                   */
+    /* Method description: Drops the oldest records     */
+    /*                     until there is room for a    */
+    /*                     record and a part of the     */
+    /*                     buffer more, so the next ones*/
+    /*                     do not move it again.        */
+    /*                                                  */
+    /* Input params:       stNeeded - Room for the      */
+    /*                     record. (size_t)             */
+    /* Output params:                                   */
+    /****************************************************/
+    void dropOldest(size_t stNeeded);
+
+    /****************************************************/
+    /* Method name:        writeRecord                  */
+    /* Method description: Appends a whole record or    */
+    /*                     nothing, dropping the oldest */
+    /*                     ones for room unless held.   */
+    /*                                                  */
+    /* Input params:       ui8Type - Record type.       */
+    /*                     (uint8_t)                    */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /*                     pPayload - Payload bytes.    */
+    /*                     (const uint8_t*)             */
+    /*                     stPayloadLength - Payload    */
+    /*                     size. (size_t)               */
+    /* Output params:      true if recorded. (bool)     */
+    /****************************************************/
+    bool writeRecord(uint8_t ui8Type, unsigned long ulNowMs, const uint8_t *pPayload, size_t stPayloadLength);
+
+  public:
+
+    /****************************************************/
+    /* Creator name:       SessionRecorder              */
+    /* Method description: Class Object creator, the    */
+    /*                     recorder drops every record  */
+    /*                     until begin is called.       */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    SessionRecorder();
+
+    /****************************************************/
+    /* Method name:        begin                        */
+    /* Method description: Sets the record buffer.      */
+    /*                                                  */
+    /* Input params:       pRecordBuffer - Buffer, NULL */
+    /*                     disables the recording.      */
+    /*                     (uint8_t*)                   */
+    /*                     stRecordBufferSize - Buffer  */
+    /*                     size. (size_t)               */
+    /*                     iFrameContentPeriod - One in */
+    /*                     how many frames also has its */
+    /*                     contents recorded, 0 records */
+    /*                     sizes only. (int)            */
+    /* Output params:                                   */
+    /****************************************************/
+    void begin(uint8_t *pRecordBuffer, size_t stRecordBufferSize, int iFrameContentPeriod);
+
+    /****************************************************/
+    /* Method name:        clear                        */
+    /* Method description: Empties the buffer, the next */
+    /*                     record holds the time since  */
+    /*                     boot.                        */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:                                   */
+    /****************************************************/
+    void clear();
+
+    /****************************************************/
+    /* Method name:        consume                      */
+    /* Method description: Drops the first bytes of the */
+    /*                     buffer, as sent by a         */
+    /*                     download, and keeps what was */
+    /*                     recorded after them. The kept*/
+    /*                     first record gets its time   */
+    /*                     since boot, so the buffer is */
+    /*                     again a whole session.       */
+    /*                                                  */
+    /* Input params:       stConsumed - Bytes from the  */
+    /*                     start, must end at a record. */
+    /*                     (size_t)                     */
+    /* Output params:      false if it does not end at a*/
+    /*                     record, nothing is dropped.  */
+    /*                     (bool)                       */
+    /****************************************************/
+    bool consume(size_t stConsumed);
+
+    /****************************************************/
+    /* Method name:        hold                         */
+    /* Method description: Keeps the recorded bytes in  */
+    /*                     place while a download sends */
+    /*                     them from the buffer. Frame  */
+    /*                     contents then leave a part of*/
+    /*                     it to the other records.     */
+    /*                                                  */
+    /* Input params:       bHold - Held. (bool)         */
+    /* Output params:                                   */
+    /****************************************************/
+    void hold(bool bHold);
+
+    /****************************************************/
+    /* Method name:        recordText                   */
+    /* Method description: Records a text payload.      */
+    /*                                                  */
+    /* Input params:       ui8Type - Record type.       */
+    /*                     (uint8_t)                    */
+    /*                     cText - Text. (const char*)  */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      true if recorded. (bool)     */
+    /****************************************************/
+    bool recordText(uint8_t ui8Type, const char *cText, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        recordValue                  */
+    /* Method description: Records a varint payload.    */
+    /*                                                  */
+    /* Input params:       ui8Type - Record type.       */
+    /*                     (uint8_t)                    */
+    /*                     ulValue - Value.             */
+    /*                     (unsigned long)              */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      true if recorded. (bool)     */
+    /****************************************************/
+    bool recordValue(uint8_t ui8Type, unsigned long ulValue, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        recordFrame                  */
+    /* Method description: Records the size of a frame  */
+    /*                     and, once every content      */
+    /*                     period, its contents.        */
+    /*                                                  */
+    /* Input params:       pJpeg - Frame. (const        */
+    /*                     uint8_t*)                    */
+    /*                     stJpegLength - Frame size.   */
+    /*                     (size_t)                     */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      true if recorded. (bool)     */
+    /****************************************************/
+    bool recordFrame(const uint8_t *pJpeg, size_t stJpegLength, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        getData                      */
+    /* Method description: Recorded bytes.              */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Buffer. (const uint8_t*)     */
+    /****************************************************/
+    const uint8_t *getData();
+
+    /****************************************************/
+    /* Method name:        getLength                    */
+    /* Method description: Number of recorded bytes.    */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Length. (size_t)             */
+    /****************************************************/
+    size_t getLength();
+
+    /****************************************************/
+    /* Method name:        getDroppedRecords            */
+    /* Method description: Records lost since the last  */
+    /*                     clear or consume for lack of */
+    /*                     space, the oldest dropped    */
+    /*                     ones included.               */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Records. (unsigned long)     */
+    /****************************************************/
+    unsigned long getDroppedRecords();
+};
+
+#endif
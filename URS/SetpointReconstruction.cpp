@@ -0,0 +1,166 @@
+/**************************************************/
+/* File name:        SetpointReconstruction.cpp   */
+/* File description: File for the implementation  */
+/*                   of SetpointReconstruction    */
+/*                   Class, that rebuilds a smooth*/
+/*                   setpoint at control rate from*/
+/*                   sparse network updates.      */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include "SetpointReconstruction.h"
+
+/****************************************************/
+/* Creator name:       SetpointReconstruction       */
+/* Method description: Class Object creator         */
+/*                                                  */
+/* Input params:       iInitialValue - Output before*/
+/*                     the first setpoint, ranging  */
+/*                     from 0 to 1023. (int)        */
+/* Output params:                                   */
+/****************************************************/
+SetpointReconstruction::SetpointReconstruction(int iInitialValue)
+{
+  lRampStart = (long)iInitialValue << SP_FIXED_SHIFT;
+  lRampTarget = lRampStart;
+  lRampMs = 0;
+  lVelocity = 0;
+  lIntervalMs = SP_DEFAULT_INTERVAL_MS;
+  ulLastUpdateMs = 0;
+  bHasUpdate = false;
+  setGains(SP_DEFAULT_INTERVAL_GAIN, SP_DEFAULT_VELOCITY_GAIN, SP_DEFAULT_RAMP_PERCENT, SP_DEFAULT_MAX_EXTRAPOLATION_MS, SP_DEFAULT_MAX_OVERSHOOT);
+}
+
+/****************************************************/
+/* Method name:        setGains                     */
+/* Method description: Tunes the reconstruction.    */
+/*                                                  */
+/* Input params:       iIntervalGainPercent - Weight*/
+/*                     of a new interval in the     */
+/*                     interval estimate. (int)     */
+/*                     iVelocityGainPercent - Weight*/
+/*                     of a new velocity in the     */
+/*                     velocity estimate. (int)     */
+/*                     iRampPercentValue - Length of*/
+/*                     the ramp to a new setpoint,  */
+/*                     in % of the interval         */
+/*                     estimate, 0 steps. (int)     */
+/*                     iMaxExtrapolationTimeMs -    */
+/*                     Time the velocity is kept    */
+/*                     after a late update, 0       */
+/*                     disables. (int)              */
+/*                     iMaxOvershootValue - Max     */
+/*                     distance from the last       */
+/*                     setpoint when extrapolating, */
+/*                     in 10 bit units. (int)       */
+/* Output params:                                   */
+/****************************************************/
+void SetpointReconstruction::setGains(int iIntervalGainPercent, int iVelocityGainPercent, int iRampPercentValue, int iMaxExtrapolationTimeMs, int iMaxOvershootValue)
+{
+  iIntervalGain = constrain(iIntervalGainPercent, 0, 100);
+  iVelocityGain = constrain(iVelocityGainPercent, 0, 100);
+  iRampPercent = constrain(iRampPercentValue, 0, 100);
+  iMaxExtrapolationMs = max(iMaxExtrapolationTimeMs, 0);
+  iMaxOvershoot = max(iMaxOvershootValue, 0);
+}
+
+/****************************************************/
+/* Method name:        newSetpoint                  */
+/* Method description: Timestamps a setpoint        */
+/*                     received from the network.   */
+/*                                                  */
+/* Input params:       iValue - Setpoint, ranging   */
+/*                     from 0 to 1023. (int)        */
+/*                     ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:                                   */
+/****************************************************/
+void SetpointReconstruction::newSetpoint(int iValue, unsigned long ulNowMs)
+{
+  long lTarget = (long)iValue << SP_FIXED_SHIFT;
+  // Start the new ramp where the output is, so it never jumps
+  long lCurrent = getFixedValue(ulNowMs);
+
+  if (bHasUpdate) {
+    long lElapsedMs = (long)(ulNowMs - ulLastUpdateMs);
+    if (SP_MAX_INTERVAL_MS < lElapsedMs) {
+      // Too old to tell a velocity, the operator stopped and restarted
+      lVelocity = 0;
+    } else if (0 < lElapsedMs) {
+      lIntervalMs += (lElapsedMs - lIntervalMs) * iIntervalGain / 100;
+      lIntervalMs = constrain(lIntervalMs, SP_MIN_INTERVAL_MS, SP_MAX_INTERVAL_MS);
+      long lNewVelocity = (lTarget - lRampTarget) / lElapsedMs;
+      lVelocity += (lNewVelocity - lVelocity) * iVelocityGain / 100;
+    }
+  }
+
+  lRampStart = lCurrent;
+  lRampTarget = lTarget;
+  // Moving until the next update is due, a shorter ramp stops and waits
+  lRampMs = lIntervalMs * iRampPercent / 100;
+  ulLastUpdateMs = ulNowMs;
+  bHasUpdate = true;
+}
+
+/****************************************************/
+/* Method name:        getValue                     */
+/* Method description: Rebuilt setpoint for the     */
+/*                     current control period.      */
+/*                                                  */
+/* Input params:       ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      Value ranging from 0 to 1023.*/
+/*                     (int)                        */
+/****************************************************/
+int SetpointReconstruction::getValue(unsigned long ulNowMs)
+{
+  long lValue = (getFixedValue(ulNowMs) + (1L << (SP_FIXED_SHIFT - 1))) >> SP_FIXED_SHIFT;
+  return constrain(lValue, 0, 1023);
+}
+
+/****************************************************/
+/* Method name:        getIntervalEstimate          */
+/* Method description: Estimated time between       */
+/*                     setpoints.                   */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Interval in ms. (long)       */
+/****************************************************/
+long SetpointReconstruction::getIntervalEstimate()
+{
+  return lIntervalMs;
+}
+
+/****************************************************/
+/* Method name:        getFixedValue                */
+/* Method description: Rebuilt value in fixed point.*/
+/*                                                  */
+/* Input params:       ulNowMs - Current time in ms.*/
+/*                     (unsigned long)              */
+/* Output params:      Value shifted by             */
+/*                     SP_FIXED_SHIFT. (long)       */
+/****************************************************/
+long SetpointReconstruction::getFixedValue(unsigned long ulNowMs)
+{
+  long lElapsedMs = (long)(ulNowMs - ulLastUpdateMs);
+  if (lElapsedMs < 0) lElapsedMs = 0;
+
+  if (lElapsedMs < lRampMs) {
+    return lRampStart + (lRampTarget - lRampStart) * lElapsedMs / lRampMs;
+  }
+
+  // Until the next update is due, hold the last setpoint, then extrapolate
+  long lLateMs = lElapsedMs - lIntervalMs;
+  if (lLateMs <= 0 || iMaxExtrapolationMs == 0) return lRampTarget;
+  long lMaxOffset = (long)iMaxOvershoot << SP_FIXED_SHIFT;
+  long lOffset = constrain(lVelocity * min(lLateMs, (long)iMaxExtrapolationMs), -lMaxOffset, lMaxOffset);
+  if (iMaxExtrapolationMs < lLateMs) {
+    // Then return to the last setpoint in the same time
+    long lReturnMs = 2L * iMaxExtrapolationMs - lLateMs;
+    if (lReturnMs <= 0) return lRampTarget;
+    lOffset = lOffset * lReturnMs / iMaxExtrapolationMs;
+  }
+  return lRampTarget + lOffset;
+}
@@ -0,0 +1,152 @@
+/**************************************************/
+/* File name:        SetpointReconstruction.h     */
+/* File description: Header File for the          */
+/*                   SetpointReconstruction Class,*/
+/*                   that rebuilds a smooth       */
+/*                   setpoint at control rate from*/
+/*                   sparse network updates.      */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef SetpointReconstruction_h
+#define SetpointReconstruction_h
+#include "Arduino.h"
+
+// Defines
+#define SP_FIXED_SHIFT                   8    // Fixed point fraction bits
+#define SP_DEFAULT_INTERVAL_MS           250  // Expected time between updates
+#define SP_MIN_INTERVAL_MS               10   // One control period
+#define SP_MAX_INTERVAL_MS               1000 // Longer gaps are not a stream of updates
+#define SP_DEFAULT_INTERVAL_GAIN         25   // % of a new interval taken in the estimate
+#define SP_DEFAULT_VELOCITY_GAIN         100  // % of a new velocity taken in the estimate
+#define SP_DEFAULT_RAMP_PERCENT          100  // Ramp to a new setpoint, % of the interval estimate
+#define SP_DEFAULT_MAX_EXTRAPOLATION_MS  100  // Extrapolation time for a late update
+#define SP_DEFAULT_MAX_OVERSHOOT         40   // Max extrapolated distance, 10 bit units
+
+/****************************************************/
+/* Class name:        SetpointReconstruction        */
+/* Class description: Class that timestamps the     */
+/*                    setpoints of one axis and     */
+/*                    rebuilds the value at control */
+/*                    rate. Each new setpoint is    */
+/*                    reached by a ramp from the    */
+/*                    current output that lasts the */
+/*                    estimated interval, so the    */
+/*                    servo keeps moving until the  */
+/*                    next update and lags the      */
+/*                    operator by one interval. When*/
+/*                    the next update is late the   */
+/*                    output keeps the last velocity*/
+/*                    for a bounded time and never  */
+/*                    further than the max overshoot*/
+/*                    from the last setpoint, then  */
+/*                    it returns to it. Integer math*/
+/*                    only, it runs inside the timer*/
+/*                    interrupt.                    */
+/****************************************************/
+class SetpointReconstruction
+{
+  private:
+    // Private Variables:
+    long lRampStart;
+    long lRampTarget;
+    long lRampMs;
+    long lVelocity;
+    long lIntervalMs;
+    unsigned long ulLastUpdateMs;
+    boolean bHasUpdate;
+    int iIntervalGain;
+    int iVelocityGain;
+    int iRampPercent;
+    int iMaxExtrapolationMs;
+    int iMaxOvershoot;
+
+    /****************************************************/
+    /* Method name:        getFixedValue                */
+    /* Method description: Rebuilt value in fixed point.*/
+    /*                                                  */
+    /* Input params:       ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      Value shifted by             */
+    /*                     SP_FIXED_SHIFT. (long)       */
+    /****************************************************/
+    long getFixedValue(unsigned long ulNowMs);
+
+  public:
+
+    /****************************************************/
+    /* Creator name:       SetpointReconstruction       */
+    /* Method description: Class Object creator         */
+    /*                                                  */
+    /* Input params:       iInitialValue - Output before*/
+    /*                     the first setpoint, ranging  */
+    /*                     from 0 to 1023. (int)        */
+    /* Output params:                                   */
+    /****************************************************/
+    SetpointReconstruction(int iInitialValue);
+
+    /****************************************************/
+    /* Method name:        setGains                     */
+    /* Method description: Tunes the reconstruction.    */
+    /*                                                  */
+    /* Input params:       iIntervalGainPercent - Weight*/
+    /*                     of a new interval in the     */
+    /*                     interval estimate. (int)     */
+    /*                     iVelocityGainPercent - Weight*/
+    /*                     of a new velocity in the     */
+    /*                     velocity estimate. (int)     */
+    /*                     iRampPercentValue - Length of*/
+    /*                     the ramp to a new setpoint,  */
+    /*                     in % of the interval         */
+    /*                     estimate, 0 steps. (int)     */
+    /*                     iMaxExtrapolationTimeMs -    */
+    /*                     Time the velocity is kept    */
+    /*                     after a late update, 0       */
+    /*                     disables. (int)              */
+    /*                     iMaxOvershootValue - Max     */
+    /*                     distance from the last       */
+    /*                     setpoint when extrapolating, */
+    /*                     in 10 bit units. (int)       */
+    /* Output params:                                   */
+    /****************************************************/
+    void setGains(int iIntervalGainPercent, int iVelocityGainPercent, int iRampPercentValue, int iMaxExtrapolationTimeMs, int iMaxOvershootValue);
+
+    /****************************************************/
+    /* Method name:        newSetpoint                  */
+    /* Method description: Timestamps a setpoint        */
+    /*                     received from the network.   */
+    /*                                                  */
+    /* Input params:       iValue - Setpoint, ranging   */
+    /*                     from 0 to 1023. (int)        */
+    /*                     ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:                                   */
+    /****************************************************/
+    void newSetpoint(int iValue, unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        getValue                     */
+    /* Method description: Rebuilt setpoint for the     */
+    /*                     current control period.      */
+    /*                                                  */
+    /* Input params:       ulNowMs - Current time in ms.*/
+    /*                     (unsigned long)              */
+    /* Output params:      Value ranging from 0 to 1023.*/
+    /*                     (int)                        */
+    /****************************************************/
+    int getValue(unsigned long ulNowMs);
+
+    /****************************************************/
+    /* Method name:        getIntervalEstimate          */
+    /* Method description: Estimated time between       */
+    /*                     setpoints.                   */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      Interval in ms. (long)       */
+    /****************************************************/
+    long getIntervalEstimate();
+};
+
+#endif
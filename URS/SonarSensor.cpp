@@ -5,7 +5,7 @@
 /*                   the HC-SC04 distance sensor. */
 /* Author name:      Richard Netto                */
 /* Creation date:    20/11/2020                   */
-/* Revision date:    18/12/2020                   */
+/* Revision date:    19/10/2026                   */
 /**************************************************/
 
 #include "SonarSensor.h"
@@ -24,6 +24,7 @@
 /****************************************************/
 SonarSensor::SonarSensor(int iEchoPinNumber, int iTriggerPinNumber, float fFittingA, float fFittingB)
 {
+  ulDuration = 0;
   // Salve the Pin Numbers
   iEchoPin = iEchoPinNumber;
   iTriggerPin = iTriggerPinNumber;
@@ -32,13 +33,19 @@ SonarSensor::SonarSensor(int iEchoPinNumber, int iTriggerPinNumber, float fFitti
   pinMode(iTriggerPin, OUTPUT);
   fA = fFittingA;
   fB = fFittingB / fFittingA;
+  // Echo of the farthest distance, pulseIn would wait a whole second
+  ulEchoTimeoutUs = (SONAR_MAX_DISTANCE_CM + fB) * fA;
 }
 
 /****************************************************/
 /* Method name:        getDistance                  */
 /* Method description: Method that returns the      */
 /*                     distance measured by the     */
-/*                     sensor in cm.                */
+/*                     sensor in cm. Waits for the  */
+/*                     echo only as long as it takes*/
+/*                     from SONAR_MAX_DISTANCE_CM,  */
+/*                     no echo reads as that        */
+/*                     distance.                    */
 /*                                                  */
 /* Input params:     iEchoPin - Pin associated to   */
 /*                   the eccho signal of the        */
@@ -59,8 +66,25 @@ float SonarSensor::getDistance()
   digitalWrite(iTriggerPin, LOW);
 
   // Read the PING echo from an obstacle and gives back the time it took
-  fDuration = pulseIn(iEchoPin, HIGH);
+  ulDuration = pulseIn(iEchoPin, HIGH, ulEchoTimeoutUs);
+  // No echo in time, nothing closer than the farthest distance
+  if (ulDuration == 0) fDistanceCm = SONAR_MAX_DISTANCE_CM;
   // Calculate the distance
-  fDistanceCm = fDuration / fA - fB;
+  else fDistanceCm = ulDuration / fA - fB;
   return fDistanceCm;
 }
+
+/****************************************************/
+/* Method name:        getEchoDuration              */
+/* Method description: Method that returns the echo */
+/*                     duration read by the last    */
+/*                     getDistance call, as pulseIn */
+/*                     gave it, 0 if no echo came.  */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:    Duration in us. (unsigned long)*/
+/****************************************************/
+unsigned long SonarSensor::getEchoDuration()
+{
+  return ulDuration;
+}
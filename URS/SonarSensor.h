@@ -5,13 +5,16 @@
 /*                   HC-SC04 distance sensor.     */
 /* Author name:      Richard Netto                */
 /* Creation date:    20/11/2020                   */
-/* Revision date:    18/12/2020                   */
+/* Revision date:    19/10/2026                   */
 /**************************************************/
 
 #ifndef SonarSensor_h
 #define SonarSensor_h
 #include "Arduino.h"
 
+// Defines
+#define SONAR_MAX_DISTANCE_CM            100  // Farther reads as this, bounds the echo wait
+
 /****************************************************/
 /* Class name:        SonarSensor                   */
 /* Class description: Class that encapsulates the   */
@@ -24,9 +27,10 @@ class SonarSensor
     // Variáveis Privadas:
     int iEchoPin;
     int iTriggerPin;
-    float fDuration;
+    unsigned long ulDuration;
     float fDistanceCm;
     float fA, fB;
+    unsigned long ulEchoTimeoutUs;
 
   public:
 
@@ -58,7 +62,11 @@ class SonarSensor
     /* Method name:        getDistance                  */
     /* Method description: Method that returns the      */
     /*                     distance measured by the     */
-    /*                     sensor in cm.                */
+    /*                     sensor in cm. Waits for the  */
+    /*                     echo only as long as it takes*/
+    /*                     from SONAR_MAX_DISTANCE_CM,  */
+    /*                     no echo reads as that        */
+    /*                     distance.                    */
     /*                                                  */
     /* Input params:     iEchoPin - Pin associated to   */
     /*                   the eccho signal of the        */
@@ -70,6 +78,18 @@ class SonarSensor
     /****************************************************/
     float getDistance();
 
+    /****************************************************/
+    /* Method name:        getEchoDuration              */
+    /* Method description: Method that returns the echo */
+    /*                     duration read by the last    */
+    /*                     getDistance call, as pulseIn */
+    /*                     gave it, 0 if no echo came.  */
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:    Duration in us. (unsigned long)*/
+    /****************************************************/
+    unsigned long getEchoDuration();
+
 };
 
 #endif
@@ -6,16 +6,20 @@
 /*                   ESP32-CAM micro controller.  */
 /* Author name:      Juliane Vianna               */
 /* Creation date:    20/11/2020                   */
-/* Revision date:    15/01/2020                   */
+/* Revision date:    19/10/2026                   */
 /**************************************************/
 
 // Library Includes
 #include <WiFi.h>
-#include <WebServer.h>
-#include <WiFiClient.h>
 #include <Arduino_JSON.h>
-#include <HTTPClient.h>
+#include <Preferences.h>
 #include "OV2640.h"
+#include "BootSequencer.h"
+#include "SetpointReconstruction.h"
+#include "CaptureManager.h"
+#include "SessionRecorder.h"
+#include "HttpServer.h"
+#include "HttpGetClient.h"
 #include "CameraPanTiltControl.h"
 #include "MovementControl.h"
 #include "SonarSensor.h"
@@ -50,21 +54,41 @@
 #define FRONT_SENSOR_FITTING_B     5.7238  // Obtained by empirical manners
 #define FRONT_SENSOR_STOP_DISTANCE 12
 
+#define CONTROL_CLOUD_PERIOD_MS    250 // Between cloud setpoint requests
+#define CONTROL_SONAR_PERIOD_MS    60  // HC-SR04 minimum measurement cycle
+
+#define STREAM_FRAME_SLOTS         3   // Frame copies, one per stream speed
+#define STREAM_FRAME_SLOT_SIZE     (32 * 1024) // In PSRAM, bigger frames are dropped
+
+#define CAMERA_KEEPALIVE           false // Low rate capture into the session record instead of parking
+
+#define SESSION_BUFFER_SIZE        (512 * 1024) // In PSRAM, 0 disables the recording
+#define SESSION_FRAME_CONTENT_EVERY 30 // Frames between recorded JPEG contents
+
 #define WIFI_SSID "Quarto"
 #define WIFI_PWD "Netto2014"
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 3000 // Falls back to a full scan after it
+#define WIFI_CONNECT_POLL_MS       10
+// Uncomment to skip DHCP on every boot
+// #define WIFI_STATIC_IP          192, 168, 0, 50
+// #define WIFI_GATEWAY            192, 168, 0, 1
+// #define WIFI_SUBNET             255, 255, 255, 0
 
 // Variables
 OV2640 ovCam;
-WebServer wsServer(80);
+CaptureManager cmCaptureManager(&ovCam);
+SessionRecorder srSessionRecorder;
+HttpServer hsServer;
 const char cHEADER[] = "HTTP/1.1 200 OK\r\n" \
                        "Access-Control-Allow-Origin: *\r\n" \
                        "Content-Type: multipart/x-mixed-replace; boundary=123456789000000000000987654321\r\n";
 const char cBOUNDARY[] = "\r\n--123456789000000000000987654321\r\n";
 const char cCTNTTYPE[] = "Content-Type: image/jpeg\r\nContent-Length: ";
-const int iHdrLen = strlen(cHEADER);
-const int iBdrLen = strlen(cBOUNDARY);
-const int iCntLen = strlen(cCTNTTYPE);
-int iContMiliseconds = 0;
+boolean bFrameSent = false;
+boolean bSessionDownloading = false;
+size_t stSessionDownloadLength = 0;
+uint8_t *pFrameSlots[STREAM_FRAME_SLOTS];
+volatile uint32_t ui32ContMiliseconds = 0; // Written by the timer interrupt
 MovementControl mcMovementControl(LEFT_SERVO_PIN, RIGHT_SERVO_PIN);
 CameraPanTiltControl cptCameraPanTiltControl(TILT_SERVO_PIN, PAN_SERVO_PIN);
 SonarSensor ssFloorSensor(FRONT_SENSOR_ECHO_PIN, FRONT_SENSOR_TRIGGER_PIN, FRONT_SENSOR_FITTING_A, FRONT_SENSOR_FITTING_B);
@@ -74,13 +98,22 @@ int iAxisX = 511;
 int iAxisY = 511;
 int iLeftMotorPosition = 511;
 int iRightMotorPosition = 511;
+SetpointReconstruction srPanSetpoint(511);
+SetpointReconstruction srTiltSetpoint(511);
+portMUX_TYPE muxSetpoint = portMUX_INITIALIZER_UNLOCKED;
 float iFloorDistance;
 boolean bThereIsNoFloor = false;
 hw_timer_t *hwTimer = NULL;
-HTTPClient httpClientPanTilt;
-HTTPClient httpClientMovement;
+HttpGetClient hgcPanTiltClient;
+HttpGetClient hgcMovementClient;
+unsigned long ulLastCloudMs = 0;
+unsigned long ulLastSonarMs = 0;
 const char* cPanTiltServerName = "http://blynk-cloud.com/6AT_sWCIj5y1iP-39p0fdjjWUH2v5RBZ/get/V2";
 const char* cMovementServerName = "http://blynk-cloud.com/6AT_sWCIj5y1iP-39p0fdjjWUH2v5RBZ/get/V1";
+BootSequencer bsBootSequencer;
+Preferences prefWiFiCache;
+boolean bWiFiFastConnect = false;
+unsigned long ulWiFiBeginMs = 0;
 
 /******************************************************/
 /* Method name:        updateFunction                 */
@@ -91,10 +124,16 @@ const char* cMovementServerName = "http://blynk-cloud.com/6AT_sWCIj5y1iP-39p0fdj
 /* Output params:                                     */
 /******************************************************/
 void IRAM_ATTR updateFunction() {
-  iContMiliseconds += 1;
+  uint32_t ui32NowMs = ui32ContMiliseconds + 1;
+  ui32ContMiliseconds = ui32NowMs;
   // Every 10 ms call
-  if (iContMiliseconds % 10 == 0) {
-    cptCameraPanTiltControl.updatePosition(iAxisX, iAxisY);
+  if (ui32NowMs % 10 == 0) {
+    // Pan Tilt follows the setpoints rebuilt at control rate
+    portENTER_CRITICAL_ISR(&muxSetpoint);
+    int iPan = srPanSetpoint.getValue(ui32NowMs);
+    int iTilt = srTiltSetpoint.getValue(ui32NowMs);
+    portEXIT_CRITICAL_ISR(&muxSetpoint);
+    cptCameraPanTiltControl.updatePosition(iPan, iTilt);
     // If there's no Floor, stop the car from going foward
     if (bThereIsNoFloor && 511 < iLeftMotorPosition ) iLeftMotorPosition = 511;
     if (bThereIsNoFloor && 511 < iRightMotorPosition) iRightMotorPosition = 511;
@@ -135,40 +174,243 @@ void initTimerAlarm(int iTimerNumber, int iPrescaler, int iAlarmPeriod) {
   timerAlarmEnable(hwTimer);
 }
 
+/******************************************************/
+/* Method name:        handleJpegStreamEnd            */
+/* Method description: Function called when a jpeg    */
+/*                     stream client is gone.         */
+/*                                                    */
+/* Input params:       int - Connection of the stream,*/
+/*                     unused.                        */
+/*                     bool - Unused.                 */
+/* Output params:                                     */
+/******************************************************/
+void handleJpegStreamEnd(int, bool)
+{
+  cmCaptureManager.release();
+}
+
 /******************************************************/
 /* Method name:        handleJpegStream               */
-/* Method description: Function to handle the jpeg    */
-/*                     stream of camera images.       */
+/* Method description: Function to start a jpeg stream*/
+/*                     of camera images. The frames   */
+/*                     are pushed by sendStreamFrame  */
+/*                     once the camera has resumed.   */
+/*                                                    */
+/* Input params:       HttpServer *pServer - Server   */
+/*                     that got the request.          */
+/*                     int iConnection - Connection   */
+/*                     of the request.                */
+/* Output params:                                     */
+/******************************************************/
+void handleJpegStream(HttpServer *pServer, int iConnection)
+{
+  // The first frame is the one exposed by the resume
+  if (cmCaptureManager.getState() != CAPTURE_STATE_STREAMING) bFrameSent = false;
+  // Wakes the camera up if it was parked, update runs the resume
+  cmCaptureManager.acquire();
+  pServer->beginStream(iConnection, cHEADER, cCTNTTYPE, cBOUNDARY, handleJpegStreamEnd);
+}
+
+/******************************************************/
+/* Method name:        getFreeFrameSlot               */
+/* Method description: Function to find a frame copy  */
+/*                     that no stream is sending.     */
+/*                                                    */
+/* Input params:                                      */
+/* Output params:      uint8_t* - Slot, NULL if all   */
+/*                     are in use.                    */
+/******************************************************/
+uint8_t *getFreeFrameSlot(void)
+{
+  for (int iSlot = 0; iSlot < STREAM_FRAME_SLOTS; iSlot++) {
+    if (pFrameSlots[iSlot] && !hsServer.isPartInUse(pFrameSlots[iSlot])) return pFrameSlots[iSlot];
+  }
+  return NULL;
+}
+
+/******************************************************/
+/* Method name:        sendStreamFrame                */
+/* Method description: Function to push the next      */
+/*                     camera frame to the streams    */
+/*                     that sent the last one. A slow */
+/*                     stream keeps sending its own   */
+/*                     copy and skips the frames in   */
+/*                     between.                       */
 /*                                                    */
 /* Input params:                                      */
 /* Output params:                                     */
 /******************************************************/
-void handleJpegStream(void)
+void sendStreamFrame(void)
 {
-  char buf[32];
-  int s;
+  uint8_t *pSlot = NULL;
+  const uint8_t *pFrame;
+  size_t stFrameLength;
 
-  WiFiClient client = wsServer.client();
+  if (!hsServer.isStreamWaiting()) return;
+  if (cmCaptureManager.getState() != CAPTURE_STATE_STREAMING) return;
+  if (pFrameSlots[0]) {
+    pSlot = getFreeFrameSlot();
+    if (!pSlot) return;
+  } else if (bFrameSent && hsServer.isPartInUse(ovCam.getfb())) {
+    // Without copies the camera buffer goes back only when no stream sends it
+    return;
+  }
+  // The grab runs beside the loop, its frame is pushed by a later call
+  if (bFrameSent && !ovCam.runFor(0)) return;
+  bFrameSent = true;
+  pFrame = ovCam.getfb();
+  stFrameLength = ovCam.getSize();
+  srSessionRecorder.recordFrame(pFrame, stFrameLength, millis());
+  if (pSlot) {
+    if (STREAM_FRAME_SLOT_SIZE < stFrameLength) return;
+    memcpy(pSlot, pFrame, stFrameLength);
+    pFrame = pSlot;
+  }
+  hsServer.pushStreamPart(pFrame, stFrameLength);
+}
 
-  client.write(cHEADER, iHdrLen);
-  client.write(cBOUNDARY, iBdrLen);
-  int iTemp = 0;
-  while (true)
-  {
-    if (!client.connected()) break;
-    if (10 < iTemp) {
-      handleVariables();
-      iTemp = 0;
-    }
-    iTemp++;
-    ovCam.run();
-    s = ovCam.getSize();
-    client.write(cCTNTTYPE, iCntLen);
-    sprintf( buf, "%d\r\n\r\n", s );
-    client.write(buf, strlen(buf));
-    client.write((char *)ovCam.getfb(), s);
-    client.write(cBOUNDARY, iBdrLen);
+/******************************************************/
+/* Method name:        recordKeepAliveFrame           */
+/* Method description: Function to record the frames  */
+/*                     captured while no stream is    */
+/*                     connected.                     */
+/*                                                    */
+/* Input params:       const uint8_t *pJpeg - Frame.  */
+/*                     size_t stLength - Frame size.  */
+/* Output params:                                     */
+/******************************************************/
+void recordKeepAliveFrame(const uint8_t *pJpeg, size_t stLength)
+{
+  srSessionRecorder.recordFrame(pJpeg, stLength, millis());
+}
+
+/******************************************************/
+/* Method name:        handleCaptureReport            */
+/* Method description: Function to send the time spent*/
+/*                     by the camera in each capture  */
+/*                     state and the first frame      */
+/*                     latency.                       */
+/*                                                    */
+/* Input params:       HttpServer *pServer - Server   */
+/*                     that got the request.          */
+/*                     int iConnection - Connection   */
+/*                     of the request.                */
+/* Output params:                                     */
+/******************************************************/
+void handleCaptureReport(HttpServer *pServer, int iConnection)
+{
+  String message = "state ";
+  message += cmCaptureManager.getStateName(cmCaptureManager.getState());
+  message += "\n";
+  for (int iState = 0; iState < CAPTURE_STATE_COUNT; iState++) {
+    message += cmCaptureManager.getStateName(iState);
+    message += "_ms ";
+    message += cmCaptureManager.getStateTime(iState);
+    message += "\n";
   }
+  message += "resumes ";
+  message += cmCaptureManager.getResumeCount();
+  message += "\nfirst_frame_last_ms ";
+  message += cmCaptureManager.getLastFirstFrameLatency();
+  message += "\nfirst_frame_max_ms ";
+  message += cmCaptureManager.getMaxFirstFrameLatency();
+  message += "\n";
+  pServer->send(iConnection, 200, "text/plain", message.c_str());
+}
+
+/******************************************************/
+/* Method name:        handleSessionDownloadEnd       */
+/* Method description: Function to drop the records   */
+/*                     that were downloaded, keeping  */
+/*                     the ones recorded meanwhile for*/
+/*                     the next download.             */
+/*                                                    */
+/* Input params:       int - Connection of the        */
+/*                     download, unused.              */
+/*                     bool bComplete - true if all   */
+/*                     of it was sent.                */
+/* Output params:                                     */
+/******************************************************/
+void handleSessionDownloadEnd(int, bool bComplete)
+{
+  bSessionDownloading = false;
+  srSessionRecorder.hold(false);
+  if (!bComplete) return;
+  if (srSessionRecorder.getDroppedRecords()) {
+    Serial.print("Session records dropped: ");
+    Serial.println(srSessionRecorder.getDroppedRecords());
+  }
+  srSessionRecorder.consume(stSessionDownloadLength);
+}
+
+/******************************************************/
+/* Method name:        handleSessionDownload          */
+/* Method description: Function to send the recorded  */
+/*                     session.                       */
+/*                                                    */
+/* Input params:       HttpServer *pServer - Server   */
+/*                     that got the request.          */
+/*                     int iConnection - Connection   */
+/*                     of the request.                */
+/* Output params:                                     */
+/******************************************************/
+void handleSessionDownload(HttpServer *pServer, int iConnection)
+{
+  // A second download would see the buffer cleared under it
+  if (bSessionDownloading) {
+    pServer->send(iConnection, 503, "text/plain", "Session download in progress\n");
+    return;
+  }
+  // Records keep being appended past the length being sent, none is moved
+  bSessionDownloading = true;
+  srSessionRecorder.hold(true);
+  stSessionDownloadLength = srSessionRecorder.getLength();
+  pServer->sendData(iConnection, 200, "application/octet-stream", srSessionRecorder.getData(),
+                    stSessionDownloadLength, handleSessionDownloadEnd);
+}
+
+/******************************************************/
+/* Method name:        handleServerReport             */
+/* Method description: Function to send the connection*/
+/*                     count and latency of the HTTP  */
+/*                     server and cloud clients.      */
+/*                                                    */
+/* Input params:       HttpServer *pServer - Server   */
+/*                     that got the request.          */
+/*                     int iConnection - Connection   */
+/*                     of the request.                */
+/* Output params:                                     */
+/******************************************************/
+void handleServerReport(HttpServer *pServer, int iConnection)
+{
+  String message = "connections ";
+  message += pServer->getConnectionCount();
+  message += "\nconnections_peak ";
+  message += pServer->getPeakConnectionCount();
+  message += "\nstreams ";
+  message += pServer->getStreamCount();
+  message += "\naccepted ";
+  message += pServer->getAcceptedCount();
+  message += "\nrejected ";
+  message += pServer->getRejectedCount();
+  message += "\nparts_skipped ";
+  message += pServer->getSkippedPartCount();
+  message += "\naccept_poll_interval_last_ms ";
+  message += pServer->getLastAcceptPollInterval();
+  message += "\naccept_poll_interval_max_ms ";
+  message += pServer->getMaxAcceptPollInterval();
+  message += "\nresponse_latency_max_ms ";
+  message += pServer->getMaxResponseLatency();
+  message += "\ncloud_latency_last_ms ";
+  message += hgcPanTiltClient.getLastLatency();
+  message += " ";
+  message += hgcMovementClient.getLastLatency();
+  message += "\ncloud_failed ";
+  message += hgcPanTiltClient.getFailedCount();
+  message += " ";
+  message += hgcMovementClient.getFailedCount();
+  message += "\n";
+  pServer->send(iConnection, 200, "text/plain", message.c_str());
 }
 
 /******************************************************/
@@ -176,20 +418,23 @@ void handleJpegStream(void)
 /* Method description: Function to erros on image     */
 /*                     handle.                        */
 /*                                                    */
-/* Input params:                                      */
+/* Input params:       HttpServer *pServer - Server   */
+/*                     that got the request.          */
+/*                     int iConnection - Connection   */
+/*                     of the request.                */
 /* Output params:                                     */
 /******************************************************/
-void handleNotFound()
+void handleNotFound(HttpServer *pServer, int iConnection)
 {
   String message = "Server is running!\n\n";
   message += "URI: ";
-  message += wsServer.uri();
+  message += pServer->getPath(iConnection);
   message += "\nMethod: ";
-  message += (wsServer.method() == HTTP_GET) ? "GET" : "POST";
+  message += pServer->getMethod(iConnection);
   message += "\nArguments: ";
-  message += wsServer.args();
+  message += pServer->getArgCount(iConnection);
   message += "\n";
-  wsServer.send(200, "text / plain", message);
+  pServer->send(iConnection, 200, "text / plain", message.c_str());
 }
 
 /******************************************************/
@@ -199,9 +444,10 @@ void handleNotFound()
 /*                     fast streaming.                */
 /*                                                    */
 /* Input params:                                      */
-/* Output params:                                     */
+/* Output params:      esp_err_t - ESP_OK if the      */
+/*                     camera was found.              */
 /******************************************************/
-void initCamera(void)
+esp_err_t initCamera(void)
 {
   camera_config_t config;
   config.ledc_channel = LEDC_CHANNEL_0;
@@ -235,68 +481,297 @@ void initCamera(void)
   pinMode(14, INPUT_PULLUP);
 #endif
 
-  ovCam.init(config);
+  return ovCam.init(config);
 }
 
 /******************************************************/
-/* Method name:        handleVariables                */
-/* Method description: Function to apply the update of*/
-/*                     the variables necessary for    */
-/*                     movement and distance          */
-/*                     measurement.                   */
+/* Method name:        applyPanTilt                   */
+/* Method description: Function to apply the Pan Tilt */
+/*                     setpoints read from the cloud. */
 /*                                                    */
-/* Input params:                                      */
+/* Input params:       const char *cPayload - JSON    */
+/*                     array of the two axes.         */
 /* Output params:                                     */
 /******************************************************/
-void handleVariables(void) {
-  // Pan Tilt Variables
-  int httpCode = httpClientPanTilt.GET();
-  String payload = httpClientPanTilt.getString();
-  JSONVar myArray = JSON.parse(payload);
+void applyPanTilt(const char *cPayload)
+{
+  srSessionRecorder.recordText(SESSION_RECORD_PANTILT, cPayload, millis());
+  JSONVar myArray = JSON.parse(cPayload);
   iAxisX = JSON.parse(myArray[0]);
   iAxisY = JSON.parse(myArray[1]);
-  // Movement Variables
-  httpCode = httpClientMovement.GET();
-  payload = httpClientMovement.getString();
-  myArray = JSON.parse(payload);
+  // Same time base as the interrupt, read while it can not run
+  portENTER_CRITICAL(&muxSetpoint);
+  srPanSetpoint.newSetpoint(iAxisX, ui32ContMiliseconds);
+  srTiltSetpoint.newSetpoint(iAxisY, ui32ContMiliseconds);
+  portEXIT_CRITICAL(&muxSetpoint);
+}
+
+/******************************************************/
+/* Method name:        applyMovement                  */
+/* Method description: Function to apply the motor    */
+/*                     setpoints read from the cloud. */
+/*                                                    */
+/* Input params:       const char *cPayload - JSON    */
+/*                     array of the two axes.         */
+/* Output params:                                     */
+/******************************************************/
+void applyMovement(const char *cPayload)
+{
+  srSessionRecorder.recordText(SESSION_RECORD_MOVEMENT, cPayload, millis());
+  JSONVar myArray = JSON.parse(cPayload);
   iTempX = JSON.parse(myArray[0]);
   iTempY = JSON.parse(myArray[1]);
   iLeftMotorPosition = 511 + (iTempY - 511) - (iTempX - 511) * 0.40;
   iRightMotorPosition = 511 + (iTempY - 511) + (iTempX - 511) * 0.40;
-  // Sensor Variables
+}
+
+/******************************************************/
+/* Method name:        updateFloorSensor              */
+/* Method description: Function to measure the floor  */
+/*                     distance, which stops the car  */
+/*                     at a cliff.                    */
+/*                                                    */
+/* Input params:                                      */
+/* Output params:                                     */
+/******************************************************/
+void updateFloorSensor(void)
+{
   iFloorDistance = ssFloorSensor.getDistance();
+  srSessionRecorder.recordValue(SESSION_RECORD_SONAR, ssFloorSensor.getEchoDuration(), millis());
   if (FRONT_SENSOR_STOP_DISTANCE < iFloorDistance)bThereIsNoFloor = true;
   else bThereIsNoFloor = false;
 }
+
 /******************************************************/
-/* Method name:        initWiFi                       */
-/* Method description: Set up Wifi connection, to the */
-/*                     desired WiFi Network, and print*/
-/*                     the current link for the       */
-/*                     streaming.                     */
+/* Method name:        updateControl                  */
+/* Method description: Function to read the cloud     */
+/*                     setpoints and the floor sensor */
+/*                     on their own periods, with or  */
+/*                     without streams. The cloud     */
+/*                     requests run beside the loop,  */
+/*                     each client asks again only    */
+/*                     once its last answer is in.    */
+/*                                                    */
+/* Input params:       unsigned long ulNowMs - Current*/
+/*                     time in ms.                    */
+/* Output params:                                     */
+/******************************************************/
+void updateControl(unsigned long ulNowMs)
+{
+  if (hgcPanTiltClient.poll(ulNowMs) == HTTP_GET_DONE && hgcPanTiltClient.getStatus() == 200) {
+    applyPanTilt(hgcPanTiltClient.getBody());
+  }
+  if (hgcMovementClient.poll(ulNowMs) == HTTP_GET_DONE && hgcMovementClient.getStatus() == 200) {
+    applyMovement(hgcMovementClient.getBody());
+  }
+  if (CONTROL_CLOUD_PERIOD_MS <= ulNowMs - ulLastCloudMs) {
+    ulLastCloudMs = ulNowMs;
+    hgcPanTiltClient.request(ulNowMs);
+    hgcMovementClient.request(ulNowMs);
+  }
+  if (CONTROL_SONAR_PERIOD_MS <= ulNowMs - ulLastSonarMs) {
+    ulLastSonarMs = ulNowMs;
+    updateFloorSensor();
+  }
+}
+/******************************************************/
+/* Method name:        beginWiFi                      */
+/* Method description: Starts the connection to the   */
+/*                     desired WiFi Network without   */
+/*                     waiting for it. When the       */
+/*                     channel and BSSID of the last  */
+/*                     connection are cached the scan */
+/*                     is skipped.                    */
 /*                                                    */
 /* Input params:                                      */
 /* Output params:                                     */
 /******************************************************/
-void initWiFi(void)
+void beginWiFi(void)
 {
-  IPAddress ip;
+  uint8_t ui8Bssid[6];
+  int iChannel;
+
+  WiFi.persistent(false);
   WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PWD);
-  while (WiFi.status() != WL_CONNECTED)
+#ifdef WIFI_STATIC_IP
+  WiFi.config(IPAddress(WIFI_STATIC_IP), IPAddress(WIFI_GATEWAY), IPAddress(WIFI_SUBNET));
+#endif
+  prefWiFiCache.begin("urs-wifi", true);
+  iChannel = prefWiFiCache.getInt("channel", 0);
+  bWiFiFastConnect = (0 < iChannel) && (sizeof(ui8Bssid) == prefWiFiCache.getBytes("bssid", ui8Bssid, sizeof(ui8Bssid)));
+  prefWiFiCache.end();
+
+  ulWiFiBeginMs = millis();
+  if (bWiFiFastConnect) WiFi.begin(WIFI_SSID, WIFI_PWD, iChannel, ui8Bssid);
+  else WiFi.begin(WIFI_SSID, WIFI_PWD);
+}
+
+/******************************************************/
+/* Method name:        isWiFiConnected                */
+/* Method description: Polls the WiFi link started by */
+/*                     beginWiFi, retrying with a full*/
+/*                     scan if the cached access point*/
+/*                     does not answer, and caches the*/
+/*                     channel and BSSID of the new   */
+/*                     link.                          */
+/*                                                    */
+/* Input params:                                      */
+/* Output params:      bool - true once connected.    */
+/******************************************************/
+bool isWiFiConnected(void)
+{
+  uint8_t ui8Bssid[6];
+  int iChannel;
+
+  if (WiFi.status() != WL_CONNECTED)
   {
-    delay(500);
-    Serial.print(F("."));
+    if (bWiFiFastConnect && WIFI_FAST_CONNECT_TIMEOUT_MS < millis() - ulWiFiBeginMs) {
+      // The access point changed, forget it and scan
+      bWiFiFastConnect = false;
+      WiFi.disconnect();
+      WiFi.begin(WIFI_SSID, WIFI_PWD);
+    }
+    return false;
+  }
+
+  prefWiFiCache.begin("urs-wifi", false);
+  iChannel = prefWiFiCache.getInt("channel", 0);
+  if (sizeof(ui8Bssid) != prefWiFiCache.getBytes("bssid", ui8Bssid, sizeof(ui8Bssid)) ||
+      iChannel != WiFi.channel() || memcmp(ui8Bssid, WiFi.BSSID(), sizeof(ui8Bssid)) != 0) {
+    prefWiFiCache.putInt("channel", WiFi.channel());
+    prefWiFiCache.putBytes("bssid", WiFi.BSSID(), sizeof(ui8Bssid));
   }
+  prefWiFiCache.end();
+  return true;
+}
+
+/******************************************************/
+/* Method name:        parkServos                     */
+/* Method description: Puts every servo in its rest   */
+/*                     position.                      */
+/*                                                    */
+/* Input params:                                      */
+/* Output params:                                     */
+/******************************************************/
+void parkServos(void)
+{
+  cptCameraPanTiltControl.updatePosition(iAxisX, iAxisY);
+  mcMovementControl.updateMovement(iLeftMotorPosition, iRightMotorPosition);
+}
+
+/******************************************************/
+/* Method name:        startCamera                    */
+/* Method description: Probes the camera and hands it */
+/*                     to the capture manager.        */
+/*                                                    */
+/* Input params:                                      */
+/* Output params:                                     */
+/******************************************************/
+void startCamera(void)
+{
+  cmCaptureManager.begin(initCamera() == ESP_OK, CAMERA_KEEPALIVE, recordKeepAliveFrame);
+}
+
+/******************************************************/
+/* Method name:        startControlTimer              */
+/* Method description: Starts the 1 ms control timer. */
+/*                                                    */
+/* Input params:                                      */
+/* Output params:                                     */
+/******************************************************/
+void startControlTimer(void)
+{
+  initTimerAlarm(1, 80, 1000); // Create Timer of 1 MHz with an alarm of 1 ms
+}
+
+/******************************************************/
+/* Method name:        beginClients                   */
+/* Method description: Sets up the cloud HTTP clients,*/
+/*                     looking the server up once.    */
+/*                                                    */
+/* Input params:                                      */
+/* Output params:                                     */
+/******************************************************/
+void beginClients(void)
+{
+  if (!hgcPanTiltClient.begin(cPanTiltServerName, millis())) Serial.println("Pan Tilt server not found");
+  if (!hgcMovementClient.begin(cMovementServerName, millis())) Serial.println("Movement server not found");
+}
+
+/******************************************************/
+/* Method name:        waitBootStage                  */
+/* Method description: Pause between the polls of the */
+/*                     unfinished boot stages.        */
+/*                                                    */
+/* Input params:                                      */
+/* Output params:                                     */
+/******************************************************/
+void waitBootStage(void)
+{
+  delay(WIFI_CONNECT_POLL_MS);
+}
+
+/******************************************************/
+/* Method name:        handleBootReport               */
+/* Method description: Function to send the timing of */
+/*                     each boot stage.               */
+/*                                                    */
+/* Input params:       HttpServer *pServer - Server   */
+/*                     that got the request.          */
+/*                     int iConnection - Connection   */
+/*                     of the request.                */
+/* Output params:                                     */
+/******************************************************/
+void handleBootReport(HttpServer *pServer, int iConnection)
+{
+  int iLastStage;
+  unsigned long ulCriticalPath = bsBootSequencer.getCriticalPath(&iLastStage);
+  String message = "stage start_ms duration_ms\n";
+  for (int iStage = 0; iStage < BOOT_STAGE_COUNT; iStage++) {
+    message += bsBootSequencer.getStageName(iStage);
+    message += " ";
+    message += bsBootSequencer.getStageStart(iStage);
+    message += " ";
+    message += bsBootSequencer.getStageDuration(iStage);
+    message += "\n";
+  }
+  message += "boot_ms ";
+  message += bsBootSequencer.getBootDuration();
+  message += "\ncritical_path_ms ";
+  message += ulCriticalPath;
+  message += " (ends at ";
+  message += bsBootSequencer.getStageName(iLastStage);
+  message += ")\nwifi_fast_connect ";
+  message += bWiFiFastConnect ? "yes" : "no";
+  message += "\n";
+  pServer->send(iConnection, 200, "text/plain", message.c_str());
+}
+
+/******************************************************/
+/* Method name:        initServer                     */
+/* Method description: Set up the streaming server and*/
+/*                     print the current link for the */
+/*                     streaming.                     */
+/*                                                    */
+/* Input params:                                      */
+/* Output params:                                     */
+/******************************************************/
+void initServer(void)
+{
+  IPAddress ip;
   ip = WiFi.localIP();
   Serial.println(F("WiFi connected"));
   Serial.println("");
   Serial.print("Stream Link: http://");
   Serial.print(ip);
   Serial.println("/mjpeg/1");
-  wsServer.on("/mjpeg/1", HTTP_GET, handleJpegStream);
-  wsServer.onNotFound(handleNotFound);
-  wsServer.begin();
+  hsServer.on("/mjpeg/1", handleJpegStream);
+  hsServer.on("/boot", handleBootReport);
+  hsServer.on("/capture", handleCaptureReport);
+  hsServer.on("/session", handleSessionDownload);
+  hsServer.on("/server", handleServerReport);
+  hsServer.onNotFound(handleNotFound);
+  if (!hsServer.begin(80, millis())) Serial.println("HTTP server failed to listen");
 }
 
 /******************************************************/
@@ -309,12 +784,35 @@ void initWiFi(void)
 /******************************************************/
 void setup()
 {
+  int iBlockedStage;
+
   Serial.begin(115200);
-  initCamera();
-  initWiFi();
-  httpClientPanTilt.begin(cPanTiltServerName);
-  httpClientMovement.begin(cMovementServerName);
-  initTimerAlarm(1, 80, 1000); // Create Timer of 1 MHz with an alarm of 1 ms
+  bsBootSequencer.begin(millis());
+  if (0 < SESSION_BUFFER_SIZE) {
+    srSessionRecorder.begin((uint8_t *)ps_malloc(SESSION_BUFFER_SIZE), SESSION_BUFFER_SIZE, SESSION_FRAME_CONTENT_EVERY);
+  }
+  // Without them every stream waits for the slowest one
+  for (int iSlot = 0; iSlot < STREAM_FRAME_SLOTS; iSlot++) {
+    pFrameSlots[iSlot] = (uint8_t *)ps_malloc(STREAM_FRAME_SLOT_SIZE);
+  }
+
+  // The order comes from the BootSequencer dependency table, the WiFi
+  // stack associates in background while the camera is probed
+  bsBootSequencer.setStage(BOOT_STAGE_SERVOS, parkServos, NULL);
+  bsBootSequencer.setStage(BOOT_STAGE_WIFI, beginWiFi, isWiFiConnected);
+  bsBootSequencer.setStage(BOOT_STAGE_CAMERA, startCamera, NULL);
+  bsBootSequencer.setStage(BOOT_STAGE_TIMER, startControlTimer, NULL);
+  bsBootSequencer.setStage(BOOT_STAGE_SERVER, initServer, NULL);
+  bsBootSequencer.setStage(BOOT_STAGE_CLIENTS, beginClients, NULL);
+  if (!bsBootSequencer.run(millis, waitBootStage, &iBlockedStage)) {
+    // The dependency table is wrong, nothing past the parked servos is safe
+    Serial.print("Boot stage can not start: ");
+    Serial.println(bsBootSequencer.getStageName(iBlockedStage));
+    while (true) delay(1000);
+  }
+
+  Serial.print("Boot time (ms): ");
+  Serial.println(bsBootSequencer.getBootDuration());
 }
 
 /******************************************************/
@@ -328,5 +826,13 @@ void setup()
 /******************************************************/
 void loop()
 {
-  wsServer.handleClient();
+  // Serves every connection without blocking on any of them
+  hsServer.poll(millis());
+  sendStreamFrame();
+  // Cloud setpoints and the cliff check, whether streaming or not
+  updateControl(millis());
+  // Resumes the camera, parks it when nobody is watching
+  cmCaptureManager.update();
+  // A failed resume dropped the consumers, its streams get no frame
+  if (hsServer.getStreamCount() && cmCaptureManager.getConsumerCount() == 0) hsServer.endStreams();
 }
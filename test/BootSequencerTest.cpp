@@ -0,0 +1,270 @@
+/**************************************************/
+/* File name:        BootSequencerTest.cpp        */
+/* File description: Host simulation of the URS   */
+/*                   boot, checking the stage     */
+/*                   order and the critical path  */
+/*                   of BootSequencer in virtual  */
+/*                   time.                        */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include "BootSequencer.h"
+
+// Defines
+#define SERVOS_MS                        5
+#define CAMERA_MS                        800  // Sensor probe and buffers
+#define TIMER_MS                         1
+#define SERVER_MS                        20
+#define CLIENTS_MS                       5
+#define POLL_MS                          10   // As WIFI_CONNECT_POLL_MS
+
+#define CHECK(bCondition) check((bCondition), #bCondition, __LINE__)
+
+// Variables
+unsigned long ulVirtualMs = 0;
+unsigned long ulWiFiDelayMs = 0;
+unsigned long ulWiFiReadyMs = 0;
+int iStartOrder[BOOT_STAGE_COUNT];
+int iStartCount = 0;
+int iFailures = 0;
+
+/****************************************************/
+/* Method name:        check                        */
+/* Method description: Reports a failed check.      */
+/*                                                  */
+/* Input params:       bCondition - Result. (bool)  */
+/*                     cText - Checked expression.  */
+/*                     (const char*)                */
+/*                     iLine - Source line. (int)   */
+/* Output params:                                   */
+/****************************************************/
+void check(bool bCondition, const char *cText, int iLine)
+{
+  if (bCondition) return;
+  printf("FAIL line %d: %s\n", iLine, cText);
+  iFailures++;
+}
+
+/****************************************************/
+/* Method name:        virtualClock, virtualWait    */
+/* Method description: Time source and poll pause of*/
+/*                     the simulation.              */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Time in ms.                  */
+/****************************************************/
+unsigned long virtualClock(void)
+{
+  return ulVirtualMs;
+}
+
+void virtualWait(void)
+{
+  ulVirtualMs += POLL_MS;
+}
+
+/****************************************************/
+/* Method name:        stage functions              */
+/* Method description: Fake stages that take their  */
+/*                     typical time and record the  */
+/*                     order they were started in.  */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void started(int iStage, unsigned long ulDurationMs)
+{
+  iStartOrder[iStartCount++] = iStage;
+  ulVirtualMs += ulDurationMs;
+}
+
+void startServos(void)  { started(BOOT_STAGE_SERVOS, SERVOS_MS); }
+void startCamera(void)  { started(BOOT_STAGE_CAMERA, CAMERA_MS); }
+void startTimer(void)   { started(BOOT_STAGE_TIMER, TIMER_MS); }
+void startServer(void)  { started(BOOT_STAGE_SERVER, SERVER_MS); }
+void startClients(void) { started(BOOT_STAGE_CLIENTS, CLIENTS_MS); }
+
+void startWiFi(void)
+{
+  // Associates in background
+  started(BOOT_STAGE_WIFI, 0);
+  ulWiFiReadyMs = ulVirtualMs + ulWiFiDelayMs;
+}
+
+bool isWiFiUp(void)
+{
+  return ulWiFiReadyMs <= ulVirtualMs;
+}
+
+/****************************************************/
+/* Method name:        setURSStages                 */
+/* Method description: Sets the stages as setup()   */
+/*                     does.                        */
+/*                                                  */
+/* Input params:       pSequencer - Sequencer.      */
+/*                     (BootSequencer*)             */
+/* Output params:                                   */
+/****************************************************/
+void setURSStages(BootSequencer *pSequencer)
+{
+  pSequencer->setStage(BOOT_STAGE_SERVOS, startServos, NULL);
+  pSequencer->setStage(BOOT_STAGE_WIFI, startWiFi, isWiFiUp);
+  pSequencer->setStage(BOOT_STAGE_CAMERA, startCamera, NULL);
+  pSequencer->setStage(BOOT_STAGE_TIMER, startTimer, NULL);
+  pSequencer->setStage(BOOT_STAGE_SERVER, startServer, NULL);
+  pSequencer->setStage(BOOT_STAGE_CLIENTS, startClients, NULL);
+}
+
+/****************************************************/
+/* Method name:        checkDependencyOrder         */
+/* Method description: Checks that no stage started */
+/*                     before the ones it depends on*/
+/*                     finished.                    */
+/*                                                  */
+/* Input params:       pSequencer - Sequencer after */
+/*                     the boot. (BootSequencer*)   */
+/* Output params:                                   */
+/****************************************************/
+void checkDependencyOrder(BootSequencer *pSequencer)
+{
+  const int iDependencies[][2] = {
+    { BOOT_STAGE_TIMER,   BOOT_STAGE_SERVOS },
+    { BOOT_STAGE_TIMER,   BOOT_STAGE_WIFI },
+    { BOOT_STAGE_SERVER,  BOOT_STAGE_WIFI },
+    { BOOT_STAGE_SERVER,  BOOT_STAGE_CAMERA },
+    { BOOT_STAGE_CLIENTS, BOOT_STAGE_WIFI },
+  };
+  for (unsigned int uiPair = 0; uiPair < sizeof(iDependencies) / sizeof(iDependencies[0]); uiPair++) {
+    int iStage = iDependencies[uiPair][0];
+    int iDependency = iDependencies[uiPair][1];
+    unsigned long ulDependencyEnd = pSequencer->getStageStart(iDependency) + pSequencer->getStageDuration(iDependency);
+    if (pSequencer->getStageStart(iStage) < ulDependencyEnd) {
+      printf("FAIL %s started at %lu ms, before %s finished at %lu ms\n", pSequencer->getStageName(iStage),
+             pSequencer->getStageStart(iStage), pSequencer->getStageName(iDependency), ulDependencyEnd);
+      iFailures++;
+    }
+  }
+}
+
+/****************************************************/
+/* Method name:        simulateBoot                 */
+/* Method description: Runs the URS boot with a     */
+/*                     given WiFi association time  */
+/*                     and checks its timing.       */
+/*                                                  */
+/* Input params:       cName - Scenario. (const     */
+/*                     char*)                       */
+/*                     ulWiFiMs - Association time. */
+/*                     (unsigned long)              */
+/*                     iExpectedLastStage - Stage   */
+/*                     ending the critical path.    */
+/*                     (int)                        */
+/*                     ulExpectedCriticalMs -       */
+/*                     Critical path. (unsigned     */
+/*                     long)                        */
+/* Output params:                                   */
+/****************************************************/
+void simulateBoot(const char *cName, unsigned long ulWiFiMs, int iExpectedLastStage, unsigned long ulExpectedCriticalMs)
+{
+  BootSequencer bsSequencer;
+  int iBlockedStage;
+  int iLastStage;
+
+  ulVirtualMs = 1000;
+  ulWiFiDelayMs = ulWiFiMs;
+  iStartCount = 0;
+  bsSequencer.begin(ulVirtualMs);
+  setURSStages(&bsSequencer);
+  CHECK(bsSequencer.run(virtualClock, virtualWait, &iBlockedStage));
+  CHECK(iBlockedStage == -1);
+  CHECK(bsSequencer.isBootFinished());
+  CHECK(iStartCount == BOOT_STAGE_COUNT);
+  checkDependencyOrder(&bsSequencer);
+
+  unsigned long ulCriticalMs = bsSequencer.getCriticalPath(&iLastStage);
+  printf("%s: boot %lu ms, critical path %lu ms ending at %s, order", cName,
+         bsSequencer.getBootDuration(), ulCriticalMs, bsSequencer.getStageName(iLastStage));
+  for (int iStart = 0; iStart < iStartCount; iStart++) printf(" %s", bsSequencer.getStageName(iStartOrder[iStart]));
+  printf("\n");
+
+  // WiFi and the camera overlap, the camera is probed while associating
+  CHECK(bsSequencer.getStageStart(BOOT_STAGE_CAMERA) <
+        bsSequencer.getStageStart(BOOT_STAGE_WIFI) + bsSequencer.getStageDuration(BOOT_STAGE_WIFI));
+  CHECK(iLastStage == iExpectedLastStage);
+  CHECK(ulCriticalMs == ulExpectedCriticalMs);
+  // Stages off the critical path only cost what runs after it
+  CHECK(ulCriticalMs <= bsSequencer.getBootDuration());
+  CHECK(bsSequencer.getBootDuration() <= ulCriticalMs + SERVOS_MS + TIMER_MS + CLIENTS_MS);
+}
+
+/****************************************************/
+/* Method name:        checkRefusals                */
+/* Method description: Checks that stages are not   */
+/*                     started out of order and that*/
+/*                     a table that can not finish  */
+/*                     is reported.                 */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkRefusals(void)
+{
+  BootSequencer bsSequencer;
+  int iBlockedStage;
+
+  // The timer interrupt must not run before the WiFi NVS access
+  bsSequencer.begin(0);
+  CHECK(bsSequencer.startStage(BOOT_STAGE_SERVOS, 0));
+  bsSequencer.finishStage(BOOT_STAGE_SERVOS, 5);
+  CHECK(!bsSequencer.startStage(BOOT_STAGE_TIMER, 5));
+  CHECK(bsSequencer.startStage(BOOT_STAGE_WIFI, 5));
+  CHECK(!bsSequencer.startStage(BOOT_STAGE_TIMER, 6));
+  bsSequencer.finishStage(BOOT_STAGE_WIFI, 300);
+  CHECK(bsSequencer.startStage(BOOT_STAGE_TIMER, 300));
+  CHECK(!bsSequencer.startStage(BOOT_STAGE_TIMER, 301));
+
+  // Dependencies on later stages would allow cycles
+  CHECK(!bsSequencer.setDependencies(BOOT_STAGE_WIFI, BOOT_STAGE_MASK(BOOT_STAGE_SERVER)));
+  CHECK(!bsSequencer.setDependencies(BOOT_STAGE_CAMERA, BOOT_STAGE_MASK(BOOT_STAGE_CAMERA)));
+  CHECK(bsSequencer.setDependencies(BOOT_STAGE_CAMERA, BOOT_STAGE_MASK(BOOT_STAGE_WIFI)));
+
+  // A stage without a start function blocks its dependents
+  BootSequencer bsMissing;
+  ulVirtualMs = 0;
+  ulWiFiDelayMs = 100;
+  iStartCount = 0;
+  bsMissing.begin(0);
+  setURSStages(&bsMissing);
+  bsMissing.setStage(BOOT_STAGE_CAMERA, NULL, NULL);
+  CHECK(!bsMissing.run(virtualClock, virtualWait, &iBlockedStage));
+  CHECK(iBlockedStage == BOOT_STAGE_CAMERA);
+  CHECK(!bsMissing.isStageFinished(BOOT_STAGE_SERVER));
+  CHECK(bsMissing.isStageFinished(BOOT_STAGE_CLIENTS));
+}
+
+/****************************************************/
+/* Method name:        main                         */
+/* Method description: Runs every scenario.         */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      0 if every check passed.     */
+/*                     (int)                        */
+/****************************************************/
+int main(void)
+{
+  // Cached BSSID: WiFi is up before the camera, the camera is critical
+  simulateBoot("fast reconnect", 300, BOOT_STAGE_SERVER, CAMERA_MS + SERVER_MS);
+  // Full scan and DHCP: WiFi is critical, the camera is hidden behind it
+  simulateBoot("full scan", 2500, BOOT_STAGE_SERVER, 2500 + SERVER_MS);
+  checkRefusals();
+
+  if (iFailures) {
+    printf("%d check(s) failed\n", iFailures);
+    return 1;
+  }
+  printf("BootSequencerTest passed\n");
+  return 0;
+}
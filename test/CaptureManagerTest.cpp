@@ -0,0 +1,416 @@
+/**************************************************/
+/* File name:        CaptureManagerTest.cpp       */
+/* File description: Drives the CaptureManager    */
+/*                   states through the OV2640    */
+/*                   class on a stand-in camera   */
+/*                   driver, in virtual time.     */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "CaptureManager.h"
+#include "Shim.h"
+
+// Defines
+#define FULL_XCLK_HZ                     10000000 // As initCamera
+#define FULL_FRAME_MS                    40
+#define KEEPALIVE_FRAME_MS               250  // One frame on demand at the low clock
+#define FRAME_LENGTH                     3000
+#define DRIVER_TIMEOUT_MS                4000 // esp_camera_fb_get gives up on a frame
+#define HANG_REAL_MS                     2000 // Real time a hang lasts if nobody ends it
+#define RESUME_POLLS                     5000 // Loop turns given to a resume
+#define HUNG_POLL_MS                     10   // Loop time between turns on a hung driver
+#define UPDATE_BOUND_MS                  50   // Longest real time of one update
+
+#define CHECK(bCondition) check((bCondition), #bCondition, __LINE__)
+
+// Variables
+int iFailures = 0;
+uint8_t ui8Jpeg[FRAME_LENGTH];
+camera_fb_t cfFrame = { ui8Jpeg, FRAME_LENGTH, 320, 240, PIXFORMAT_JPEG };
+int iGrabs = 0;
+bool bHung = false;
+std::mutex mHang;
+std::condition_variable cvHang;
+int iKeepAliveFrames = 0;
+size_t stKeepAliveLength = 0;
+
+/****************************************************/
+/* Method name:        check                        */
+/* Method description: Reports a failed check.      */
+/*                                                  */
+/* Input params:       bCondition - Result. (bool)  */
+/*                     cText - Checked expression.  */
+/*                     (const char*)                */
+/*                     iLine - Source line. (int)   */
+/* Output params:                                   */
+/****************************************************/
+void check(bool bCondition, const char *cText, int iLine)
+{
+  if (bCondition) return;
+  printf("FAIL line %d: %s\n", iLine, cText);
+  iFailures++;
+}
+
+/****************************************************/
+/* Method name:        grabFrame                    */
+/* Method description: Stand-in for the frame wait  */
+/*                     of the driver: a frame period*/
+/*                     of the current clock, or     */
+/*                     stuck until released or the  */
+/*                     driver timeout.              */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Frame, NULL when released    */
+/*                     from a hang. (camera_fb_t*)  */
+/****************************************************/
+camera_fb_t *grabFrame(void)
+{
+  {
+    std::unique_lock<std::mutex> lock(mHang);
+    if (bHung) {
+      // Left alone it ends as the driver does, late enough to fail a bound
+      if (!cvHang.wait_for(lock, std::chrono::milliseconds(HANG_REAL_MS), []() { return !bHung; })) {
+        shimAdvanceMillis(DRIVER_TIMEOUT_MS);
+      }
+      return NULL;
+    }
+    iGrabs++;
+  }
+  bool bFull = shimGetCameraConfig().xclk_freq_hz == FULL_XCLK_HZ;
+  shimAdvanceMillis(bFull ? FULL_FRAME_MS : KEEPALIVE_FRAME_MS);
+  return &cfFrame;
+}
+
+/****************************************************/
+/* Method name:        setHung                      */
+/* Method description: Makes the driver stop or     */
+/*                     start answering.             */
+/*                                                  */
+/* Input params:       bHang - Stuck. (bool)        */
+/* Output params:                                   */
+/****************************************************/
+void setHung(bool bHang)
+{
+  std::lock_guard<std::mutex> lock(mHang);
+  bHung = bHang;
+  cvHang.notify_all();
+}
+
+/****************************************************/
+/* Method name:        keepAliveFrame               */
+/* Method description: Stand-in for the recorder.   */
+/*                                                  */
+/* Input params:       pJpeg - Frame. (const        */
+/*                     uint8_t*)                    */
+/*                     stLength - Size. (size_t)    */
+/* Output params:                                   */
+/****************************************************/
+void keepAliveFrame(const uint8_t *pJpeg, size_t stLength)
+{
+  if (pJpeg == ui8Jpeg) iKeepAliveFrames++;
+  stKeepAliveLength = stLength;
+}
+
+/****************************************************/
+/* Method name:        startCamera                  */
+/* Method description: Starts the driver as         */
+/*                     initCamera does.             */
+/*                                                  */
+/* Input params:       pCamera - Camera. (OV2640*)  */
+/* Output params:      true if started. (bool)      */
+/****************************************************/
+bool startCamera(OV2640 *pCamera)
+{
+  camera_config_t ccConfig = esp32cam_aithinker_config;
+  ccConfig.xclk_freq_hz = FULL_XCLK_HZ;
+  ccConfig.frame_size = FRAMESIZE_QVGA;
+  ccConfig.fb_count = 2;
+  return pCamera->init(ccConfig) == ESP_OK;
+}
+
+/****************************************************/
+/* Method name:        waitResume                   */
+/* Method description: Calls update as the main loop*/
+/*                     does while the camera        */
+/*                     resumes.                     */
+/*                                                  */
+/* Input params:       pCapture - Manager.          */
+/*                     (CaptureManager*)            */
+/*                     ulStepMs - Loop time between */
+/*                     turns, 0 leaves the clock to */
+/*                     the driver. (unsigned long)  */
+/* Output params:      Longest real time of one     */
+/*                     update in ms. (long)         */
+/****************************************************/
+long waitResume(CaptureManager *pCapture, unsigned long ulStepMs)
+{
+  long lLongestMs = 0;
+
+  for (int iPoll = 0; iPoll < RESUME_POLLS && pCapture->getState() == CAPTURE_STATE_RESUMING; iPoll++) {
+    std::chrono::steady_clock::time_point tpStart = std::chrono::steady_clock::now();
+    pCapture->update();
+    long lUpdateMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tpStart).count();
+    if (lLongestMs < lUpdateMs) lLongestMs = lUpdateMs;
+    if (ulStepMs) shimAdvanceMillis(ulStepMs);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return lLongestMs;
+}
+
+/****************************************************/
+/* Method name:        checkParkAndResume           */
+/* Method description: No consumer parks the camera */
+/*                     after the idle timeout, a new*/
+/*                     one gets it back at full rate*/
+/*                     past the warm up frames, run */
+/*                     by update after acquire has  */
+/*                     returned.                    */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkParkAndResume(void)
+{
+  OV2640 ovCamera;
+  CaptureManager cmCapture(&ovCamera);
+
+  shimSetMillis(1000);
+  CHECK(startCamera(&ovCamera));
+  cmCapture.begin(true, false, keepAliveFrame);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_IDLE);
+
+  int iDeinits = shimGetCameraDeinits();
+  shimSetMillis(1000 + CAPTURE_IDLE_TIMEOUT_MS - 1);
+  cmCapture.update();
+  CHECK(cmCapture.getState() == CAPTURE_STATE_IDLE);
+  shimSetMillis(1000 + CAPTURE_IDLE_TIMEOUT_MS);
+  cmCapture.update();
+  CHECK(cmCapture.getState() == CAPTURE_STATE_PARKED);
+  CHECK(shimGetCameraDeinits() == iDeinits + 1);
+  CHECK(!shimIsCameraRunning());
+
+  // Parked for a while, then a stream connects
+  shimAdvanceMillis(60000);
+  cmCapture.update();
+  iGrabs = 0;
+  unsigned long ulAcquireMs = millis();
+  cmCapture.acquire();
+  CHECK(millis() == ulAcquireMs);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_RESUMING);
+  CHECK(iGrabs == 0);
+  // A second stream joins the resume under way
+  cmCapture.acquire();
+  CHECK(cmCapture.getConsumerCount() == 2);
+  CHECK(waitResume(&cmCapture, 0) <= UPDATE_BOUND_MS);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_STREAMING);
+  CHECK(shimIsCameraRunning());
+  CHECK(shimGetCameraConfig().xclk_freq_hz == FULL_XCLK_HZ);
+  CHECK(shimGetCameraConfig().fb_count == 2);
+  CHECK(iGrabs == CAPTURE_WARMUP_FRAMES + 1);
+  CHECK(cmCapture.getLastFirstFrameLatency() == (CAPTURE_WARMUP_FRAMES + 1) * FULL_FRAME_MS);
+  CHECK(ovCamera.getSize() == FRAME_LENGTH);
+  CHECK(cmCapture.getResumeCount() == 1);
+  CHECK(0 < cmCapture.getStateTime(CAPTURE_STATE_RESUMING));
+
+  // A third stream shares the running camera
+  cmCapture.acquire();
+  CHECK(cmCapture.getState() == CAPTURE_STATE_STREAMING);
+  CHECK(cmCapture.getResumeCount() == 1);
+  cmCapture.release();
+  cmCapture.release();
+  CHECK(cmCapture.getState() == CAPTURE_STATE_STREAMING);
+  cmCapture.release();
+  CHECK(cmCapture.getState() == CAPTURE_STATE_IDLE);
+
+  // Back within the idle timeout, only a fresh frame is waited for
+  iGrabs = 0;
+  cmCapture.acquire();
+  waitResume(&cmCapture, 0);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_STREAMING);
+  CHECK(iGrabs == 1);
+  CHECK(cmCapture.getResumeCount() == 1);
+  cmCapture.release();
+  CHECK(60000 <= cmCapture.getStateTime(CAPTURE_STATE_PARKED));
+  CHECK(iKeepAliveFrames == 0);
+}
+
+/****************************************************/
+/* Method name:        checkKeepAlive               */
+/* Method description: Keep alive slows the camera  */
+/*                     down and hands its periodic  */
+/*                     frames over without holding  */
+/*                     the caller.                  */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkKeepAlive(void)
+{
+  OV2640 ovCamera;
+  CaptureManager cmCapture(&ovCamera);
+
+  shimSetMillis(1000);
+  CHECK(startCamera(&ovCamera));
+  cmCapture.begin(true, true, keepAliveFrame);
+  shimSetMillis(1000 + CAPTURE_IDLE_TIMEOUT_MS);
+  cmCapture.update();
+  CHECK(cmCapture.getState() == CAPTURE_STATE_KEEPALIVE);
+  CHECK(shimGetCameraConfig().xclk_freq_hz == CAPTURE_KEEPALIVE_XCLK_HZ);
+  CHECK(shimGetCameraConfig().fb_count == 1);
+
+  iKeepAliveFrames = 0;
+  for (int iPeriod = 1; iPeriod <= 3; iPeriod++) {
+    unsigned long ulPeriodMs = 1000 + CAPTURE_IDLE_TIMEOUT_MS + iPeriod * CAPTURE_KEEPALIVE_PERIOD_MS;
+    shimSetMillis(ulPeriodMs - 1);
+    cmCapture.update();
+    CHECK(iKeepAliveFrames == iPeriod - 1);
+    shimSetMillis(ulPeriodMs);
+    // The grab runs on its own task, update only picks it up when done
+    for (int iPoll = 0; iPoll < 1000 && iKeepAliveFrames < iPeriod; iPoll++) {
+      cmCapture.update();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(iKeepAliveFrames == iPeriod);
+    CHECK(stKeepAliveLength == FRAME_LENGTH);
+  }
+
+  // A stream brings the full rate back
+  cmCapture.acquire();
+  waitResume(&cmCapture, 0);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_STREAMING);
+  CHECK(shimGetCameraConfig().xclk_freq_hz == FULL_XCLK_HZ);
+  CHECK(shimGetCameraConfig().fb_count == 2);
+  cmCapture.release();
+}
+
+/****************************************************/
+/* Method name:        checkResumeBound             */
+/* Method description: A driver stuck on a frame    */
+/*                     holds neither update nor the */
+/*                     resume past its timeout, and */
+/*                     the camera works again after */
+/*                     it.                          */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkResumeBound(void)
+{
+  OV2640 ovCamera;
+  CaptureManager cmCapture(&ovCamera);
+
+  shimSetMillis(1000);
+  CHECK(startCamera(&ovCamera));
+  cmCapture.begin(true, false, keepAliveFrame);
+  shimSetMillis(1000 + CAPTURE_IDLE_TIMEOUT_MS);
+  cmCapture.update();
+  CHECK(cmCapture.getState() == CAPTURE_STATE_PARKED);
+
+  setHung(true);
+  cmCapture.acquire();
+  CHECK(waitResume(&cmCapture, HUNG_POLL_MS) <= UPDATE_BOUND_MS);
+  CHECK(cmCapture.getLastFirstFrameLatency() <= CAPTURE_RESUME_TIMEOUT_MS + HUNG_POLL_MS);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_IDLE);
+  CHECK(cmCapture.getConsumerCount() == 0);
+
+  // The driver gives up on the frame, the next consumer gets a fresh one
+  setHung(false);
+  cmCapture.acquire();
+  waitResume(&cmCapture, 0);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_STREAMING);
+  CHECK(ovCamera.getSize() == FRAME_LENGTH);
+  cmCapture.release();
+
+  // A camera that fails to start is reported, not waited on
+  shimSetMillis(100000);
+  cmCapture.update();
+  shimSetMillis(100000 + CAPTURE_IDLE_TIMEOUT_MS);
+  cmCapture.update();
+  CHECK(cmCapture.getState() == CAPTURE_STATE_PARKED);
+  shimSetCamera(ESP_FAIL, grabFrame);
+  cmCapture.acquire();
+  waitResume(&cmCapture, 0);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_PARKED);
+  CHECK(cmCapture.getConsumerCount() == 0);
+  shimSetCamera(ESP_OK, grabFrame);
+  cmCapture.acquire();
+  waitResume(&cmCapture, 0);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_STREAMING);
+  cmCapture.release();
+}
+
+/****************************************************/
+/* Method name:        checkKeepAliveGrabBound      */
+/* Method description: A keep alive grab stuck in   */
+/*                     the driver holds neither     */
+/*                     update nor the resume past   */
+/*                     its timeout, and the driver  */
+/*                     is not stopped under it.     */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkKeepAliveGrabBound(void)
+{
+  OV2640 ovCamera;
+  CaptureManager cmCapture(&ovCamera);
+
+  shimSetMillis(1000);
+  CHECK(startCamera(&ovCamera));
+  cmCapture.begin(true, true, keepAliveFrame);
+  shimSetMillis(1000 + CAPTURE_IDLE_TIMEOUT_MS);
+  cmCapture.update();
+  CHECK(cmCapture.getState() == CAPTURE_STATE_KEEPALIVE);
+
+  // The next keep alive grab hangs in the driver
+  setHung(true);
+  shimSetMillis(1000 + CAPTURE_IDLE_TIMEOUT_MS + CAPTURE_KEEPALIVE_PERIOD_MS);
+  cmCapture.update();
+  int iDeinits = shimGetCameraDeinits();
+  cmCapture.acquire();
+  CHECK(waitResume(&cmCapture, HUNG_POLL_MS) <= UPDATE_BOUND_MS);
+  CHECK(cmCapture.getLastFirstFrameLatency() <= CAPTURE_RESUME_TIMEOUT_MS + HUNG_POLL_MS);
+  CHECK(shimGetCameraDeinits() == iDeinits);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_KEEPALIVE);
+  CHECK(cmCapture.getConsumerCount() == 0);
+
+  // Once the driver gives the frame up, the next consumer gets the full rate
+  setHung(false);
+  cmCapture.acquire();
+  waitResume(&cmCapture, 0);
+  CHECK(cmCapture.getState() == CAPTURE_STATE_STREAMING);
+  CHECK(shimGetCameraConfig().xclk_freq_hz == FULL_XCLK_HZ);
+  CHECK(ovCamera.getSize() == FRAME_LENGTH);
+  cmCapture.release();
+}
+
+/****************************************************/
+/* Method name:        main                         */
+/* Method description: Runs every scenario.         */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      0 if every check passed.     */
+/*                     (int)                        */
+/****************************************************/
+int main(void)
+{
+  shimSetCamera(ESP_OK, grabFrame);
+  checkParkAndResume();
+  checkKeepAlive();
+  checkResumeBound();
+  checkKeepAliveGrabBound();
+
+  if (iFailures) {
+    printf("%d check(s) failed\n", iFailures);
+    return 1;
+  }
+  printf("CaptureManagerTest passed\n");
+  return 0;
+}
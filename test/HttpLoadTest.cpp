@@ -0,0 +1,810 @@
+/**************************************************/
+/* File name:        HttpLoadTest.cpp             */
+/* File description: Load generator and checks for*/
+/*                   HttpServer and HttpGetClient */
+/*                   over localhost sockets, in   */
+/*                   real time. The server is     */
+/*                   polled from one thread as in */
+/*                   loop(), the clients are      */
+/*                   threads with blocking        */
+/*                   sockets.                     */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "HttpServer.h"
+#include "HttpGetClient.h"
+
+// Defines
+#define BASE_PORT                        18080
+#define LOAD_CLIENTS                     48   // Below HTTP_MAX_CONNECTIONS with the streams
+#define LOAD_REQUESTS                    20   // Per client, on one kept connection
+#define LOAD_P99_LIMIT_MS                20   // A delayed ACK wait is 40 ms
+#define STREAM_FRAME_SIZE                20000
+#define STREAM_FRAME_PERIOD_MS           20   // 50 fps camera
+#define STREAM_SLOTS                     3    // As STREAM_FRAME_SLOTS
+#define STREAM_RUN_MS                    3000
+#define SLOW_READ_BYTES                  2048 // Slow viewer, 100 kB/s
+#define SLOW_READ_PERIOD_MS              20
+#define EXTRA_CONNECTIONS                10
+#define OVERLOAD_CLIENTS                 400  // At once against HTTP_MAX_CONNECTIONS slots
+#define OVERLOAD_REQUESTS                10   // Per admitted client, holding its slot
+#define OVERLOAD_ACCEPT_LIMIT_MS         50   // One poll turns hundreds away
+#define CLIENT_POLL_LIMIT_MS             5    // Longest a client poll may take
+#define LWIP_SEND_BUFFER                 5744 // TCP_SND_BUF of the ESP32 lwIP
+#define CLOUD_BODY                       "[\"511\",\"600\"]"
+
+#define CHECK(bCondition) check((bCondition), #bCondition, __LINE__)
+
+// Variables
+int iFailures = 0;
+HttpServer hsServer;
+uint16_t ui16ServerPort = 0;
+uint8_t ui8Slots[STREAM_SLOTS][STREAM_FRAME_SIZE];
+std::atomic<bool> bRunning(true);
+
+extern "C" int __real_accept(int iSocket, struct sockaddr *pAddress, socklen_t *pLength);
+
+/****************************************************/
+/* Method name:        __wrap_accept                */
+/* Method description: Gives the accepted sockets   */
+/*                     the send buffer of lwIP, the */
+/*                     host one grows to megabytes  */
+/*                     and would hide a slow viewer.*/
+/*                     Linked with --wrap=accept.   */
+/*                                                  */
+/* Input params:       As accept.                   */
+/* Output params:      As accept. (int)             */
+/****************************************************/
+extern "C" int __wrap_accept(int iSocket, struct sockaddr *pAddress, socklen_t *pLength)
+{
+  int iAccepted = __real_accept(iSocket, pAddress, pLength);
+  int iBuffer = LWIP_SEND_BUFFER;
+  if (0 <= iAccepted) setsockopt(iAccepted, SOL_SOCKET, SO_SNDBUF, &iBuffer, sizeof(iBuffer));
+  return iAccepted;
+}
+
+/****************************************************/
+/* Method name:        check                        */
+/* Method description: Reports a failed check.      */
+/*                                                  */
+/* Input params:       bCondition - Result. (bool)  */
+/*                     cText - Checked expression.  */
+/*                     (const char*)                */
+/*                     iLine - Source line. (int)   */
+/* Output params:                                   */
+/****************************************************/
+void check(bool bCondition, const char *cText, int iLine)
+{
+  if (bCondition) return;
+  printf("FAIL line %d: %s\n", iLine, cText);
+  iFailures++;
+}
+
+/****************************************************/
+/* Method name:        nowMs                        */
+/* Method description: Monotonic time, far from 0 as*/
+/*                     millis() is after a while.   */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Time in ms. (unsigned long)  */
+/****************************************************/
+unsigned long nowMs(void)
+{
+  struct timespec tsNow;
+  clock_gettime(CLOCK_MONOTONIC, &tsNow);
+  return tsNow.tv_sec * 1000UL + tsNow.tv_nsec / 1000000 + 1000000UL;
+}
+
+/****************************************************/
+/* Method name:        sleepMs                      */
+/* Method description: Waits some ms.               */
+/*                                                  */
+/* Input params:       ulMs - Time. (unsigned long) */
+/* Output params:                                   */
+/****************************************************/
+void sleepMs(unsigned long ulMs)
+{
+  usleep(ulMs * 1000);
+}
+
+/****************************************************/
+/* Method name:        connectTo                    */
+/* Method description: Blocking connection to a     */
+/*                     local port, reads time out.  */
+/*                                                  */
+/* Input params:       ui16Port - Port. (uint16_t)  */
+/*                     iReceiveBuffer - Socket      */
+/*                     buffer, 0 keeps the default. */
+/*                     (int)                        */
+/* Output params:      Socket, -1 on error. (int)   */
+/****************************************************/
+int connectTo(uint16_t ui16Port, int iReceiveBuffer)
+{
+  struct sockaddr_in saAddress;
+  struct timeval tvTimeout = {3, 0};
+  int iSocket = socket(AF_INET, SOCK_STREAM, 0);
+  if (iSocket < 0) return -1;
+  if (iReceiveBuffer) setsockopt(iSocket, SOL_SOCKET, SO_RCVBUF, &iReceiveBuffer, sizeof(iReceiveBuffer));
+  setsockopt(iSocket, SOL_SOCKET, SO_RCVTIMEO, &tvTimeout, sizeof(tvTimeout));
+  memset(&saAddress, 0, sizeof(saAddress));
+  saAddress.sin_family = AF_INET;
+  saAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  saAddress.sin_port = htons(ui16Port);
+  if (connect(iSocket, (struct sockaddr *)&saAddress, sizeof(saAddress)) < 0) {
+    close(iSocket);
+    return -1;
+  }
+  return iSocket;
+}
+
+/****************************************************/
+/* Method name:        readResponse                 */
+/* Method description: Reads one response with a    */
+/*                     Content-Length.              */
+/*                                                  */
+/* Input params:       iSocket - Socket. (int)      */
+/*                     pStatus - Status. (int*)     */
+/*                     pBody - Body. (std::string*) */
+/* Output params:      false on error. (bool)       */
+/****************************************************/
+bool readResponse(int iSocket, int *pStatus, std::string *pBody)
+{
+  std::string sResponse;
+  char cChunk[1024];
+  size_t stHeadersEnd;
+
+  while ((stHeadersEnd = sResponse.find("\r\n\r\n")) == std::string::npos) {
+    int iReceived = recv(iSocket, cChunk, sizeof(cChunk), 0);
+    if (iReceived <= 0) return false;
+    sResponse.append(cChunk, iReceived);
+  }
+  *pStatus = atoi(sResponse.c_str() + 9);
+  size_t stLengthAt = sResponse.find("Content-Length: ");
+  if (stLengthAt == std::string::npos || stHeadersEnd < stLengthAt) return false;
+  size_t stLength = strtoul(sResponse.c_str() + stLengthAt + 16, NULL, 10);
+  while (sResponse.size() < stHeadersEnd + 4 + stLength) {
+    int iReceived = recv(iSocket, cChunk, sizeof(cChunk), 0);
+    if (iReceived <= 0) return false;
+    sResponse.append(cChunk, iReceived);
+  }
+  *pBody = sResponse.substr(stHeadersEnd + 4, stLength);
+  return true;
+}
+
+/****************************************************/
+/* Method name:        route handlers               */
+/* Method description: Echo of the query, the cloud */
+/*                     setpoints and a stream.      */
+/*                                                  */
+/* Input params:       pServer - Server.            */
+/*                     (HttpServer*)                */
+/*                     iConnection - Connection.    */
+/*                     (int)                        */
+/* Output params:                                   */
+/****************************************************/
+void handleEcho(HttpServer *pServer, int iConnection)
+{
+  char cBody[128];
+  snprintf(cBody, sizeof(cBody), "echo %s\n", pServer->getQuery(iConnection));
+  pServer->send(iConnection, 200, "text/plain", cBody);
+}
+
+void handleCloud(HttpServer *pServer, int iConnection)
+{
+  pServer->send(iConnection, 200, "application/json", CLOUD_BODY);
+}
+
+void handleStream(HttpServer *pServer, int iConnection)
+{
+  pServer->beginStream(iConnection, "HTTP/1.1 200 OK\r\nContent-Type: multipart/x-mixed-replace; boundary=B\r\n",
+                       "Content-Type: image/jpeg\r\nContent-Length: ", "\r\n--B\r\n", NULL);
+}
+
+/****************************************************/
+/* Method name:        pushFrame                    */
+/* Method description: Same logic as sendStreamFrame*/
+/*                     with frame copies, the frame */
+/*                     number is in its first bytes.*/
+/*                                                  */
+/* Input params:       ui32Frame - Number.          */
+/*                     (uint32_t)                   */
+/* Output params:      true if pushed. (bool)       */
+/****************************************************/
+bool pushFrame(uint32_t ui32Frame)
+{
+  if (!hsServer.isStreamWaiting()) return false;
+  for (int iSlot = 0; iSlot < STREAM_SLOTS; iSlot++) {
+    if (hsServer.isPartInUse(ui8Slots[iSlot])) continue;
+    memcpy(ui8Slots[iSlot], &ui32Frame, sizeof(ui32Frame));
+    hsServer.pushStreamPart(ui8Slots[iSlot], STREAM_FRAME_SIZE);
+    return true;
+  }
+  return false;
+}
+
+/****************************************************/
+/* Method name:        loadClient                   */
+/* Method description: Sends requests on a kept     */
+/*                     connection, checking each    */
+/*                     answer and its latency.      */
+/*                                                  */
+/* Input params:       iClient - Number. (int)      */
+/*                     pLatencies - Request times.  */
+/*                     (std::vector<unsigned long>*)*/
+/*                     pErrors - Error count.       */
+/*                     (std::atomic<int>*)          */
+/* Output params:                                   */
+/****************************************************/
+void loadClient(int iClient, std::vector<unsigned long> *pLatencies, std::atomic<int> *pErrors)
+{
+  int iSocket = connectTo(ui16ServerPort, 0);
+  if (iSocket < 0) {
+    (*pErrors)++;
+    return;
+  }
+  int iNoDelay = 1;
+  setsockopt(iSocket, IPPROTO_TCP, TCP_NODELAY, &iNoDelay, sizeof(iNoDelay));
+  for (int iRequest = 0; iRequest < LOAD_REQUESTS; iRequest++) {
+    char cRequest[128];
+    char cExpected[64];
+    int iStatus;
+    std::string sBody;
+    int iLength = snprintf(cRequest, sizeof(cRequest), "GET /echo?c=%d&r=%d HTTP/1.1\r\nHost: x\r\n\r\n", iClient, iRequest);
+    snprintf(cExpected, sizeof(cExpected), "echo c=%d&r=%d\n", iClient, iRequest);
+    unsigned long ulStartMs = nowMs();
+    if (send(iSocket, cRequest, iLength, MSG_NOSIGNAL) != iLength || !readResponse(iSocket, &iStatus, &sBody) ||
+        iStatus != 200 || sBody != cExpected) {
+      (*pErrors)++;
+      break;
+    }
+    pLatencies->push_back(nowMs() - ulStartMs);
+    sleepMs(5 + iClient % 7);
+  }
+  close(iSocket);
+}
+
+/****************************************************/
+/* Method name:        overloadClient               */
+/* Method description: Connects when told to, then  */
+/*                     sends requests on the kept   */
+/*                     connection if admitted.      */
+/*                                                  */
+/* Input params:       iClient - Number. (int)      */
+/*                     pStart - Go. (std::atomic<   */
+/*                     bool>*)                      */
+/*                     pStatus - First status, 0 on */
+/*                     error. (int*)                */
+/*                     pFirstMs - Connect to first  */
+/*                     answer. (unsigned long*)     */
+/*                     pLatencies - Times of the    */
+/*                     later requests.              */
+/*                     (std::vector<unsigned long>*)*/
+/*                     pErrors - Error count.       */
+/*                     (std::atomic<int>*)          */
+/* Output params:                                   */
+/****************************************************/
+void overloadClient(int iClient, std::atomic<bool> *pStart, int *pStatus, unsigned long *pFirstMs,
+                    std::vector<unsigned long> *pLatencies, std::atomic<int> *pErrors)
+{
+  while (!*pStart) usleep(100);
+  unsigned long ulStartMs = nowMs();
+  int iSocket = connectTo(ui16ServerPort, 0);
+  if (iSocket < 0) {
+    (*pErrors)++;
+    return;
+  }
+  int iNoDelay = 1;
+  setsockopt(iSocket, IPPROTO_TCP, TCP_NODELAY, &iNoDelay, sizeof(iNoDelay));
+  for (int iRequest = 0; iRequest < OVERLOAD_REQUESTS; iRequest++) {
+    char cRequest[128];
+    char cExpected[64];
+    int iStatus = 0;
+    std::string sBody;
+    int iLength = snprintf(cRequest, sizeof(cRequest), "GET /echo?o=%d&r=%d HTTP/1.1\r\nHost: x\r\n\r\n", iClient, iRequest);
+    snprintf(cExpected, sizeof(cExpected), "echo o=%d&r=%d\n", iClient, iRequest);
+    if (0 < iRequest) ulStartMs = nowMs();
+    bool bRead = send(iSocket, cRequest, iLength, MSG_NOSIGNAL) == iLength && readResponse(iSocket, &iStatus, &sBody);
+    if (iRequest == 0) {
+      *pStatus = bRead ? iStatus : 0;
+      *pFirstMs = nowMs() - ulStartMs;
+      // Turned away, the server closes the connection
+      if (bRead && iStatus == 503) break;
+    } else {
+      pLatencies->push_back(nowMs() - ulStartMs);
+    }
+    if (!bRead || iStatus != 200 || sBody != cExpected) {
+      (*pErrors)++;
+      break;
+    }
+    sleepMs(5 + iClient % 7);
+  }
+  close(iSocket);
+}
+
+/****************************************************/
+/* Method name:        streamViewer                 */
+/* Method description: Reads a stream and counts the*/
+/*                     whole frames, slowly or as   */
+/*                     fast as they come.           */
+/*                                                  */
+/* Input params:       bSlow - Slow viewer. (bool)  */
+/*                     pFrames - Frames read.       */
+/*                     (std::atomic<int>*)          */
+/* Output params:                                   */
+/****************************************************/
+void streamViewer(bool bSlow, std::atomic<int> *pFrames)
+{
+  // A small window makes the slow viewer hold the server back at once
+  int iSocket = connectTo(ui16ServerPort, bSlow ? 4096 : 0);
+  if (iSocket < 0) return;
+  send(iSocket, "GET /stream HTTP/1.1\r\n\r\n", 24, MSG_NOSIGNAL);
+  std::string sPending;
+  std::vector<char> vChunk(bSlow ? SLOW_READ_BYTES : 65536);
+  size_t stFrameBytes = 0;
+  while (bRunning) {
+    int iReceived = recv(iSocket, vChunk.data(), vChunk.size(), 0);
+    if (iReceived <= 0) break;
+    sPending.append(vChunk.data(), iReceived);
+    // Counts part headers, the frame bytes after each are skipped
+    while (true) {
+      if (stFrameBytes) {
+        size_t stSkip = std::min(stFrameBytes, sPending.size());
+        sPending.erase(0, stSkip);
+        stFrameBytes -= stSkip;
+        if (stFrameBytes) break;
+        (*pFrames)++;
+      }
+      size_t stLengthAt = sPending.find("Content-Length: ");
+      size_t stHeadEnd = sPending.find("\r\n\r\n", stLengthAt == std::string::npos ? 0 : stLengthAt);
+      if (stLengthAt == std::string::npos || stHeadEnd == std::string::npos) break;
+      stFrameBytes = strtoul(sPending.c_str() + stLengthAt + 16, NULL, 10);
+      sPending.erase(0, stHeadEnd + 4);
+    }
+    if (bSlow) sleepMs(SLOW_READ_PERIOD_MS);
+  }
+  close(iSocket);
+}
+
+/****************************************************/
+/* Method name:        pollServer                   */
+/* Method description: Polls the server as loop()   */
+/*                     does until a condition holds */
+/*                     or the time is over.         */
+/*                                                  */
+/* Input params:       ulForMs - Time limit.        */
+/*                     (unsigned long)              */
+/*                     fnDone - Condition, can be   */
+/*                     NULL. (bool (*)())           */
+/* Output params:                                   */
+/****************************************************/
+template <typename Condition>
+void pollServer(unsigned long ulForMs, Condition fnDone)
+{
+  unsigned long ulEndMs = nowMs() + ulForMs;
+  while (nowMs() < ulEndMs && !fnDone()) {
+    hsServer.poll(nowMs());
+    usleep(200);
+  }
+}
+
+/****************************************************/
+/* Method name:        checkLoad                    */
+/* Method description: Many kept connections at the */
+/*                     same time while streams run. */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkLoad(void)
+{
+  std::vector<std::vector<unsigned long> > vLatencies(LOAD_CLIENTS);
+  std::atomic<int> iErrors(0);
+  std::atomic<int> iDone(0);
+  std::vector<std::thread> vClients;
+
+  for (int iClient = 0; iClient < LOAD_CLIENTS; iClient++) {
+    vClients.push_back(std::thread([iClient, &vLatencies, &iErrors, &iDone]() {
+      loadClient(iClient, &vLatencies[iClient], &iErrors);
+      iDone++;
+    }));
+  }
+  pollServer(20000, [&iDone]() { return iDone == LOAD_CLIENTS; });
+  for (size_t stClient = 0; stClient < vClients.size(); stClient++) vClients[stClient].join();
+
+  std::vector<unsigned long> vAll;
+  for (int iClient = 0; iClient < LOAD_CLIENTS; iClient++) vAll.insert(vAll.end(), vLatencies[iClient].begin(), vLatencies[iClient].end());
+  std::sort(vAll.begin(), vAll.end());
+  CHECK(iErrors == 0);
+  CHECK(vAll.size() == LOAD_CLIENTS * LOAD_REQUESTS);
+  if (vAll.empty()) return;
+  unsigned long ulP50 = vAll[vAll.size() / 2];
+  unsigned long ulP99 = vAll[vAll.size() * 99 / 100];
+  printf("load: %d clients, %u requests, %d errors, p50 %lu ms, p99 %lu ms, max %lu ms, peak %d connections\n",
+         LOAD_CLIENTS, (unsigned)vAll.size(), (int)iErrors, ulP50, ulP99, vAll.back(), hsServer.getPeakConnectionCount());
+  CHECK(ulP99 <= LOAD_P99_LIMIT_MS);
+  CHECK(LOAD_CLIENTS <= hsServer.getPeakConnectionCount());
+}
+
+/****************************************************/
+/* Method name:        checkSlowViewer              */
+/* Method description: A slow viewer skips frames   */
+/*                     and does not slow the fast   */
+/*                     ones down.                   */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkSlowViewer(void)
+{
+  std::atomic<int> iFastFrames[2];
+  std::atomic<int> iSlowFrames(0);
+  iFastFrames[0] = 0;
+  iFastFrames[1] = 0;
+  bRunning = true;
+
+  std::thread thFast0(streamViewer, false, &iFastFrames[0]);
+  std::thread thFast1(streamViewer, false, &iFastFrames[1]);
+  std::thread thSlow(streamViewer, true, &iSlowFrames);
+  pollServer(2000, []() { return hsServer.getStreamCount() == 3; });
+  CHECK(hsServer.getStreamCount() == 3);
+
+  unsigned long ulSkippedBefore = hsServer.getSkippedPartCount();
+  unsigned long ulEndMs = nowMs() + STREAM_RUN_MS;
+  unsigned long ulNextFrameMs = nowMs();
+  uint32_t ui32Frames = 0;
+  int iPushed = 0;
+  while (nowMs() < ulEndMs) {
+    hsServer.poll(nowMs());
+    if (ulNextFrameMs <= nowMs() && pushFrame(ui32Frames)) {
+      ui32Frames++;
+      iPushed++;
+      ulNextFrameMs += STREAM_FRAME_PERIOD_MS;
+    }
+    usleep(200);
+  }
+  bRunning = false;
+  // Lets the viewers see the end of their stream
+  pollServer(200, []() { return false; });
+  thFast0.join();
+  thFast1.join();
+  thSlow.join();
+  pollServer(500, []() { return hsServer.getStreamCount() == 0; });
+
+  int iExpected = STREAM_RUN_MS / STREAM_FRAME_PERIOD_MS;
+  printf("streams: %d frames pushed of %d, fast viewers %d and %d, slow viewer %d, %lu parts skipped\n",
+         iPushed, iExpected, (int)iFastFrames[0], (int)iFastFrames[1], (int)iSlowFrames,
+         hsServer.getSkippedPartCount() - ulSkippedBefore);
+  CHECK(iExpected * 8 / 10 <= iPushed);
+  CHECK(iPushed * 8 / 10 <= iFastFrames[0]);
+  CHECK(iPushed * 8 / 10 <= iFastFrames[1]);
+  CHECK(iSlowFrames * 2 < iFastFrames[0]);
+  CHECK(ulSkippedBefore < hsServer.getSkippedPartCount());
+}
+
+/****************************************************/
+/* Method name:        checkRejects                 */
+/* Method description: Connections past the limit   */
+/*                     get a 503, the others work.  */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkRejects(void)
+{
+  std::vector<int> vSockets;
+  unsigned long ulRejectedBefore = hsServer.getRejectedCount();
+
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS + EXTRA_CONNECTIONS; iConnection++) {
+    int iSocket = connectTo(ui16ServerPort, 0);
+    CHECK(0 <= iSocket);
+    vSockets.push_back(iSocket);
+    hsServer.poll(nowMs());
+  }
+  pollServer(1000, [ulRejectedBefore]() { return ulRejectedBefore + EXTRA_CONNECTIONS <= hsServer.getRejectedCount(); });
+  CHECK(hsServer.getRejectedCount() - ulRejectedBefore == EXTRA_CONNECTIONS);
+
+  // The admitted ones still answer
+  int iAnswered = 0;
+  for (size_t stSocket = 0; stSocket < vSockets.size(); stSocket++) {
+    std::thread thRequest([&vSockets, stSocket, &iAnswered]() {
+      int iStatus;
+      std::string sBody;
+      send(vSockets[stSocket], "GET /echo?x HTTP/1.1\r\n\r\n", 24, MSG_NOSIGNAL);
+      if (readResponse(vSockets[stSocket], &iStatus, &sBody) && iStatus == 200) iAnswered++;
+    });
+    pollServer(50, []() { return false; });
+    thRequest.join();
+  }
+  CHECK(iAnswered == HTTP_MAX_CONNECTIONS);
+  for (size_t stSocket = 0; stSocket < vSockets.size(); stSocket++) close(vSockets[stSocket]);
+  pollServer(500, []() { return hsServer.getConnectionCount() == 0; });
+}
+
+/****************************************************/
+/* Method name:        checkOverload                */
+/* Method description: Hundreds of clients at once  */
+/*                     against the connection slots:*/
+/*                     the excess gets a 503 at     */
+/*                     once, the admitted keep      */
+/*                     being served in time.        */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkOverload(void)
+{
+  std::vector<int> vStatus(OVERLOAD_CLIENTS, 0);
+  std::vector<unsigned long> vFirstMs(OVERLOAD_CLIENTS, 0);
+  std::vector<std::vector<unsigned long> > vLatencies(OVERLOAD_CLIENTS);
+  std::atomic<bool> bStart(false);
+  std::atomic<int> iErrors(0);
+  std::atomic<int> iDone(0);
+  std::vector<std::thread> vClients;
+  unsigned long ulRejectedBefore = hsServer.getRejectedCount();
+  unsigned long ulAcceptedBefore = hsServer.getAcceptedCount();
+
+  for (int iClient = 0; iClient < OVERLOAD_CLIENTS; iClient++) {
+    vClients.push_back(std::thread([iClient, &bStart, &vStatus, &vFirstMs, &vLatencies, &iErrors, &iDone]() {
+      overloadClient(iClient, &bStart, &vStatus[iClient], &vFirstMs[iClient], &vLatencies[iClient], &iErrors);
+      iDone++;
+    }));
+    // Starting the threads takes a while, the loop keeps polling
+    hsServer.poll(nowMs());
+  }
+  bStart = true;
+  pollServer(20000, [&iDone]() { return iDone == OVERLOAD_CLIENTS; });
+  for (size_t stClient = 0; stClient < vClients.size(); stClient++) vClients[stClient].join();
+  pollServer(500, []() { return hsServer.getConnectionCount() == 0; });
+
+  int iAdmitted = 0;
+  int iRejected = 0;
+  std::vector<unsigned long> vAdmittedFirst;
+  std::vector<unsigned long> vRejectedFirst;
+  std::vector<unsigned long> vAll;
+  for (int iClient = 0; iClient < OVERLOAD_CLIENTS; iClient++) {
+    if (vStatus[iClient] == 200) {
+      iAdmitted++;
+      vAdmittedFirst.push_back(vFirstMs[iClient]);
+      vAll.insert(vAll.end(), vLatencies[iClient].begin(), vLatencies[iClient].end());
+    } else if (vStatus[iClient] == 503) {
+      iRejected++;
+      vRejectedFirst.push_back(vFirstMs[iClient]);
+    }
+  }
+  std::sort(vAdmittedFirst.begin(), vAdmittedFirst.end());
+  std::sort(vRejectedFirst.begin(), vRejectedFirst.end());
+  std::sort(vAll.begin(), vAll.end());
+  CHECK(iErrors == 0);
+  CHECK(iAdmitted + iRejected == OVERLOAD_CLIENTS);
+  CHECK(HTTP_MAX_CONNECTIONS <= iAdmitted);
+  CHECK(OVERLOAD_CLIENTS / 2 <= iRejected);
+  CHECK(hsServer.getRejectedCount() - ulRejectedBefore == (unsigned long)iRejected);
+  CHECK(hsServer.getAcceptedCount() - ulAcceptedBefore == (unsigned long)iAdmitted);
+  CHECK(hsServer.getPeakConnectionCount() == HTTP_MAX_CONNECTIONS);
+  CHECK(vAll.size() == (size_t)iAdmitted * (OVERLOAD_REQUESTS - 1));
+  if (vAdmittedFirst.empty() || vRejectedFirst.empty() || vAll.empty()) return;
+  unsigned long ulP99 = vAll[vAll.size() * 99 / 100];
+  printf("overload: %d clients, %d admitted, %d turned away with 503, %d errors, peak %d connections\n",
+         OVERLOAD_CLIENTS, iAdmitted, iRejected, (int)iErrors, hsServer.getPeakConnectionCount());
+  printf("overload: first answer admitted p50 %lu ms max %lu ms, 503 p50 %lu ms max %lu ms\n",
+         vAdmittedFirst[vAdmittedFirst.size() / 2], vAdmittedFirst.back(),
+         vRejectedFirst[vRejectedFirst.size() / 2], vRejectedFirst.back());
+  printf("overload: admitted requests p50 %lu ms, p99 %lu ms, max %lu ms, accept poll interval last %lu ms max %lu ms\n",
+         vAll[vAll.size() / 2], ulP99, vAll.back(), hsServer.getLastAcceptPollInterval(), hsServer.getMaxAcceptPollInterval());
+  CHECK(ulP99 <= LOAD_P99_LIMIT_MS);
+  CHECK(hsServer.getMaxAcceptPollInterval() <= OVERLOAD_ACCEPT_LIMIT_MS);
+}
+
+/****************************************************/
+/* Method name:        pollClient                   */
+/* Method description: Polls the client and the     */
+/*                     server until the request ends*/
+/*                     and keeps the longest poll.  */
+/*                                                  */
+/* Input params:       pClient - Client.            */
+/*                     (HttpGetClient*)             */
+/*                     pLongestMs - Longest client  */
+/*                     poll. (unsigned long*)       */
+/* Output params:      HTTP_GET_DONE or FAILED.     */
+/*                     (int)                        */
+/****************************************************/
+int pollClient(HttpGetClient *pClient, unsigned long *pLongestMs)
+{
+  while (true) {
+    unsigned long ulStartMs = nowMs();
+    int iResult = pClient->poll(ulStartMs);
+    *pLongestMs = std::max(*pLongestMs, nowMs() - ulStartMs);
+    if (iResult != HTTP_GET_BUSY) return iResult;
+    hsServer.poll(nowMs());
+    usleep(200);
+  }
+}
+
+/****************************************************/
+/* Method name:        rawServer                    */
+/* Method description: Server that answers one      */
+/*                     request per connection with a*/
+/*                     chunked body and then closes */
+/*                     it, or never answers.        */
+/*                                                  */
+/* Input params:       iListen - Socket. (int)      */
+/*                     bSilent - Never answers.     */
+/*                     (bool)                       */
+/* Output params:                                   */
+/****************************************************/
+void rawServer(int iListen, bool bSilent)
+{
+  static const char cChunked[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                 "5\r\n[\"511\r\n7\r\n\",\"600\"\r\n1\r\n]\r\n0\r\n\r\n";
+  while (true) {
+    int iSocket = accept(iListen, NULL, NULL);
+    if (iSocket < 0) return;
+    char cRequest[512];
+    int iReceived = recv(iSocket, cRequest, sizeof(cRequest), 0);
+    if (bSilent) {
+      while (0 < iReceived) iReceived = recv(iSocket, cRequest, sizeof(cRequest), 0);
+    } else if (0 < iReceived) {
+      send(iSocket, cChunked, sizeof(cChunked) - 1, MSG_NOSIGNAL);
+      // The server drops the kept connection, as after its idle timeout
+      sleepMs(20);
+    }
+    close(iSocket);
+  }
+}
+
+/****************************************************/
+/* Method name:        listenRaw                    */
+/* Method description: Listens on a free local port.*/
+/*                                                  */
+/* Input params:       pPort - Port found.          */
+/*                     (uint16_t*)                  */
+/* Output params:      Socket. (int)                */
+/****************************************************/
+int listenRaw(uint16_t *pPort)
+{
+  struct sockaddr_in saAddress;
+  socklen_t slLength = sizeof(saAddress);
+  int iListen = socket(AF_INET, SOCK_STREAM, 0);
+  memset(&saAddress, 0, sizeof(saAddress));
+  saAddress.sin_family = AF_INET;
+  saAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(iListen, (struct sockaddr *)&saAddress, sizeof(saAddress));
+  listen(iListen, 4);
+  getsockname(iListen, (struct sockaddr *)&saAddress, &slLength);
+  *pPort = ntohs(saAddress.sin_port);
+  return iListen;
+}
+
+/****************************************************/
+/* Method name:        checkGetClient               */
+/* Method description: The cloud client gets the    */
+/*                     setpoints on a kept          */
+/*                     connection without blocking, */
+/*                     reconnects when the server   */
+/*                     closed it and gives up on a  */
+/*                     silent server in time.       */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkGetClient(void)
+{
+  HttpGetClient hgcClient;
+  unsigned long ulLongestMs = 0;
+  char cUrl[64];
+
+  // Served by HttpServer in the same thread, only non blocking polls can work
+  snprintf(cUrl, sizeof(cUrl), "http://127.0.0.1:%u/cloud", ui16ServerPort);
+  CHECK(hgcClient.begin(cUrl, nowMs()));
+  unsigned long ulAcceptedBefore = hsServer.getAcceptedCount();
+  for (int iRequest = 0; iRequest < 20; iRequest++) {
+    CHECK(hgcClient.request(nowMs()));
+    CHECK(!hgcClient.request(nowMs()));
+    CHECK(pollClient(&hgcClient, &ulLongestMs) == HTTP_GET_DONE);
+    CHECK(hgcClient.getStatus() == 200);
+    CHECK(strcmp(hgcClient.getBody(), CLOUD_BODY) == 0);
+  }
+  CHECK(hsServer.getAcceptedCount() - ulAcceptedBefore == 1);
+  CHECK(hgcClient.poll(nowMs()) == HTTP_GET_IDLE);
+
+  // Chunked answers on connections the server closes after each one
+  uint16_t ui16RawPort;
+  int iRawListen = listenRaw(&ui16RawPort);
+  std::thread thRaw(rawServer, iRawListen, false);
+  snprintf(cUrl, sizeof(cUrl), "http://localhost:%u/get/V2", ui16RawPort);
+  CHECK(hgcClient.begin(cUrl, nowMs()));
+  for (int iRequest = 0; iRequest < 3; iRequest++) {
+    CHECK(hgcClient.request(nowMs()));
+    CHECK(pollClient(&hgcClient, &ulLongestMs) == HTTP_GET_DONE);
+    CHECK(strcmp(hgcClient.getBody(), CLOUD_BODY) == 0);
+    // Once right away, while the close may still be on its way, once after it
+    if (iRequest == 1) sleepMs(50);
+  }
+  CHECK(hgcClient.getFailedCount() == 0);
+  shutdown(iRawListen, SHUT_RDWR);
+  close(iRawListen);
+  thRaw.join();
+
+  // A silent server costs the timeout, not a blocked loop
+  int iSilentListen = listenRaw(&ui16RawPort);
+  std::thread thSilent(rawServer, iSilentListen, true);
+  snprintf(cUrl, sizeof(cUrl), "http://127.0.0.1:%u/get/V1", ui16RawPort);
+  CHECK(hgcClient.begin(cUrl, nowMs()));
+  unsigned long ulStartMs = nowMs();
+  CHECK(hgcClient.request(nowMs()));
+  CHECK(pollClient(&hgcClient, &ulLongestMs) == HTTP_GET_FAILED);
+  unsigned long ulFailedMs = nowMs() - ulStartMs;
+  CHECK(HTTP_GET_TIMEOUT_MS <= ulFailedMs && ulFailedMs < HTTP_GET_TIMEOUT_MS + 200);
+  CHECK(hgcClient.getFailedCount() == 1);
+  shutdown(iSilentListen, SHUT_RDWR);
+  close(iSilentListen);
+  thSilent.join();
+
+  // Nobody listening
+  CHECK(hgcClient.begin(cUrl, nowMs()));
+  CHECK(!hgcClient.request(nowMs()) || pollClient(&hgcClient, &ulLongestMs) == HTTP_GET_FAILED);
+  CHECK(hgcClient.getFailedCount() == 2);
+  CHECK(!hgcClient.begin("http://no.such.host.invalid/x", nowMs()));
+
+  printf("client: longest poll %lu ms, silent server failed after %lu ms\n", ulLongestMs, ulFailedMs);
+  CHECK(ulLongestMs <= CLIENT_POLL_LIMIT_MS);
+}
+
+/****************************************************/
+/* Method name:        main                         */
+/* Method description: Runs every scenario on one   */
+/*                     server.                      */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      0 if every check passed.     */
+/*                     (int)                        */
+/****************************************************/
+int main(void)
+{
+  signal(SIGPIPE, SIG_IGN);
+  hsServer.on("/echo", handleEcho);
+  hsServer.on("/cloud", handleCloud);
+  hsServer.on("/stream", handleStream);
+  for (ui16ServerPort = BASE_PORT; ui16ServerPort < BASE_PORT + 20; ui16ServerPort++) {
+    if (hsServer.begin(ui16ServerPort, nowMs())) break;
+  }
+  CHECK(ui16ServerPort < BASE_PORT + 20);
+
+  // The first accept interval counts from begin, not from boot
+  int iSocket = connectTo(ui16ServerPort, 0);
+  pollServer(500, []() { return hsServer.getAcceptedCount() == 1; });
+  CHECK(hsServer.getMaxAcceptPollInterval() < 1000);
+  close(iSocket);
+  pollServer(200, []() { return hsServer.getConnectionCount() == 0; });
+
+  checkLoad();
+  checkSlowViewer();
+  checkRejects();
+  checkOverload();
+  checkGetClient();
+
+  if (iFailures) {
+    printf("%d check(s) failed\n", iFailures);
+    return 1;
+  }
+  printf("HttpLoadTest passed\n");
+  return 0;
+}
@@ -0,0 +1,216 @@
+/**************************************************/
+/* File name:        SessionRecorderTest.cpp      */
+/* File description: Checks that a session        */
+/*                   download only takes the      */
+/*                   records it sent, that the    */
+/*                   ones recorded meanwhile are  */
+/*                   kept with their times, and   */
+/*                   that a full buffer keeps the */
+/*                   last records.                */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include <vector>
+#include "SessionRecorder.h"
+#include "SessionTrace.h"
+
+// Defines
+#define BUFFER_SIZE                      4096
+#define RECORD_PERIOD_MS                 37
+#define FIRST_RECORD_MS                  123456 // Past one varint byte
+#define FULL_RECORDS                     2000 // Sonar records, several buffers of them
+#define JPEG_LENGTH                      200
+#define HELD_STEPS                       400  // Frames and sonar records while held
+
+#define CHECK(bCondition) check((bCondition), #bCondition, __LINE__)
+
+// Variables
+int iFailures = 0;
+uint8_t ui8Buffer[BUFFER_SIZE];
+uint8_t ui8Jpeg[JPEG_LENGTH];
+
+/****************************************************/
+/* Method name:        check                        */
+/* Method description: Reports a failed check.      */
+/*                                                  */
+/* Input params:       bCondition - Result. (bool)  */
+/*                     cText - Checked expression.  */
+/*                     (const char*)                */
+/*                     iLine - Source line. (int)   */
+/* Output params:                                   */
+/****************************************************/
+void check(bool bCondition, const char *cText, int iLine)
+{
+  if (bCondition) return;
+  printf("FAIL line %d: %s\n", iLine, cText);
+  iFailures++;
+}
+
+/****************************************************/
+/* Method name:        recordSonar                  */
+/* Method description: Records sonar values, each   */
+/*                     its index, at a fixed period.*/
+/*                                                  */
+/* Input params:       pRecorder - Recorder.        */
+/*                     (SessionRecorder*)           */
+/*                     iFrom, iTo - Indexes.        */
+/*                     (int)                        */
+/* Output params:                                   */
+/****************************************************/
+void recordSonar(SessionRecorder *pRecorder, int iFrom, int iTo)
+{
+  for (int iRecord = iFrom; iRecord < iTo; iRecord++) {
+    pRecorder->recordValue(SESSION_RECORD_SONAR, iRecord, FIRST_RECORD_MS + iRecord * RECORD_PERIOD_MS);
+  }
+}
+
+/****************************************************/
+/* Method name:        checkDownload                */
+/* Method description: Checks one downloaded copy   */
+/*                     holds the expected records   */
+/*                     with their times since boot. */
+/*                                                  */
+/* Input params:       vDownload - Copy. (const     */
+/*                     std::vector<uint8_t>&)       */
+/*                     iFrom, iTo - Indexes.        */
+/*                     (int)                        */
+/* Output params:                                   */
+/****************************************************/
+void checkDownload(const std::vector<uint8_t> &vDownload, int iFrom, int iTo)
+{
+  SessionTrace stTrace;
+  CHECK(stTrace.loadBuffer(vDownload.data(), vDownload.size()));
+  CHECK(stTrace.getRecordCount() == (size_t)(iTo - iFrom));
+  for (size_t stIndex = 0; stIndex < stTrace.getRecordCount(); stIndex++) {
+    const SessionTraceRecord &srRecord = stTrace.getRecord(stIndex);
+    int iRecord = iFrom + (int)stIndex;
+    CHECK(srRecord.ui8Type == SESSION_RECORD_SONAR);
+    CHECK(SessionTrace::getVarint(srRecord) == (unsigned long)iRecord);
+    CHECK(srRecord.ulTimeMs == (unsigned long)(FIRST_RECORD_MS + iRecord * RECORD_PERIOD_MS));
+  }
+}
+
+/****************************************************/
+/* Method name:        download                     */
+/* Method description: Copies what a download of the*/
+/*                     buffer sends right now.      */
+/*                                                  */
+/* Input params:       pRecorder - Recorder.        */
+/*                     (SessionRecorder*)           */
+/* Output params:      Copy. (std::vector<uint8_t>) */
+/****************************************************/
+std::vector<uint8_t> download(SessionRecorder *pRecorder)
+{
+  return std::vector<uint8_t>(pRecorder->getData(), pRecorder->getData() + pRecorder->getLength());
+}
+
+/****************************************************/
+/* Method name:        checkHeld                    */
+/* Method description: While a download holds the   */
+/*                     buffer its bytes stay, and   */
+/*                     frame contents are dropped   */
+/*                     before the sonar records.    */
+/*                                                  */
+/* Input params:       pRecorder - Recorder.        */
+/*                     (SessionRecorder*)           */
+/* Output params:                                   */
+/****************************************************/
+void checkHeld(SessionRecorder *pRecorder)
+{
+  pRecorder->begin(ui8Buffer, sizeof(ui8Buffer), 1);
+  recordSonar(pRecorder, 0, 10);
+  std::vector<uint8_t> vSent = download(pRecorder);
+  pRecorder->hold(true);
+  int iSonarDropped = -1;
+  int iContentDropped = -1;
+  for (int iStep = 10; iStep < HELD_STEPS; iStep++) {
+    unsigned long ulNowMs = FIRST_RECORD_MS + iStep * RECORD_PERIOD_MS;
+    if (!pRecorder->recordFrame(ui8Jpeg, sizeof(ui8Jpeg), ulNowMs) && iContentDropped < 0) iContentDropped = iStep;
+    if (!pRecorder->recordValue(SESSION_RECORD_SONAR, iStep, ulNowMs) && iSonarDropped < 0) iSonarDropped = iStep;
+  }
+  CHECK(0 < iContentDropped);
+  CHECK(iContentDropped < iSonarDropped);
+  CHECK(std::vector<uint8_t>(pRecorder->getData(), pRecorder->getData() + vSent.size()) == vSent);
+
+  // The reserved room took the sonar records from the step of the last frame contents
+  SessionTrace stTrace;
+  CHECK(stTrace.loadBuffer(pRecorder->getData(), pRecorder->getLength()));
+  int iSonarAfterContent = 0;
+  for (size_t stIndex = 0; stIndex < stTrace.getRecordCount(); stIndex++) {
+    uint8_t ui8Type = stTrace.getRecord(stIndex).ui8Type;
+    if (ui8Type == SESSION_RECORD_FRAME) iSonarAfterContent = 0;
+    if (ui8Type == SESSION_RECORD_SONAR) iSonarAfterContent++;
+  }
+  CHECK(iSonarAfterContent == iSonarDropped - iContentDropped + 1);
+
+  // Released, the oldest records make room again
+  pRecorder->hold(false);
+  CHECK(pRecorder->recordFrame(ui8Jpeg, sizeof(ui8Jpeg), FIRST_RECORD_MS + HELD_STEPS * RECORD_PERIOD_MS));
+  CHECK(pRecorder->recordValue(SESSION_RECORD_SONAR, HELD_STEPS, FIRST_RECORD_MS + HELD_STEPS * RECORD_PERIOD_MS));
+}
+
+/****************************************************/
+/* Method name:        main                         */
+/* Method description: Downloads while recording,   */
+/*                     as the /session handler does.*/
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      0 if every check passed.     */
+/*                     (int)                        */
+/****************************************************/
+int main(void)
+{
+  SessionRecorder srRecorder;
+  srRecorder.begin(ui8Buffer, sizeof(ui8Buffer), 0);
+
+  // Records keep coming while the first download is sent
+  recordSonar(&srRecorder, 0, 100);
+  std::vector<uint8_t> vFirst = download(&srRecorder);
+  recordSonar(&srRecorder, 100, 130);
+  CHECK(srRecorder.consume(vFirst.size()));
+  checkDownload(vFirst, 0, 100);
+
+  // The next download starts where the first one ended
+  recordSonar(&srRecorder, 130, 150);
+  std::vector<uint8_t> vSecond = download(&srRecorder);
+  CHECK(srRecorder.consume(vSecond.size()));
+  checkDownload(vSecond, 100, 150);
+
+  // Nothing new, the buffer is empty again
+  CHECK(srRecorder.getLength() == SESSION_HEADER_SIZE);
+  recordSonar(&srRecorder, 150, 151);
+  checkDownload(download(&srRecorder), 150, 151);
+
+  // A length inside a record is refused and drops nothing
+  size_t stLength = srRecorder.getLength();
+  CHECK(!srRecorder.consume(stLength - 1));
+  CHECK(!srRecorder.consume(stLength + 1));
+  CHECK(srRecorder.getLength() == stLength);
+
+  // A full buffer drops its oldest records, the download has the last ones
+  srRecorder.clear();
+  recordSonar(&srRecorder, 0, FULL_RECORDS);
+  std::vector<uint8_t> vFull = download(&srRecorder);
+  SessionTrace stTrace;
+  CHECK(stTrace.loadBuffer(vFull.data(), vFull.size()));
+  int iFirst = (int)SessionTrace::getVarint(stTrace.getRecord(0));
+  CHECK(0 < iFirst);
+  CHECK(srRecorder.getDroppedRecords() == (unsigned long)iFirst);
+  checkDownload(vFull, iFirst, FULL_RECORDS);
+  CHECK(srRecorder.consume(vFull.size()));
+  CHECK(srRecorder.getDroppedRecords() == 0);
+  recordSonar(&srRecorder, FULL_RECORDS + 1, FULL_RECORDS + 10);
+  checkDownload(download(&srRecorder), FULL_RECORDS + 1, FULL_RECORDS + 10);
+
+  checkHeld(&srRecorder);
+
+  if (iFailures) {
+    printf("%d check(s) failed\n", iFailures);
+    return 1;
+  }
+  printf("SessionRecorderTest passed\n");
+  return 0;
+}
@@ -0,0 +1,661 @@
+/**************************************************/
+/* File name:        SessionReplay.cpp            */
+/* File description: Replays a recorded .ursr     */
+/*                   session through the sketch   */
+/*                   itself, in virtual time. The */
+/*                   cloud answers, sonar echoes  */
+/*                   and camera frames come from  */
+/*                   the records through the      */
+/*                   shims. Reports the PWM duties*/
+/*                   of the servos, the cliff stop*/
+/*                   times and the stream         */
+/*                   throughput, and compares them*/
+/*                   with a golden run.           */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "Shim.h"
+#include "SessionRecorder.h"
+#include "SessionTrace.h"
+#include "HttpServer.h"
+#include "HttpGetClient.h"
+#include "CameraPanTiltControl.h"
+#include "MovementControl.h"
+
+// Defines
+#define REPLAY_CLOUD_LATENCY_MS          80   // Request to answer, the records hold no request times
+#define REPLAY_TAIL_MS                   1000 // Run past the last record
+#define REPLAY_SAMPLE_MS                 50   // Golden PWM sample period
+#define REPLAY_VIEWERS_START_MS          3000
+#define REPLAY_FAST_VIEWER_RATE          (2 * 1024 * 1024) // Bytes per second
+#define REPLAY_SLOW_VIEWER_RATE          (150 * 1024)
+#define REPLAY_NO_SONAR_ECHO_US          224  // Flat floor, for sessions without sonar records
+#define REPLAY_CLIFF_STOP_LIMIT_MS       100  // Sonar period, echo and control tick
+#define REPLAY_THROUGHPUT_TOLERANCE      2    // Percent off the golden run
+#define CAMERA_NO_FRAME_MS               4000 // esp_camera_fb_get timeout
+#define CAMERA_MAX_FRAME_SIZE            (64 * 1024)
+#define STOP_DISTANCE_CM                 12   // FRONT_SENSOR_STOP_DISTANCE of URS.ino
+#define SONAR_FITTING_A                  54.6839 // FRONT_SENSOR_FITTING_A of URS.ino
+#define SONAR_FITTING_B                  5.7238  // FRONT_SENSOR_FITTING_B of URS.ino
+
+#define REPLAY_CHANNELS                  4
+#define REPLAY_VIEWERS                   2
+
+/****************************************************/
+/* Struct name:       DutyChange                    */
+/* Struct description: A duty written on a channel. */
+/****************************************************/
+struct DutyChange
+{
+  unsigned long ulTimeMs;
+  uint8_t ui8Channel;
+  uint32_t ui32Duty;
+};
+
+/****************************************************/
+/* Struct name:       ReplayResult                  */
+/* Struct description: What a run is compared on.   */
+/****************************************************/
+struct ReplayResult
+{
+  std::vector<std::pair<unsigned long, long> > vCliffs; // Onset and stop, -1 if it never stopped
+  unsigned long ulViewerParts[REPLAY_VIEWERS];
+  unsigned long ulViewerBytes[REPLAY_VIEWERS];
+  unsigned long ulFramesGrabbed;
+  std::vector<std::vector<uint32_t> > vSamples; // Time then one duty per channel
+};
+
+// The sketch, built from URS.ino
+void setup(void);
+void loop(void);
+extern HttpServer hsServer;
+extern HttpGetClient hgcPanTiltClient;
+extern HttpGetClient hgcMovementClient;
+
+// Variables
+const uint8_t ui8Channels[REPLAY_CHANNELS] = { PAN_SERVO_CHANNEL, TILT_SERVO_CHANNEL, LEFT_SERVO_CHANNEL, RIGHT_SERVO_CHANNEL };
+const char *cChannelNames[REPLAY_CHANNELS] = { "pan", "tilt", "left", "right" };
+SessionTrace stTrace;
+std::vector<size_t> vRecords[SESSION_RECORD_FRAME + 1];
+std::vector<DutyChange> vDuties;
+std::mutex mCamera;
+std::condition_variable cvCamera;
+bool bGrabWaiting = false;
+unsigned long ulGrabDueMs = 0;
+size_t stNextFrame = 0;
+unsigned long ulFramesGrabbed = 0;
+camera_fb_t cfFrames[2];
+int iLastFrame = 0;
+
+/****************************************************/
+/* Method name:        getLatestRecord              */
+/* Method description: Last record of a type at or  */
+/*                     before a time, else the      */
+/*                     first one.                   */
+/*                                                  */
+/* Input params:       ui8Type - Record type.       */
+/*                     (uint8_t)                    */
+/*                     ulTimeMs - Time. (unsigned   */
+/*                     long)                        */
+/* Output params:      Record, NULL if none of the  */
+/*                     type. (const                 */
+/*                     SessionTraceRecord*)         */
+/****************************************************/
+const SessionTraceRecord *getLatestRecord(uint8_t ui8Type, unsigned long ulTimeMs)
+{
+  const std::vector<size_t> &vOfType = vRecords[ui8Type];
+  if (vOfType.empty()) return NULL;
+  size_t stLow = 0;
+  size_t stHigh = vOfType.size();
+  while (stLow + 1 < stHigh) {
+    size_t stMiddle = (stLow + stHigh) / 2;
+    if (stTrace.getRecord(vOfType[stMiddle]).ulTimeMs <= ulTimeMs) stLow = stMiddle;
+    else stHigh = stMiddle;
+  }
+  return &stTrace.getRecord(vOfType[stLow]);
+}
+
+/****************************************************/
+/* Method name:        answerCloud                  */
+/* Method description: The cloud answers with the   */
+/*                     payload the session had got  */
+/*                     by the time the answer comes.*/
+/*                     V2 is the pan tilt URL, V1   */
+/*                     the movement one.            */
+/*                                                  */
+/* Input params:       As ShimHttpGetSource.        */
+/* Output params:      false if no record. (bool)   */
+/****************************************************/
+bool answerCloud(const char *cUrl, unsigned long ulRequestMs, unsigned long *pReadyMs, char *cBody, size_t stBodySize)
+{
+  size_t stUrlLength = strlen(cUrl);
+  uint8_t ui8Type = SESSION_RECORD_MOVEMENT;
+  if (3 <= stUrlLength && strcmp(cUrl + stUrlLength - 3, "/V2") == 0) ui8Type = SESSION_RECORD_PANTILT;
+  *pReadyMs = ulRequestMs + REPLAY_CLOUD_LATENCY_MS;
+  const SessionTraceRecord *pRecord = getLatestRecord(ui8Type, *pReadyMs);
+  if (!pRecord) return false;
+  // Before the first payload the answer waits for it
+  if (*pReadyMs < pRecord->ulTimeMs) *pReadyMs = pRecord->ulTimeMs;
+  size_t stLength = pRecord->stLength < stBodySize - 1 ? pRecord->stLength : stBodySize - 1;
+  memcpy(cBody, pRecord->pPayload, stLength);
+  cBody[stLength] = '\0';
+  return true;
+}
+
+/****************************************************/
+/* Method name:        answerSonar                  */
+/* Method description: Echo of the floor as last    */
+/*                     recorded.                    */
+/*                                                  */
+/* Input params:       As ShimPulseSource.          */
+/* Output params:      Echo in us. (unsigned long)  */
+/****************************************************/
+unsigned long answerSonar(uint8_t ui8Pin, unsigned long ulTimeoutUs)
+{
+  (void)ui8Pin;
+  (void)ulTimeoutUs;
+  const SessionTraceRecord *pRecord = getLatestRecord(SESSION_RECORD_SONAR, millis());
+  return pRecord ? SessionTrace::getVarint(*pRecord) : REPLAY_NO_SONAR_ECHO_US;
+}
+
+/****************************************************/
+/* Method name:        grabFrame                    */
+/* Method description: Frame source of the camera,  */
+/*                     on the grab task. Waits for  */
+/*                     the first frame recorded at  */
+/*                     or after the grab, the ones  */
+/*                     before are lost as in the    */
+/*                     driver. Without frames left  */
+/*                     it fails at the driver       */
+/*                     timeout.                     */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Frame, NULL on timeout.      */
+/*                     (camera_fb_t*)               */
+/****************************************************/
+camera_fb_t *grabFrame(void)
+{
+  std::unique_lock<std::mutex> lock(mCamera);
+  const std::vector<size_t> &vFrames = vRecords[SESSION_RECORD_FRAME_SIZE];
+  unsigned long ulNowMs = millis();
+  while (stNextFrame < vFrames.size() && stTrace.getRecord(vFrames[stNextFrame]).ulTimeMs < ulNowMs) stNextFrame++;
+  bool bFrame = stNextFrame < vFrames.size();
+  ulGrabDueMs = bFrame ? stTrace.getRecord(vFrames[stNextFrame]).ulTimeMs : ulNowMs + CAMERA_NO_FRAME_MS;
+  if (ulNowMs < ulGrabDueMs) {
+    // The loop hands the frame over once the clock gets to it
+    bGrabWaiting = true;
+    shimBlockTask();
+    cvCamera.wait(lock, []() { return !bGrabWaiting; });
+  }
+  if (!bFrame) return NULL;
+  camera_fb_t *pFrame = &cfFrames[iLastFrame];
+  iLastFrame = 1 - iLastFrame;
+  pFrame->len = std::min<unsigned long>(SessionTrace::getVarint(stTrace.getRecord(vFrames[stNextFrame])), CAMERA_MAX_FRAME_SIZE);
+  stNextFrame++;
+  ulFramesGrabbed++;
+  return pFrame;
+}
+
+/****************************************************/
+/* Method name:        deliverFrame                 */
+/* Method description: Hands the awaited frame over */
+/*                     if it is due by a time, on   */
+/*                     the loop thread.             */
+/*                                                  */
+/* Input params:       ulLimitMs - Time. (unsigned  */
+/*                     long)                        */
+/*                     bAdvance - Moves the clock to*/
+/*                     the frame. (bool)            */
+/* Output params:                                   */
+/****************************************************/
+void deliverFrame(unsigned long ulLimitMs, bool bAdvance)
+{
+  std::lock_guard<std::mutex> lock(mCamera);
+  if (!bGrabWaiting || ulLimitMs < ulGrabDueMs) return;
+  if (bAdvance && millis() < ulGrabDueMs) shimSetMillis(ulGrabDueMs);
+  bGrabWaiting = false;
+  shimUnblockTask();
+  cvCamera.notify_all();
+}
+
+/****************************************************/
+/* Method name:        waitOnTask                   */
+/* Method description: The loop waits on the grab   */
+/*                     task, time goes on to the    */
+/*                     frame if it comes in time.   */
+/*                                                  */
+/* Input params:       ulTicks - Wait. (unsigned    */
+/*                     long)                        */
+/* Output params:                                   */
+/****************************************************/
+void waitOnTask(unsigned long ulTicks)
+{
+  unsigned long ulNowMs = millis();
+  deliverFrame(ulTicks == portMAX_DELAY ? (unsigned long)-1 : ulNowMs + ulTicks, true);
+}
+
+/****************************************************/
+/* Method name:        recordDuty                   */
+/* Method description: Keeps every PWM duty written.*/
+/*                                                  */
+/* Input params:       As ShimLedcObserver.         */
+/* Output params:                                   */
+/****************************************************/
+void recordDuty(unsigned long ulTimeMs, uint8_t ui8Channel, uint32_t ui32Duty)
+{
+  vDuties.push_back({ulTimeMs, ui8Channel, ui32Duty});
+}
+
+/****************************************************/
+/* Method name:        isCliffEcho                  */
+/* Method description: Same distance as SonarSensor,*/
+/*                     tells if it stops the car.   */
+/*                                                  */
+/* Input params:       ulEchoUs - Echo. (unsigned   */
+/*                     long)                        */
+/* Output params:      true if no floor. (bool)     */
+/****************************************************/
+bool isCliffEcho(unsigned long ulEchoUs)
+{
+  float fA = SONAR_FITTING_A;
+  float fB = SONAR_FITTING_B / fA;
+  return ulEchoUs == 0 || STOP_DISTANCE_CM < ulEchoUs / fA - fB;
+}
+
+/****************************************************/
+/* Method name:        findCliffStops               */
+/* Method description: For every drop the sonar     */
+/*                     records, the first time the  */
+/*                     drive duties stop going      */
+/*                     forward. The neutral duties  */
+/*                     are the first ones, written  */
+/*                     at boot. The right servo is  */
+/*                     inverted.                    */
+/*                                                  */
+/* Input params:       prResult - Filled result.    */
+/*                     (ReplayResult*)              */
+/* Output params:                                   */
+/****************************************************/
+void findCliffStops(ReplayResult *prResult)
+{
+  long lNeutral[2] = { -1, -1 };
+  for (size_t stChange = 0; stChange < vDuties.size(); stChange++) {
+    if (vDuties[stChange].ui8Channel == LEFT_SERVO_CHANNEL && lNeutral[0] < 0) lNeutral[0] = vDuties[stChange].ui32Duty;
+    if (vDuties[stChange].ui8Channel == RIGHT_SERVO_CHANNEL && lNeutral[1] < 0) lNeutral[1] = vDuties[stChange].ui32Duty;
+  }
+
+  bool bWasCliff = false;
+  for (size_t stSonar = 0; stSonar < vRecords[SESSION_RECORD_SONAR].size(); stSonar++) {
+    const SessionTraceRecord &srRecord = stTrace.getRecord(vRecords[SESSION_RECORD_SONAR][stSonar]);
+    bool bCliff = isCliffEcho(SessionTrace::getVarint(srRecord));
+    if (bCliff && !bWasCliff) {
+      long lLeft = lNeutral[0];
+      long lRight = lNeutral[1];
+      long lStopMs = -1;
+      for (size_t stChange = 0; stChange < vDuties.size(); stChange++) {
+        const DutyChange &dcChange = vDuties[stChange];
+        if (dcChange.ui8Channel == LEFT_SERVO_CHANNEL) lLeft = dcChange.ui32Duty;
+        if (dcChange.ui8Channel == RIGHT_SERVO_CHANNEL) lRight = dcChange.ui32Duty;
+        bool bForward = lNeutral[0] < lLeft || lRight < lNeutral[1];
+        if (srRecord.ulTimeMs <= dcChange.ulTimeMs && !bForward) {
+          lStopMs = dcChange.ulTimeMs;
+          break;
+        }
+      }
+      prResult->vCliffs.push_back(std::make_pair(srRecord.ulTimeMs, lStopMs));
+    }
+    bWasCliff = bCliff;
+  }
+}
+
+/****************************************************/
+/* Method name:        sampleDuties                 */
+/* Method description: Duties of every channel at a */
+/*                     fixed period.                */
+/*                                                  */
+/* Input params:       ulEndMs - Last time.         */
+/*                     (unsigned long)              */
+/*                     prResult - Filled result.    */
+/*                     (ReplayResult*)              */
+/* Output params:                                   */
+/****************************************************/
+void sampleDuties(unsigned long ulEndMs, ReplayResult *prResult)
+{
+  uint32_t ui32Duties[REPLAY_CHANNELS] = { 0, 0, 0, 0 };
+  size_t stChange = 0;
+  for (unsigned long ulTimeMs = 0; ulTimeMs <= ulEndMs; ulTimeMs += REPLAY_SAMPLE_MS) {
+    while (stChange < vDuties.size() && vDuties[stChange].ulTimeMs <= ulTimeMs) {
+      for (int iChannel = 0; iChannel < REPLAY_CHANNELS; iChannel++) {
+        if (ui8Channels[iChannel] == vDuties[stChange].ui8Channel) ui32Duties[iChannel] = vDuties[stChange].ui32Duty;
+      }
+      stChange++;
+    }
+    std::vector<uint32_t> vSample(1, ulTimeMs);
+    vSample.insert(vSample.end(), ui32Duties, ui32Duties + REPLAY_CHANNELS);
+    prResult->vSamples.push_back(vSample);
+  }
+}
+
+/****************************************************/
+/* Method name:        runSession                   */
+/* Method description: Boots the sketch and runs its*/
+/*                     loop to the end of the       */
+/*                     session. Each loop pass takes*/
+/*                     1 ms, plus the time the sonar*/
+/*                     waits for its echo. Two      */
+/*                     viewers, a fast and a slow   */
+/*                     one, watch the stream.       */
+/*                                                  */
+/* Input params:       prResult - Filled result.    */
+/*                     (ReplayResult*)              */
+/* Output params:      Session end. (unsigned long) */
+/****************************************************/
+unsigned long runSession(ReplayResult *prResult)
+{
+  static uint8_t ui8FrameBytes[2][CAMERA_MAX_FRAME_SIZE];
+  int iViewers[REPLAY_VIEWERS] = { -1, -1 };
+  unsigned long ulEndMs = REPLAY_TAIL_MS;
+
+  for (size_t stRecord = 0; stRecord < stTrace.getRecordCount(); stRecord++) {
+    const SessionTraceRecord &srRecord = stTrace.getRecord(stRecord);
+    if (srRecord.ui8Type <= SESSION_RECORD_FRAME) vRecords[srRecord.ui8Type].push_back(stRecord);
+    ulEndMs = srRecord.ulTimeMs + REPLAY_TAIL_MS;
+  }
+  for (int iFrame = 0; iFrame < 2; iFrame++) {
+    cfFrames[iFrame].buf = ui8FrameBytes[iFrame];
+    cfFrames[iFrame].width = 320;
+    cfFrames[iFrame].height = 240;
+    cfFrames[iFrame].format = PIXFORMAT_JPEG;
+  }
+
+  shimSetMillis(0);
+  shimSetTaskSync(true, waitOnTask);
+  shimSetCamera(ESP_OK, grabFrame);
+  shimSetPulseSource(answerSonar);
+  shimSetHttpGetSource(answerCloud);
+  shimSetLedcObserver(recordDuty);
+  setup();
+  while (millis() < ulEndMs) {
+    if (iViewers[0] < 0 && REPLAY_VIEWERS_START_MS <= millis()) {
+      iViewers[0] = shimOpenHttpClient("/mjpeg/1", REPLAY_FAST_VIEWER_RATE);
+      iViewers[1] = shimOpenHttpClient("/mjpeg/1", REPLAY_SLOW_VIEWER_RATE);
+    }
+    loop();
+    shimAdvanceMillis(1);
+    shimRunTimers();
+    deliverFrame(millis(), false);
+    shimWaitTasksBlocked();
+  }
+
+  for (int iViewer = 0; iViewer < REPLAY_VIEWERS; iViewer++) {
+    prResult->ulViewerParts[iViewer] = 0 <= iViewers[iViewer] ? shimGetHttpClientParts(iViewers[iViewer]) : 0;
+    prResult->ulViewerBytes[iViewer] = 0 <= iViewers[iViewer] ? shimGetHttpClientBytes(iViewers[iViewer]) : 0;
+  }
+  prResult->ulFramesGrabbed = ulFramesGrabbed;
+  findCliffStops(prResult);
+  sampleDuties(ulEndMs, prResult);
+  return ulEndMs;
+}
+
+/****************************************************/
+/* Method name:        writeResult                  */
+/* Method description: Writes a run as a golden.    */
+/*                                                  */
+/* Input params:       cPath - File. (const char*)  */
+/*                     cTrace - Trace. (const char*)*/
+/*                     rResult - Run. (const        */
+/*                     ReplayResult&)               */
+/* Output params:      true if written. (bool)      */
+/****************************************************/
+bool writeResult(const char *cPath, const char *cTrace, const ReplayResult &rResult)
+{
+  FILE *pFile = fopen(cPath, "w");
+  if (!pFile) return false;
+  fprintf(pFile, "# SessionReplay golden run of %s, rewrite with make golden\n", cTrace);
+  for (size_t stCliff = 0; stCliff < rResult.vCliffs.size(); stCliff++) {
+    fprintf(pFile, "cliff %lu %ld\n", rResult.vCliffs[stCliff].first, rResult.vCliffs[stCliff].second);
+  }
+  for (int iViewer = 0; iViewer < REPLAY_VIEWERS; iViewer++) {
+    fprintf(pFile, "viewer %d %lu %lu\n", iViewer, rResult.ulViewerParts[iViewer], rResult.ulViewerBytes[iViewer]);
+  }
+  fprintf(pFile, "frames %lu\n", rResult.ulFramesGrabbed);
+  fprintf(pFile, "# time_ms pan tilt left right\n");
+  for (size_t stSample = 0; stSample < rResult.vSamples.size(); stSample++) {
+    const std::vector<uint32_t> &vSample = rResult.vSamples[stSample];
+    fprintf(pFile, "pwm %u %u %u %u %u\n", vSample[0], vSample[1], vSample[2], vSample[3], vSample[4]);
+  }
+  return fclose(pFile) == 0;
+}
+
+/****************************************************/
+/* Method name:        readResult                   */
+/* Method description: Reads a golden run.          */
+/*                                                  */
+/* Input params:       cPath - File. (const char*)  */
+/*                     prResult - Filled run.       */
+/*                     (ReplayResult*)              */
+/* Output params:      true if read. (bool)         */
+/****************************************************/
+bool readResult(const char *cPath, ReplayResult *prResult)
+{
+  char cLine[256];
+  FILE *pFile = fopen(cPath, "r");
+  if (!pFile) return false;
+  memset(prResult->ulViewerParts, 0, sizeof(prResult->ulViewerParts));
+  memset(prResult->ulViewerBytes, 0, sizeof(prResult->ulViewerBytes));
+  prResult->ulFramesGrabbed = 0;
+  while (fgets(cLine, sizeof(cLine), pFile)) {
+    unsigned long ulA, ulB, ulC;
+    long lStop;
+    unsigned int uiSample[5];
+    int iViewer;
+    if (sscanf(cLine, "cliff %lu %ld", &ulA, &lStop) == 2) {
+      prResult->vCliffs.push_back(std::make_pair(ulA, lStop));
+    } else if (sscanf(cLine, "viewer %d %lu %lu", &iViewer, &ulB, &ulC) == 3 && 0 <= iViewer && iViewer < REPLAY_VIEWERS) {
+      prResult->ulViewerParts[iViewer] = ulB;
+      prResult->ulViewerBytes[iViewer] = ulC;
+    } else if (sscanf(cLine, "frames %lu", &ulA) == 1) {
+      prResult->ulFramesGrabbed = ulA;
+    } else if (sscanf(cLine, "pwm %u %u %u %u %u", &uiSample[0], &uiSample[1], &uiSample[2], &uiSample[3], &uiSample[4]) == 5) {
+      prResult->vSamples.push_back(std::vector<uint32_t>(uiSample, uiSample + 5));
+    }
+  }
+  fclose(pFile);
+  return true;
+}
+
+/****************************************************/
+/* Method name:        isWithin                     */
+/* Method description: Tells if a count is within   */
+/*                     the throughput tolerance.    */
+/*                                                  */
+/* Input params:       ulValue, ulGolden - Counts.  */
+/*                     (unsigned long)              */
+/* Output params:      true if close. (bool)        */
+/****************************************************/
+bool isWithin(unsigned long ulValue, unsigned long ulGolden)
+{
+  unsigned long ulDifference = ulValue < ulGolden ? ulGolden - ulValue : ulValue - ulGolden;
+  return ulDifference * 100 <= ulGolden * REPLAY_THROUGHPUT_TOLERANCE;
+}
+
+/****************************************************/
+/* Method name:        compareResults               */
+/* Method description: Prints where a run differs   */
+/*                     from the golden one.         */
+/*                                                  */
+/* Input params:       rResult, rGolden - Runs.     */
+/*                     (const ReplayResult&)        */
+/* Output params:      Differences. (int)           */
+/****************************************************/
+int compareResults(const ReplayResult &rResult, const ReplayResult &rGolden)
+{
+  int iDifferences = 0;
+
+  printf("\ndiff against the golden run\n");
+  if (rResult.vCliffs != rGolden.vCliffs) {
+    printf("  cliff stops differ:");
+    for (size_t stCliff = 0; stCliff < rGolden.vCliffs.size(); stCliff++) {
+      printf(" %lu->%ld", rGolden.vCliffs[stCliff].first, rGolden.vCliffs[stCliff].second);
+    }
+    printf(" in the golden run\n");
+    iDifferences++;
+  }
+  for (int iViewer = 0; iViewer < REPLAY_VIEWERS; iViewer++) {
+    if (!isWithin(rResult.ulViewerParts[iViewer], rGolden.ulViewerParts[iViewer])) {
+      printf("  viewer %d frames %lu, golden %lu\n", iViewer, rResult.ulViewerParts[iViewer], rGolden.ulViewerParts[iViewer]);
+      iDifferences++;
+    }
+  }
+  if (!isWithin(rResult.ulFramesGrabbed, rGolden.ulFramesGrabbed)) {
+    printf("  frames grabbed %lu, golden %lu\n", rResult.ulFramesGrabbed, rGolden.ulFramesGrabbed);
+    iDifferences++;
+  }
+  if (rResult.vSamples.size() != rGolden.vSamples.size()) {
+    printf("  %u PWM samples, golden %u\n", (unsigned)rResult.vSamples.size(), (unsigned)rGolden.vSamples.size());
+    iDifferences++;
+  }
+  size_t stSamples = std::min(rResult.vSamples.size(), rGolden.vSamples.size());
+  for (int iChannel = 0; iChannel < REPLAY_CHANNELS; iChannel++) {
+    unsigned long ulDiffering = 0;
+    unsigned long ulMaxDifference = 0;
+    long lFirstMs = -1;
+    for (size_t stSample = 0; stSample < stSamples; stSample++) {
+      long lValue = rResult.vSamples[stSample][1 + iChannel];
+      long lGolden = rGolden.vSamples[stSample][1 + iChannel];
+      if (lValue == lGolden) continue;
+      ulDiffering++;
+      ulMaxDifference = std::max<unsigned long>(ulMaxDifference, labs(lValue - lGolden));
+      if (lFirstMs < 0) lFirstMs = rResult.vSamples[stSample][0];
+    }
+    if (ulDiffering) {
+      printf("  %-5s duty differs in %lu of %u samples, by up to %lu, first at %ld ms\n", cChannelNames[iChannel],
+             ulDiffering, (unsigned)stSamples, ulMaxDifference, lFirstMs);
+      iDifferences++;
+    }
+  }
+  if (!iDifferences) printf("  none\n");
+  return iDifferences;
+}
+
+/****************************************************/
+/* Method name:        printReport                  */
+/* Method description: Prints what the run did.     */
+/*                                                  */
+/* Input params:       cTrace - Trace. (const char*)*/
+/*                     ulEndMs - Session end.       */
+/*                     (unsigned long)              */
+/*                     rResult - Run. (const        */
+/*                     ReplayResult&)               */
+/* Output params:      false if a cliff stop was    */
+/*                     missed or late. (bool)       */
+/****************************************************/
+bool printReport(const char *cTrace, unsigned long ulEndMs, const ReplayResult &rResult)
+{
+  bool bStopsInTime = true;
+  double dViewingS = (ulEndMs - REPLAY_VIEWERS_START_MS) / 1000.0;
+
+  printf("replay of %s: %u records, %lu ms, %u duty writes\n", cTrace, (unsigned)stTrace.getRecordCount(), ulEndMs,
+         (unsigned)vDuties.size());
+  printf("cloud: latency %lu/%lu ms, failed %lu/%lu\n", hgcPanTiltClient.getLastLatency(), hgcMovementClient.getLastLatency(),
+         hgcPanTiltClient.getFailedCount(), hgcMovementClient.getFailedCount());
+  for (size_t stCliff = 0; stCliff < rResult.vCliffs.size(); stCliff++) {
+    long lStopMs = rResult.vCliffs[stCliff].second;
+    long lLatencyMs = lStopMs - (long)rResult.vCliffs[stCliff].first;
+    if (lStopMs < 0 || REPLAY_CLIFF_STOP_LIMIT_MS < lLatencyMs) bStopsInTime = false;
+    if (lStopMs < 0) printf("cliff at %lu ms: never stopped\n", rResult.vCliffs[stCliff].first);
+    else printf("cliff at %lu ms: stopped at %ld ms, after %ld ms\n", rResult.vCliffs[stCliff].first, lStopMs, lLatencyMs);
+  }
+  printf("frames grabbed %lu, %lu skipped by a busy stream\n", rResult.ulFramesGrabbed, hsServer.getSkippedPartCount());
+  for (int iViewer = 0; iViewer < REPLAY_VIEWERS; iViewer++) {
+    printf("viewer %d (%s): %lu frames, %.1f fps, %.1f kB/s\n", iViewer, iViewer ? "slow" : "fast", rResult.ulViewerParts[iViewer],
+           rResult.ulViewerParts[iViewer] / dViewingS, rResult.ulViewerBytes[iViewer] / dViewingS / 1024);
+  }
+  return bStopsInTime;
+}
+
+/****************************************************/
+/* Method name:        writeDuties                  */
+/* Method description: Writes every duty written, as*/
+/*                     CSV.                         */
+/*                                                  */
+/* Input params:       cPath - File. (const char*)  */
+/* Output params:      true if written. (bool)      */
+/****************************************************/
+bool writeDuties(const char *cPath)
+{
+  FILE *pFile = fopen(cPath, "w");
+  if (!pFile) return false;
+  fprintf(pFile, "time_ms,channel,duty\n");
+  for (size_t stChange = 0; stChange < vDuties.size(); stChange++) {
+    for (int iChannel = 0; iChannel < REPLAY_CHANNELS; iChannel++) {
+      if (ui8Channels[iChannel] != vDuties[stChange].ui8Channel) continue;
+      fprintf(pFile, "%lu,%s,%u\n", vDuties[stChange].ulTimeMs, cChannelNames[iChannel], vDuties[stChange].ui32Duty);
+    }
+  }
+  return fclose(pFile) == 0;
+}
+
+/****************************************************/
+/* Method name:        main                         */
+/* Method description: Replays a trace and checks it*/
+/*                     against its golden run, or   */
+/*                     writes the golden run.       */
+/*                                                  */
+/* Input params:       trace.ursr golden [--write]  */
+/*                     [--pwm duties.csv]           */
+/* Output params:      0 if the run matches. (int)  */
+/****************************************************/
+int main(int argc, char **argv)
+{
+  const char *cTrace = 1 < argc ? argv[1] : NULL;
+  const char *cGolden = 2 < argc ? argv[2] : NULL;
+  const char *cDuties = NULL;
+  bool bWrite = false;
+  ReplayResult rResult;
+  ReplayResult rGolden;
+
+  for (int iArg = 3; iArg < argc; iArg++) {
+    if (strcmp(argv[iArg], "--write") == 0) bWrite = true;
+    else if (strcmp(argv[iArg], "--pwm") == 0 && iArg + 1 < argc) cDuties = argv[++iArg];
+  }
+  if (!cGolden) {
+    printf("Usage: %s trace.ursr golden [--write] [--pwm duties.csv]\n", argv[0]);
+    return 1;
+  }
+  if (!stTrace.load(cTrace)) {
+    printf("Can not read %s\n", cTrace);
+    return 1;
+  }
+
+  unsigned long ulEndMs = runSession(&rResult);
+  bool bPassed = printReport(cTrace, ulEndMs, rResult);
+  if (!bPassed) printf("A cliff stop was missed or took over %d ms\n", REPLAY_CLIFF_STOP_LIMIT_MS);
+  if (cDuties && !writeDuties(cDuties)) printf("Can not write %s\n", cDuties);
+  if (bWrite) {
+    bPassed = writeResult(cGolden, cTrace, rResult) && bPassed;
+    printf(bPassed ? "Wrote %s\n" : "Did not write %s\n", cGolden);
+  } else if (!readResult(cGolden, &rGolden)) {
+    printf("Can not read %s\n", cGolden);
+    bPassed = false;
+  } else if (compareResults(rResult, rGolden)) {
+    printf("SessionReplay regressed\n");
+    bPassed = false;
+  } else if (bPassed) {
+    printf("SessionReplay passed\n");
+  }
+  // The grab task is left waiting on the camera, exit would destroy what it waits on
+  fflush(stdout);
+  _exit(bPassed ? 0 : 1);
+}
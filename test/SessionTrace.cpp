@@ -0,0 +1,157 @@
+/**************************************************/
+/* File name:        SessionTrace.cpp             */
+/* File description: File for the implementation  */
+/*                   of SessionTrace Class, that  */
+/*                   reads back the records of a  */
+/*                   recorded session.            */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "SessionTrace.h"
+#include "SessionRecorder.h"
+
+/****************************************************/
+/* Method name:        readVarint                   */
+/* Method description: Reads a varint and advances  */
+/*                     the position.                */
+/*                                                  */
+/* Input params:       pData - Bytes. (const        */
+/*                     uint8_t*)                    */
+/*                     stLength - Size. (size_t)    */
+/*                     pstPosition - Position.      */
+/*                     (size_t*)                    */
+/*                     pulValue - Value read.       */
+/*                     (unsigned long*)             */
+/* Output params:      false if it runs past the    */
+/*                     end. (bool)                  */
+/****************************************************/
+static bool readVarint(const uint8_t *pData, size_t stLength, size_t *pstPosition, unsigned long *pulValue)
+{
+  unsigned long ulValue = 0;
+  for (int iByte = 0; iByte < SESSION_VARINT_MAX_SIZE; iByte++) {
+    if (stLength <= *pstPosition) return false;
+    uint8_t ui8Byte = pData[(*pstPosition)++];
+    ulValue |= (unsigned long)(ui8Byte & 0x7F) << (7 * iByte);
+    if (!(ui8Byte & 0x80)) {
+      *pulValue = ulValue;
+      return true;
+    }
+  }
+  return false;
+}
+
+/****************************************************/
+/* Method name:        load                         */
+/* Method description: Reads a recorded session.    */
+/*                                                  */
+/* Input params:       cPath - .ursr file. (const   */
+/*                     char*)                       */
+/* Output params:      true if it is a valid trace. */
+/*                     (bool)                       */
+/****************************************************/
+bool SessionTrace::load(const char *cPath)
+{
+  FILE *pFile = fopen(cPath, "rb");
+  if (!pFile) return false;
+  vBuffer.clear();
+  uint8_t ui8Chunk[4096];
+  size_t stRead;
+  while (0 < (stRead = fread(ui8Chunk, 1, sizeof(ui8Chunk), pFile))) {
+    vBuffer.insert(vBuffer.end(), ui8Chunk, ui8Chunk + stRead);
+  }
+  fclose(pFile);
+  return parse();
+}
+
+/****************************************************/
+/* Method name:        loadBuffer                   */
+/* Method description: Takes a recorded session from*/
+/*                     memory.                      */
+/*                                                  */
+/* Input params:       pData - Bytes. (const        */
+/*                     uint8_t*)                    */
+/*                     stLength - Size. (size_t)    */
+/* Output params:      true if it is a valid trace. */
+/*                     (bool)                       */
+/****************************************************/
+bool SessionTrace::loadBuffer(const uint8_t *pData, size_t stLength)
+{
+  vBuffer.assign(pData, pData + stLength);
+  return parse();
+}
+
+/****************************************************/
+/* Method name:        getRecordCount, getRecord    */
+/* Method description: Records in time order.       */
+/*                                                  */
+/* Input params:       stIndex - Record. (size_t)   */
+/* Output params:      Count, or the record. (const */
+/*                     SessionTraceRecord&)         */
+/****************************************************/
+size_t SessionTrace::getRecordCount() const
+{
+  return vRecords.size();
+}
+
+const SessionTraceRecord &SessionTrace::getRecord(size_t stIndex) const
+{
+  return vRecords[stIndex];
+}
+
+/****************************************************/
+/* Method name:        getVarint                    */
+/* Method description: Value of a varint record.    */
+/*                                                  */
+/* Input params:       srRecord - Record. (const    */
+/*                     SessionTraceRecord&)         */
+/* Output params:      Value. (unsigned long)       */
+/****************************************************/
+unsigned long SessionTrace::getVarint(const SessionTraceRecord &srRecord)
+{
+  size_t stPosition = 0;
+  unsigned long ulValue = 0;
+  readVarint(srRecord.pPayload, srRecord.stLength, &stPosition, &ulValue);
+  return ulValue;
+}
+
+/****************************************************/
+/* Method name:        parse                        */
+/* Method description: Splits the buffer in records.*/
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      false if the header or a     */
+/*                     record is broken. (bool)     */
+/****************************************************/
+bool SessionTrace::parse()
+{
+  const uint8_t *pData = vBuffer.data();
+  size_t stLength = vBuffer.size();
+  size_t stPosition = SESSION_HEADER_SIZE;
+  unsigned long ulTimeMs = 0;
+
+  vRecords.clear();
+  if (stLength < SESSION_HEADER_SIZE) return false;
+  if (memcmp(pData, SESSION_MAGIC, SESSION_HEADER_SIZE - 1) != 0) return false;
+  if (pData[SESSION_HEADER_SIZE - 1] != SESSION_VERSION) return false;
+
+  while (stPosition < stLength) {
+    SessionTraceRecord srRecord;
+    unsigned long ulDeltaMs;
+    unsigned long ulPayloadLength;
+    srRecord.ui8Type = pData[stPosition++];
+    if (!readVarint(pData, stLength, &stPosition, &ulDeltaMs)) return false;
+    if (!readVarint(pData, stLength, &stPosition, &ulPayloadLength)) return false;
+    if (stLength - stPosition < ulPayloadLength) return false;
+    ulTimeMs += ulDeltaMs;
+    srRecord.ulTimeMs = ulTimeMs;
+    srRecord.pPayload = pData + stPosition;
+    srRecord.stLength = ulPayloadLength;
+    stPosition += ulPayloadLength;
+    vRecords.push_back(srRecord);
+  }
+  return true;
+}
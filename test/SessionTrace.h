@@ -0,0 +1,105 @@
+/**************************************************/
+/* File name:        SessionTrace.h               */
+/* File description: Header File for the          */
+/*                   SessionTrace Class, that     */
+/*                   reads back the records of a  */
+/*                   session recorded by          */
+/*                   SessionRecorder on the host. */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef SessionTrace_h
+#define SessionTrace_h
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/****************************************************/
+/* Struct name:       SessionTraceRecord            */
+/* Struct description: One record with its absolute */
+/*                    time, the payload points into */
+/*                    the trace buffer.             */
+/****************************************************/
+struct SessionTraceRecord
+{
+  uint8_t ui8Type;
+  unsigned long ulTimeMs;
+  const uint8_t *pPayload;
+  size_t stLength;
+};
+
+/****************************************************/
+/* Class name:        SessionTrace                  */
+/* Class description: Class that loads a .ursr file */
+/*                    or buffer, checks the header  */
+/*                    and splits it in records with */
+/*                    the delta times summed up.    */
+/****************************************************/
+class SessionTrace
+{
+  private:
+    // Private Variables:
+    std::vector<uint8_t> vBuffer;
+    std::vector<SessionTraceRecord> vRecords;
+
+    /****************************************************/
+    /* Method name:        parse                        */
+    /* Method description: Splits the buffer in records.*/
+    /*                                                  */
+    /* Input params:                                    */
+    /* Output params:      false if the header or a     */
+    /*                     record is broken. (bool)     */
+    /****************************************************/
+    bool parse();
+
+  public:
+
+    /****************************************************/
+    /* Method name:        load                         */
+    /* Method description: Reads a recorded session.    */
+    /*                                                  */
+    /* Input params:       cPath - .ursr file. (const   */
+    /*                     char*)                       */
+    /* Output params:      true if it is a valid trace. */
+    /*                     (bool)                       */
+    /****************************************************/
+    bool load(const char *cPath);
+
+    /****************************************************/
+    /* Method name:        loadBuffer                   */
+    /* Method description: Takes a recorded session from*/
+    /*                     memory.                      */
+    /*                                                  */
+    /* Input params:       pData - Bytes. (const        */
+    /*                     uint8_t*)                    */
+    /*                     stLength - Size. (size_t)    */
+    /* Output params:      true if it is a valid trace. */
+    /*                     (bool)                       */
+    /****************************************************/
+    bool loadBuffer(const uint8_t *pData, size_t stLength);
+
+    /****************************************************/
+    /* Method name:        getRecordCount, getRecord    */
+    /* Method description: Records in time order.       */
+    /*                                                  */
+    /* Input params:       stIndex - Record. (size_t)   */
+    /* Output params:      Count, or the record. (const */
+    /*                     SessionTraceRecord&)         */
+    /****************************************************/
+    size_t getRecordCount() const;
+    const SessionTraceRecord &getRecord(size_t stIndex) const;
+
+    /****************************************************/
+    /* Method name:        getVarint                    */
+    /* Method description: Value of a varint record.    */
+    /*                                                  */
+    /* Input params:       srRecord - Record. (const    */
+    /*                     SessionTraceRecord&)         */
+    /* Output params:      Value. (unsigned long)       */
+    /****************************************************/
+    static unsigned long getVarint(const SessionTraceRecord &srRecord);
+};
+
+#endif
@@ -0,0 +1,355 @@
+/**************************************************/
+/* File name:        SetpointEvaluation.cpp       */
+/* File description: Replays the pan tilt updates */
+/*                   of recorded sessions through */
+/*                   SetpointReconstruction and a */
+/*                   servo model, and compares the*/
+/*                   tracking against applying    */
+/*                   each setpoint as it arrives. */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "SessionRecorder.h"
+#include "SessionTrace.h"
+#include "SetpointReconstruction.h"
+
+// Defines
+#define CONTROL_PERIOD_MS                10   // As the timer interrupt
+#define SERVO_FRAME_MS                   20   // 50 Hz PWM, the servo reads one pulse per frame
+#define SERVO_NATURAL_FREQUENCY          0.06 // rad/ms, about 9.5 Hz
+#define SERVO_DAMPING                    0.5
+#define SERVO_MAX_SPEED                  2.5  // 10 bit units/ms, 0.1 s/60 degrees
+#define SERVO_MAX_ACCELERATION           0.1  // 10 bit units/ms^2
+#define SERVO_STOP_SPEED                 0.02 // 10 bit units/ms, below it the servo is still
+#define SERVO_MOVE_SPEED                 0.1  // Above it the servo is moving again
+#define MAX_LAG_MS                       500  // Longest lag looked for
+#define LAG_STEP_MS                      5
+
+#define CHECK(bCondition) check((bCondition), #bCondition, __LINE__)
+
+// Variables
+int iFailures = 0;
+
+/****************************************************/
+/* Struct name:       Setpoint                      */
+/* Struct description: Pan tilt update and the time */
+/*                    it reached the robot.         */
+/****************************************************/
+struct Setpoint
+{
+  unsigned long ulTimeMs;
+  int iAxis[2];
+};
+
+/****************************************************/
+/* Struct name:       Tracking                      */
+/* Struct description: Result of one way of applying*/
+/*                    the setpoints.                */
+/****************************************************/
+struct Tracking
+{
+  double dMeanError;    // Servo to the setpoints joined by lines
+  double dLagError;     // Same, with the lines delayed by the lag
+  long lLagMs;          // Delay of the lines that fits the servo best
+  double dRmsAcceleration;
+  double dStopsPerUpdate; // Servo stops while the setpoints keep moving
+  int iMaxCommandStep;  // Between control periods
+};
+
+/****************************************************/
+/* Class name:        ServoModel                    */
+/* Class description: Hobby servo, a damped position*/
+/*                    loop with speed and torque    */
+/*                    limits, that reads the command*/
+/*                    once per PWM frame.           */
+/****************************************************/
+class ServoModel
+{
+  public:
+    double dPosition;
+    double dSpeed;
+    double dAcceleration;
+    double dCommand;
+
+    ServoModel(double dStart)
+    {
+      dPosition = dStart;
+      dSpeed = 0;
+      dAcceleration = 0;
+      dCommand = dStart;
+    }
+
+    void step(unsigned long ulNowMs, int iPulse)
+    {
+      if (ulNowMs % SERVO_FRAME_MS == 0) dCommand = iPulse;
+      double dWanted = SERVO_NATURAL_FREQUENCY * SERVO_NATURAL_FREQUENCY * (dCommand - dPosition) -
+                       2 * SERVO_DAMPING * SERVO_NATURAL_FREQUENCY * dSpeed;
+      dAcceleration = constrain(dWanted, -SERVO_MAX_ACCELERATION, SERVO_MAX_ACCELERATION);
+      dSpeed = constrain(dSpeed + dAcceleration, -SERVO_MAX_SPEED, SERVO_MAX_SPEED);
+      dPosition += dSpeed;
+    }
+};
+
+/****************************************************/
+/* Method name:        check                        */
+/* Method description: Reports a failed check.      */
+/*                                                  */
+/* Input params:       bCondition - Result. (bool)  */
+/*                     cText - Checked expression.  */
+/*                     (const char*)                */
+/*                     iLine - Source line. (int)   */
+/* Output params:                                   */
+/****************************************************/
+void check(bool bCondition, const char *cText, int iLine)
+{
+  if (bCondition) return;
+  printf("FAIL line %d: %s\n", iLine, cText);
+  iFailures++;
+}
+
+/****************************************************/
+/* Method name:        readSetpoints                */
+/* Method description: Pan tilt updates of a trace. */
+/*                                                  */
+/* Input params:       cPath - .ursr file. (const   */
+/*                     char*)                       */
+/*                     vSetpoints - Updates.        */
+/*                     (std::vector<Setpoint>&)     */
+/* Output params:      false if it can not be read. */
+/*                     (bool)                       */
+/****************************************************/
+bool readSetpoints(const char *cPath, std::vector<Setpoint> &vSetpoints)
+{
+  SessionTrace stTrace;
+  if (!stTrace.load(cPath)) return false;
+
+  vSetpoints.clear();
+  for (size_t stRecord = 0; stRecord < stTrace.getRecordCount(); stRecord++) {
+    const SessionTraceRecord &srRecord = stTrace.getRecord(stRecord);
+    if (srRecord.ui8Type != SESSION_RECORD_PANTILT) continue;
+    // Blynk answers ["pan","tilt"]
+    char cPayload[64];
+    size_t stLength = srRecord.stLength < sizeof(cPayload) - 1 ? srRecord.stLength : sizeof(cPayload) - 1;
+    memcpy(cPayload, srRecord.pPayload, stLength);
+    cPayload[stLength] = 0;
+    Setpoint spUpdate;
+    spUpdate.ulTimeMs = srRecord.ulTimeMs;
+    if (sscanf(cPayload, "[\"%d\",\"%d\"]", &spUpdate.iAxis[0], &spUpdate.iAxis[1]) != 2) continue;
+    vSetpoints.push_back(spUpdate);
+  }
+  return 1 < vSetpoints.size();
+}
+
+/****************************************************/
+/* Method name:        getReference                 */
+/* Method description: Setpoints of one axis joined */
+/*                     by lines, known only         */
+/*                     afterwards.                  */
+/*                                                  */
+/* Input params:       vSetpoints - Updates. (const */
+/*                     std::vector<Setpoint>&)      */
+/*                     iAxis - Axis. (int)          */
+/* Output params:      One value per ms, from the   */
+/*                     first update to the last.    */
+/*                     (std::vector<double>)        */
+/****************************************************/
+std::vector<double> getReference(const std::vector<Setpoint> &vSetpoints, int iAxis)
+{
+  std::vector<double> vReference;
+  for (size_t stUpdate = 0; stUpdate + 1 < vSetpoints.size(); stUpdate++) {
+    const Setpoint &spFrom = vSetpoints[stUpdate];
+    const Setpoint &spTo = vSetpoints[stUpdate + 1];
+    for (unsigned long ulNowMs = spFrom.ulTimeMs; ulNowMs < spTo.ulTimeMs; ulNowMs++) {
+      vReference.push_back(spFrom.iAxis[iAxis] + (double)(spTo.iAxis[iAxis] - spFrom.iAxis[iAxis]) *
+                           (ulNowMs - spFrom.ulTimeMs) / (spTo.ulTimeMs - spFrom.ulTimeMs));
+    }
+  }
+  return vReference;
+}
+
+/****************************************************/
+/* Method name:        replay                       */
+/* Method description: Drives one servo per axis    */
+/*                     through the updates, with the*/
+/*                     reconstruction or with each  */
+/*                     setpoint applied as is.      */
+/*                                                  */
+/* Input params:       vSetpoints - Updates. (const */
+/*                     std::vector<Setpoint>&)      */
+/*                     bReconstruct - Use           */
+/*                     SetpointReconstruction.      */
+/*                     (bool)                       */
+/* Output params:      Both axes together.          */
+/*                     (Tracking)                   */
+/****************************************************/
+Tracking replay(const std::vector<Setpoint> &vSetpoints, bool bReconstruct)
+{
+  Tracking tResult = { 0, 0, 0, 0, 0, 0 };
+  double dLagErrorSum[MAX_LAG_MS / LAG_STEP_MS + 1] = { 0 };
+  double dAccelerationSum = 0;
+  unsigned long ulSamples = 0;
+  unsigned long ulStops = 0;
+  unsigned long ulMovingUpdates = 0;
+  unsigned long ulStartMs = vSetpoints.front().ulTimeMs;
+  unsigned long ulEndMs = vSetpoints.back().ulTimeMs;
+
+  for (int iAxis = 0; iAxis < 2; iAxis++) {
+    SetpointReconstruction srSetpoint(511);
+    ServoModel smServo(511);
+    std::vector<double> vReference = getReference(vSetpoints, iAxis);
+    std::vector<double> vPosition;
+    int iLast = 511;
+    int iCommand = 511;
+    size_t stNext = 0;
+    bool bMoving = false;
+
+    for (unsigned long ulNowMs = 0; ulNowMs < ulEndMs; ulNowMs++) {
+      while (stNext < vSetpoints.size() && vSetpoints[stNext].ulTimeMs <= ulNowMs) {
+        if (stNext && vSetpoints[stNext].iAxis[iAxis] != iLast) ulMovingUpdates++;
+        iLast = vSetpoints[stNext].iAxis[iAxis];
+        srSetpoint.newSetpoint(iLast, ulNowMs);
+        stNext++;
+      }
+      if (ulNowMs % CONTROL_PERIOD_MS == 0) {
+        int iNewCommand = bReconstruct ? srSetpoint.getValue(ulNowMs) : iLast;
+        tResult.iMaxCommandStep = max(tResult.iMaxCommandStep, abs(iNewCommand - iCommand));
+        iCommand = iNewCommand;
+      }
+      smServo.step(ulNowMs, iCommand);
+      if (ulNowMs < ulStartMs) continue;
+
+      // A stop and go is a stop while the lines still move
+      double dSpeed = fabs(smServo.dSpeed);
+      if (bMoving && dSpeed < SERVO_STOP_SPEED) {
+        bMoving = false;
+        size_t stAt = ulNowMs - ulStartMs;
+        if (0 < stAt && stAt < vReference.size() && vReference[stAt] != vReference[stAt - 1]) ulStops++;
+      } else if (!bMoving && SERVO_MOVE_SPEED < dSpeed) {
+        bMoving = true;
+      }
+      dAccelerationSum += smServo.dAcceleration * smServo.dAcceleration;
+      vPosition.push_back(smServo.dPosition);
+      ulSamples++;
+    }
+
+    for (int iLag = 0; iLag <= MAX_LAG_MS / LAG_STEP_MS; iLag++) {
+      size_t stLagMs = iLag * LAG_STEP_MS;
+      for (size_t stAt = 0; stAt < vPosition.size(); stAt++) {
+        // Before the lines start the servo is compared to the first update
+        double dReference = stAt < stLagMs ? vReference.front() : vReference[min(stAt - stLagMs, vReference.size() - 1)];
+        dLagErrorSum[iLag] += fabs(vPosition[stAt] - dReference);
+      }
+    }
+  }
+  tResult.dMeanError = dLagErrorSum[0] / ulSamples;
+  tResult.dLagError = tResult.dMeanError;
+  for (int iLag = 1; iLag <= MAX_LAG_MS / LAG_STEP_MS; iLag++) {
+    if (dLagErrorSum[iLag] / ulSamples < tResult.dLagError) {
+      tResult.dLagError = dLagErrorSum[iLag] / ulSamples;
+      tResult.lLagMs = iLag * LAG_STEP_MS;
+    }
+  }
+  tResult.dRmsAcceleration = sqrt(dAccelerationSum / ulSamples) * 1000;
+  tResult.dStopsPerUpdate = ulMovingUpdates ? (double)ulStops / ulMovingUpdates : 0;
+  return tResult;
+}
+
+/****************************************************/
+/* Method name:        checkOnTimeMotion            */
+/* Method description: Checks that updates arriving */
+/*                     on time give a motion that   */
+/*                     never stops between them nor */
+/*                     overshoots them, and that a  */
+/*                     late update is extrapolated  */
+/*                     within the bounds.           */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void checkOnTimeMotion(void)
+{
+  SetpointReconstruction srSetpoint(100);
+  int iLast = 100;
+  int iHeldPeriods = 0;
+
+  // Steady motion, every update 250 ms after the last
+  for (int iUpdate = 1; iUpdate <= 20; iUpdate++) {
+    int iTarget = 100 + 30 * iUpdate;
+    unsigned long ulUpdateMs = 250UL * iUpdate;
+    srSetpoint.newSetpoint(iTarget, ulUpdateMs);
+    for (unsigned long ulNowMs = ulUpdateMs; ulNowMs < ulUpdateMs + 250; ulNowMs += CONTROL_PERIOD_MS) {
+      int iValue = srSetpoint.getValue(ulNowMs);
+      CHECK(iValue <= iTarget);
+      // One interval behind the operator, never more
+      CHECK(iTarget - 30 - 1 <= iValue);
+      if (2 <= iUpdate && iValue == iLast) iHeldPeriods++;
+      iLast = iValue;
+    }
+  }
+  CHECK(iHeldPeriods == 0);
+  CHECK(srSetpoint.getValue(5250) == 700);
+
+  // A late update keeps the motion going, bounded by the overshoot
+  int iLateMax = 0;
+  for (unsigned long ulNowMs = 5250; ulNowMs < 6000; ulNowMs += CONTROL_PERIOD_MS) {
+    iLateMax = max(iLateMax, srSetpoint.getValue(ulNowMs));
+  }
+  CHECK(700 < iLateMax);
+  CHECK(iLateMax <= 700 + SP_DEFAULT_MAX_OVERSHOOT);
+  CHECK(srSetpoint.getValue(6000) == 700);
+}
+
+/****************************************************/
+/* Method name:        main                         */
+/* Method description: Evaluates every trace given. */
+/*                                                  */
+/* Input params:       .ursr files.                 */
+/* Output params:      0 if the reconstruction moves*/
+/*                     the servo clearly smoother   */
+/*                     than the setpoints applied as*/
+/*                     is, with a bounded lag. (int)*/
+/****************************************************/
+int main(int argc, char **argv)
+{
+  double dBaselineSum = 0;
+  double dReconstructedSum = 0;
+
+  checkOnTimeMotion();
+  printf("%-22s %11s %9s %11s %11s %9s\n", "trace", "err st/rec", "lag", "lag err", "acc", "stops/upd");
+  for (int iArg = 1; iArg < argc; iArg++) {
+    std::vector<Setpoint> vSetpoints;
+    if (!readSetpoints(argv[iArg], vSetpoints)) {
+      printf("FAIL can not read pan tilt updates from %s\n", argv[iArg]);
+      iFailures++;
+      continue;
+    }
+    Tracking tBaseline = replay(vSetpoints, false);
+    Tracking tReconstructed = replay(vSetpoints, true);
+    const char *cName = strrchr(argv[iArg], '/') ? strrchr(argv[iArg], '/') + 1 : argv[iArg];
+    printf("%-22s %5.1f/%5.1f %4ld/%4ld %5.1f/%5.1f %5.1f/%5.1f %4.2f/%4.2f\n", cName,
+           tBaseline.dMeanError, tReconstructed.dMeanError, tBaseline.lLagMs, tReconstructed.lLagMs,
+           tBaseline.dLagError, tReconstructed.dLagError, tBaseline.dRmsAcceleration, tReconstructed.dRmsAcceleration,
+           tBaseline.dStopsPerUpdate, tReconstructed.dStopsPerUpdate);
+    // Clearly smoother, at most one interval more lag, and closer once the lag is taken out
+    CHECK(tReconstructed.dStopsPerUpdate * 2 <= tBaseline.dStopsPerUpdate);
+    CHECK(tReconstructed.dRmsAcceleration * 2 <= tBaseline.dRmsAcceleration);
+    CHECK(tReconstructed.iMaxCommandStep < tBaseline.iMaxCommandStep);
+    CHECK(tReconstructed.lLagMs <= tBaseline.lLagMs + SP_DEFAULT_INTERVAL_MS);
+    CHECK(tReconstructed.dLagError <= tBaseline.dLagError);
+    dBaselineSum += tBaseline.dStopsPerUpdate;
+    dReconstructedSum += tReconstructed.dStopsPerUpdate;
+  }
+  if (1 < argc) printf("stops per update %.2f reconstructed against %.2f stepped\n", dReconstructedSum / (argc - 1), dBaselineSum / (argc - 1));
+
+  if (iFailures) {
+    printf("%d check(s) failed\n", iFailures);
+    return 1;
+  }
+  printf("SetpointEvaluation passed\n");
+  return 0;
+}
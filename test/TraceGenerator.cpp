@@ -0,0 +1,305 @@
+/**************************************************/
+/* File name:        TraceGenerator.cpp           */
+/* File description: Writes synthetic .ursr      */
+/*                   sessions with the pan tilt   */
+/*                   updates an operator would    */
+/*                   send, and a drive with the   */
+/*                   sonar and camera inputs, for */
+/*                   the evaluations and replays  */
+/*                   when no recorded session is  */
+/*                   at hand.                     */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "SessionRecorder.h"
+
+// Defines
+#define SESSION_MS                       60000
+#define POLL_PERIOD_MS                   250  // Cloud poll schedule
+#define LATENCY_MIN_MS                   40   // HTTP GET round trip
+#define LATENCY_MAX_MS                   220
+#define LATENCY_TAIL_PERCENT             5    // Requests that also wait a retransmission
+#define LATENCY_TAIL_MS                  300
+#define MOVEMENT_LATENCY_MS              60   // Second GET after the pan tilt one
+#define TRACE_BUFFER_SIZE                (64 * 1024)
+
+#define DRIVE_SESSION_MS                 20000
+#define SONAR_PERIOD_MS                  60   // As CONTROL_SONAR_PERIOD_MS
+#define SONAR_FITTING_A                  54.6839 // FRONT_SENSOR_FITTING_A of URS.ino
+#define SONAR_FITTING_B                  5.7238  // FRONT_SENSOR_FITTING_B of URS.ino
+#define FLOOR_CM                         4.0  // Sonar to floor on flat ground
+#define FRAME_PERIOD_MS                  40   // 25 fps
+#define FRAME_SIZE_MIN                   12000
+#define FRAME_SIZE_MAX                   22000
+
+#define OPERATOR_HOLDS                   0    // Holds and moves to new targets
+#define OPERATOR_MOVES                   1    // Moves from target to target
+#define OPERATOR_SWEEPS                  2    // Sweeps back and forth
+
+// Variables
+unsigned long ulRandomState;
+
+/****************************************************/
+/* Struct name:       DriveEvent                    */
+/* Struct description: One input of the drive, they */
+/*                    are recorded in time order.   */
+/****************************************************/
+struct DriveEvent
+{
+  unsigned long ulTimeMs;
+  uint8_t ui8Type;
+  std::string sText;
+  unsigned long ulValue;
+};
+
+/****************************************************/
+/* Method name:        getRandom                    */
+/* Method description: Portable generator, so every */
+/*                     host writes the same traces. */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Value in [0, 1). (double)    */
+/****************************************************/
+double getRandom(void)
+{
+  ulRandomState = (ulRandomState * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+  return (double)(ulRandomState >> 8) / (double)(0x7FFFFFFFUL >> 8);
+}
+
+/****************************************************/
+/* Method name:        buildOperatorPath            */
+/* Method description: Joystick position of one axis*/
+/*                     for every ms of the session. */
+/*                                                  */
+/* Input params:       iOperator - OPERATOR_*. (int)*/
+/*                     vPath - Filled path.         */
+/*                     (std::vector<double>&)       */
+/* Output params:                                   */
+/****************************************************/
+void buildOperatorPath(int iOperator, std::vector<double> &vPath)
+{
+  double dPosition = 511;
+  int iMs = 0;
+
+  vPath.assign(SESSION_MS + 1, dPosition);
+  while (iMs <= SESSION_MS) {
+    int iSegment = iOperator;
+    if (iOperator == OPERATOR_HOLDS) iSegment = getRandom() < 0.5 ? OPERATOR_HOLDS : OPERATOR_MOVES;
+
+    if (iSegment == OPERATOR_HOLDS) {
+      int iHoldMs = 300 + (int)(1500 * getRandom());
+      for (int iStep = 0; iStep < iHoldMs && iMs <= SESSION_MS; iStep++) vPath[iMs++] = dPosition;
+    } else if (iSegment == OPERATOR_MOVES) {
+      // Smooth start and stop, as a thumb on the joystick
+      double dTarget = 200 + 700 * getRandom();
+      double dSpeed = 0.15 + 0.9 * getRandom();
+      int iMoveMs = std::max(80, (int)(fabs(dTarget - dPosition) / dSpeed));
+      double dStart = dPosition;
+      for (int iStep = 0; iStep < iMoveMs && iMs <= SESSION_MS; iStep++) {
+        vPath[iMs++] = dStart + (dTarget - dStart) * (1 - cos(M_PI * iStep / iMoveMs)) / 2;
+      }
+      dPosition = dTarget;
+    } else {
+      double dFrequencyHz = 0.1 + 0.4 * getRandom();
+      double dAmplitude = 100 + 250 * getRandom();
+      int iSweepMs = 3000 + (int)(4000 * getRandom());
+      double dCenter = dPosition;
+      for (int iStep = 0; iStep < iSweepMs && iMs <= SESSION_MS; iStep++) {
+        // The joystick stops at the ends of its range
+        vPath[iMs++] = constrain(dCenter + dAmplitude * sin(2 * M_PI * dFrequencyHz * iStep / 1000), 0.0, 1023.0);
+      }
+      dPosition = vPath[iMs - 1];
+    }
+  }
+}
+
+/****************************************************/
+/* Method name:        writeTrace                   */
+/* Method description: Records the updates of one   */
+/*                     operator as updateControl    */
+/*                     would and writes the file.   */
+/*                                                  */
+/* Input params:       cPath - Output file. (const  */
+/*                     char*)                       */
+/*                     iOperator - OPERATOR_*. (int)*/
+/*                     ulSeed - Random seed.        */
+/*                     (unsigned long)              */
+/* Output params:      true if written. (bool)      */
+/****************************************************/
+bool writeTrace(const char *cPath, int iOperator, unsigned long ulSeed)
+{
+  static uint8_t ui8Buffer[TRACE_BUFFER_SIZE];
+  SessionRecorder srRecorder;
+  std::vector<double> vPan;
+  std::vector<double> vTilt;
+  unsigned long ulLastArrivalMs = 0;
+  char cPayload[32];
+
+  ulRandomState = ulSeed;
+  buildOperatorPath(iOperator, vPan);
+  buildOperatorPath(iOperator, vTilt);
+  srRecorder.begin(ui8Buffer, sizeof(ui8Buffer), 0);
+
+  for (int iPollMs = POLL_PERIOD_MS; iPollMs < SESSION_MS; iPollMs += POLL_PERIOD_MS) {
+    // The cloud answers with the position at the poll, it arrives later
+    double dLatencyMs = LATENCY_MIN_MS + (LATENCY_MAX_MS - LATENCY_MIN_MS) * getRandom();
+    if (getRandom() * 100 < LATENCY_TAIL_PERCENT) dLatencyMs += LATENCY_TAIL_MS * getRandom();
+    unsigned long ulArrivalMs = iPollMs + (unsigned long)dLatencyMs;
+    if (ulArrivalMs <= ulLastArrivalMs) ulArrivalMs = ulLastArrivalMs + 1;
+    ulLastArrivalMs = ulArrivalMs + MOVEMENT_LATENCY_MS;
+
+    snprintf(cPayload, sizeof(cPayload), "[\"%d\",\"%d\"]", (int)lround(vPan[iPollMs]), (int)lround(vTilt[iPollMs]));
+    srRecorder.recordText(SESSION_RECORD_PANTILT, cPayload, ulArrivalMs);
+    srRecorder.recordText(SESSION_RECORD_MOVEMENT, "[\"511\",\"511\"]", ulLastArrivalMs);
+  }
+  if (srRecorder.getDroppedRecords()) return false;
+
+  FILE *pFile = fopen(cPath, "wb");
+  if (!pFile) return false;
+  bool bWritten = fwrite(srRecorder.getData(), 1, srRecorder.getLength(), pFile) == srRecorder.getLength();
+  fclose(pFile);
+  return bWritten;
+}
+
+/****************************************************/
+/* Method name:        getDriveCommand              */
+/* Method description: Joystick of the drive: still,*/
+/*                     forward into a drop, back,   */
+/*                     forward and turning over a   */
+/*                     step, still.                 */
+/*                                                  */
+/* Input params:       ulTimeMs - Time. (unsigned   */
+/*                     long)                        */
+/*                     pX, pY - Axes. (int*)        */
+/* Output params:                                   */
+/****************************************************/
+void getDriveCommand(unsigned long ulTimeMs, int *pX, int *pY)
+{
+  *pX = 511;
+  *pY = 511;
+  if (2000 <= ulTimeMs && ulTimeMs < 9000) *pY = 850;
+  else if (10000 <= ulTimeMs && ulTimeMs < 11500) *pY = 200;
+  else if (13000 <= ulTimeMs && ulTimeMs < 18000) {
+    *pX = 600;
+    *pY = 850;
+  }
+}
+
+/****************************************************/
+/* Method name:        getFloorEcho                 */
+/* Method description: Echo the floor sensor reads: */
+/*                     no echo over the drop, a far */
+/*                     one over the step.           */
+/*                                                  */
+/* Input params:       ulTimeMs - Time. (unsigned   */
+/*                     long)                        */
+/* Output params:      Echo in us. (unsigned long)  */
+/****************************************************/
+unsigned long getFloorEcho(unsigned long ulTimeMs)
+{
+  double dDistanceCm = FLOOR_CM + 0.6 * (getRandom() - 0.5);
+  if (6000 <= ulTimeMs && ulTimeMs < 8500) return 0;
+  if (15000 <= ulTimeMs && ulTimeMs < 15800) dDistanceCm = 35;
+  return (unsigned long)lround(dDistanceCm * SONAR_FITTING_A + SONAR_FITTING_B);
+}
+
+/****************************************************/
+/* Method name:        writeDriveTrace              */
+/* Method description: Records a drive with the     */
+/*                     cloud, sonar and frame inputs*/
+/*                     and writes the file.         */
+/*                                                  */
+/* Input params:       cPath - Output file. (const  */
+/*                     char*)                       */
+/*                     ulSeed - Random seed.        */
+/*                     (unsigned long)              */
+/* Output params:      true if written. (bool)      */
+/****************************************************/
+bool writeDriveTrace(const char *cPath, unsigned long ulSeed)
+{
+  static uint8_t ui8Buffer[TRACE_BUFFER_SIZE];
+  SessionRecorder srRecorder;
+  std::vector<double> vPan;
+  std::vector<double> vTilt;
+  std::vector<DriveEvent> vEvents;
+  char cPayload[32];
+  int iX, iY;
+
+  ulRandomState = ulSeed;
+  buildOperatorPath(OPERATOR_HOLDS, vPan);
+  buildOperatorPath(OPERATOR_HOLDS, vTilt);
+  for (int iPollMs = POLL_PERIOD_MS; iPollMs < DRIVE_SESSION_MS; iPollMs += POLL_PERIOD_MS) {
+    unsigned long ulArrivalMs = iPollMs + LATENCY_MIN_MS + (unsigned long)((LATENCY_MAX_MS - LATENCY_MIN_MS) * getRandom());
+    snprintf(cPayload, sizeof(cPayload), "[\"%d\",\"%d\"]", (int)lround(vPan[iPollMs]), (int)lround(vTilt[iPollMs]));
+    vEvents.push_back({ulArrivalMs, SESSION_RECORD_PANTILT, cPayload, 0});
+    getDriveCommand(iPollMs, &iX, &iY);
+    snprintf(cPayload, sizeof(cPayload), "[\"%d\",\"%d\"]", iX, iY);
+    vEvents.push_back({ulArrivalMs + MOVEMENT_LATENCY_MS, SESSION_RECORD_MOVEMENT, cPayload, 0});
+  }
+  for (unsigned long ulMs = SONAR_PERIOD_MS; ulMs < DRIVE_SESSION_MS; ulMs += SONAR_PERIOD_MS) {
+    vEvents.push_back({ulMs, SESSION_RECORD_SONAR, "", getFloorEcho(ulMs)});
+  }
+  for (unsigned long ulMs = 500; ulMs < DRIVE_SESSION_MS; ulMs += FRAME_PERIOD_MS) {
+    unsigned long ulSize = FRAME_SIZE_MIN + (unsigned long)((FRAME_SIZE_MAX - FRAME_SIZE_MIN) * getRandom());
+    vEvents.push_back({ulMs, SESSION_RECORD_FRAME_SIZE, "", ulSize});
+  }
+  std::stable_sort(vEvents.begin(), vEvents.end(),
+                   [](const DriveEvent &deA, const DriveEvent &deB) { return deA.ulTimeMs < deB.ulTimeMs; });
+
+  srRecorder.begin(ui8Buffer, sizeof(ui8Buffer), 0);
+  for (size_t stEvent = 0; stEvent < vEvents.size(); stEvent++) {
+    const DriveEvent &deEvent = vEvents[stEvent];
+    if (deEvent.sText.empty()) srRecorder.recordValue(deEvent.ui8Type, deEvent.ulValue, deEvent.ulTimeMs);
+    else srRecorder.recordText(deEvent.ui8Type, deEvent.sText.c_str(), deEvent.ulTimeMs);
+  }
+  if (srRecorder.getDroppedRecords()) return false;
+
+  FILE *pFile = fopen(cPath, "wb");
+  if (!pFile) return false;
+  bool bWritten = fwrite(srRecorder.getData(), 1, srRecorder.getLength(), pFile) == srRecorder.getLength();
+  fclose(pFile);
+  return bWritten;
+}
+
+/****************************************************/
+/* Method name:        main                         */
+/* Method description: Writes the committed traces  */
+/*                     to the given directory.      */
+/*                                                  */
+/* Input params:       Output directory.            */
+/* Output params:      0 if every trace was written.*/
+/*                     (int)                        */
+/****************************************************/
+int main(int argc, char **argv)
+{
+  const char *cDirectory = 1 < argc ? argv[1] : "traces";
+  const struct { const char *cName; int iOperator; unsigned long ulSeed; } sTraces[] = {
+    { "pantilt-holds.ursr",  OPERATOR_HOLDS,  11 },
+    { "pantilt-moves.ursr",  OPERATOR_MOVES,  21 },
+    { "pantilt-sweeps.ursr", OPERATOR_SWEEPS, 31 },
+  };
+  char cPath[256];
+
+  for (unsigned int uiTrace = 0; uiTrace < sizeof(sTraces) / sizeof(sTraces[0]); uiTrace++) {
+    snprintf(cPath, sizeof(cPath), "%s/%s", cDirectory, sTraces[uiTrace].cName);
+    if (!writeTrace(cPath, sTraces[uiTrace].iOperator, sTraces[uiTrace].ulSeed)) {
+      printf("Can not write %s\n", cPath);
+      return 1;
+    }
+    printf("Wrote %s\n", cPath);
+  }
+  snprintf(cPath, sizeof(cPath), "%s/%s", cDirectory, "drive-cliff.ursr");
+  if (!writeDriveTrace(cPath, 41)) {
+    printf("Can not write %s\n", cPath);
+    return 1;
+  }
+  printf("Wrote %s\n", cPath);
+  return 0;
+}
@@ -0,0 +1,160 @@
+/**************************************************/
+/* File name:        Arduino.cpp                  */
+/* File description: Virtual clock, sonar echo,   */
+/*                   PWM and timer alarms of the  */
+/*                   host Arduino stand-in.       */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <atomic>
+#include "Arduino.h"
+#include "Shim.h"
+
+#define SHIM_LEDC_CHANNELS               16
+#define SHIM_TIMERS                      4
+#define SHIM_APB_CLOCK_MHZ               80
+
+struct ShimTimer
+{
+  uint16_t ui16Divider;
+  uint64_t ui64AlarmValue;
+  void (*fnInterrupt)(void);
+  bool bEnabled;
+  unsigned long long ullNextUs;
+};
+
+HardwareSerial Serial;
+
+// Shim tasks run on threads and move the clock too
+static std::atomic<unsigned long> aulVirtualMs(0);
+// Below one ms, only the loop thread waits in us
+static unsigned long ulPendingUs = 0;
+static ShimPulseSource fnPulseSource = NULL;
+static ShimLedcObserver fnLedcObserver = NULL;
+static uint32_t ui32LedcDuties[SHIM_LEDC_CHANNELS];
+static ShimTimer stTimers[SHIM_TIMERS];
+// Time of the alarm being fired, the clock may be ahead of it
+static long lFiringMs = -1;
+
+unsigned long millis(void)
+{
+  return aulVirtualMs.load();
+}
+
+void delay(unsigned long ulMs)
+{
+  aulVirtualMs += ulMs;
+}
+
+void delayMicroseconds(unsigned int uiUs)
+{
+  ulPendingUs += uiUs;
+  aulVirtualMs += ulPendingUs / 1000;
+  ulPendingUs %= 1000;
+}
+
+unsigned long pulseIn(uint8_t ui8Pin, uint8_t ui8State, unsigned long ulTimeoutUs)
+{
+  (void)ui8State;
+  unsigned long ulEchoUs = fnPulseSource ? fnPulseSource(ui8Pin, ulTimeoutUs) : 0;
+  if (ulTimeoutUs < ulEchoUs) ulEchoUs = 0;
+  // The call lasts as long as the echo, or the whole timeout without one
+  unsigned long ulWaitUs = ulEchoUs ? ulEchoUs : ulTimeoutUs;
+  while (0 < ulWaitUs) {
+    unsigned int uiStepUs = ulWaitUs < 60000 ? ulWaitUs : 60000;
+    delayMicroseconds(uiStepUs);
+    ulWaitUs -= uiStepUs;
+  }
+  return ulEchoUs;
+}
+
+double ledcSetup(uint8_t ui8Channel, double dFrequency, uint8_t ui8Resolution)
+{
+  (void)ui8Channel;
+  (void)ui8Resolution;
+  return dFrequency;
+}
+
+void ledcAttachPin(uint8_t ui8Pin, uint8_t ui8Channel)
+{
+  (void)ui8Pin;
+  (void)ui8Channel;
+}
+
+void ledcWrite(uint8_t ui8Channel, uint32_t ui32Duty)
+{
+  if (SHIM_LEDC_CHANNELS <= ui8Channel) return;
+  ui32LedcDuties[ui8Channel] = ui32Duty;
+  if (fnLedcObserver) fnLedcObserver(0 <= lFiringMs ? (unsigned long)lFiringMs : millis(), ui8Channel, ui32Duty);
+}
+
+hw_timer_t *timerBegin(uint8_t ui8Number, uint16_t ui16Divider, bool bCountUp)
+{
+  (void)bCountUp;
+  if (SHIM_TIMERS <= ui8Number) return NULL;
+  ShimTimer *pTimer = &stTimers[ui8Number];
+  memset(pTimer, 0, sizeof(*pTimer));
+  pTimer->ui16Divider = ui16Divider;
+  return pTimer;
+}
+
+void timerAttachInterrupt(hw_timer_t *pTimer, void (*fnInterrupt)(void), bool bEdge)
+{
+  (void)bEdge;
+  pTimer->fnInterrupt = fnInterrupt;
+}
+
+void timerAlarmWrite(hw_timer_t *pTimer, uint64_t ui64AlarmValue, bool bAutoReload)
+{
+  (void)bAutoReload;
+  pTimer->ui64AlarmValue = ui64AlarmValue;
+}
+
+void timerAlarmEnable(hw_timer_t *pTimer)
+{
+  pTimer->bEnabled = true;
+  pTimer->ullNextUs = millis() * 1000ULL + pTimer->ui64AlarmValue * pTimer->ui16Divider / SHIM_APB_CLOCK_MHZ;
+}
+
+void shimSetMillis(unsigned long ulMs)
+{
+  aulVirtualMs = ulMs;
+}
+
+void shimAdvanceMillis(unsigned long ulMs)
+{
+  aulVirtualMs += ulMs;
+}
+
+void shimSetPulseSource(ShimPulseSource fnSource)
+{
+  fnPulseSource = fnSource;
+}
+
+void shimSetLedcObserver(ShimLedcObserver fnObserver)
+{
+  fnLedcObserver = fnObserver;
+}
+
+uint32_t shimGetLedcDuty(uint8_t ui8Channel)
+{
+  return ui8Channel < SHIM_LEDC_CHANNELS ? ui32LedcDuties[ui8Channel] : 0;
+}
+
+void shimRunTimers(void)
+{
+  unsigned long long ullNowUs = millis() * 1000ULL;
+  for (int iTimer = 0; iTimer < SHIM_TIMERS; iTimer++) {
+    ShimTimer *pTimer = &stTimers[iTimer];
+    unsigned long long ullPeriodUs = pTimer->ui64AlarmValue * pTimer->ui16Divider / SHIM_APB_CLOCK_MHZ;
+    if (!pTimer->bEnabled || !pTimer->fnInterrupt || !ullPeriodUs) continue;
+    while (pTimer->ullNextUs <= ullNowUs) {
+      lFiringMs = pTimer->ullNextUs / 1000;
+      pTimer->fnInterrupt();
+      pTimer->ullNextUs += ullPeriodUs;
+    }
+  }
+  lFiringMs = -1;
+}
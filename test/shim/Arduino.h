@@ -0,0 +1,107 @@
+/**************************************************/
+/* File name:        Arduino.h                    */
+/* File description: Host stand-in for the parts  */
+/*                   of the Arduino core that the */
+/*                   URS classes and sketch use,  */
+/*                   so they build and run in the */
+/*                   tests.                       */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef Arduino_h
+#define Arduino_h
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+
+using std::min;
+using std::max;
+
+typedef bool boolean;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline long map(long lValue, long lInMin, long lInMax, long lOutMin, long lOutMax)
+{
+  return (lValue - lInMin) * (lOutMax - lOutMin) / (lInMax - lInMin) + lOutMin;
+}
+
+#define LOW                              0
+#define HIGH                             1
+#define INPUT                            0
+#define OUTPUT                           1
+
+#define F(cText)                         (cText)
+
+// Virtual time, moved by the tests and the shims, see Shim.h
+unsigned long millis(void);
+void delay(unsigned long ulMs);
+void delayMicroseconds(unsigned int uiUs);
+
+inline void pinMode(int iPin, int iMode) { (void)iPin; (void)iMode; }
+inline void digitalWrite(int iPin, int iValue) { (void)iPin; (void)iValue; }
+
+// Echo from the source set with shimSetPulseSource, it takes the pulse time
+unsigned long pulseIn(uint8_t ui8Pin, uint8_t ui8State, unsigned long ulTimeoutUs = 1000000L);
+
+// Duties are kept for shimGetLedcDuty and reported to the observer
+double ledcSetup(uint8_t ui8Channel, double dFrequency, uint8_t ui8Resolution);
+void ledcAttachPin(uint8_t ui8Pin, uint8_t ui8Channel);
+void ledcWrite(uint8_t ui8Channel, uint32_t ui32Duty);
+
+// Alarms fire from shimRunTimers, never by themselves
+typedef struct ShimTimer hw_timer_t;
+hw_timer_t *timerBegin(uint8_t ui8Number, uint16_t ui16Divider, bool bCountUp);
+void timerAttachInterrupt(hw_timer_t *pTimer, void (*fnInterrupt)(void), bool bEdge);
+void timerAlarmWrite(hw_timer_t *pTimer, uint64_t ui64AlarmValue, bool bAutoReload);
+void timerAlarmEnable(hw_timer_t *pTimer);
+
+inline void *ps_malloc(size_t stSize) { return malloc(stSize); }
+
+/****************************************************/
+/* Class name:        String                        */
+/* Class description: Text the sketch builds its    */
+/*                    reports in.                   */
+/****************************************************/
+class String
+{
+  private:
+    std::string sText;
+
+  public:
+    String(const char *cText = "") : sText(cText) {}
+    String &operator+=(const char *cText) { sText += cText; return *this; }
+    String &operator+=(const String &sOther) { sText += sOther.sText; return *this; }
+    template <typename Number>
+    String &operator+=(Number nValue) { sText += std::to_string(nValue); return *this; }
+    const char *c_str() const { return sText.c_str(); }
+    unsigned int length() const { return sText.size(); }
+};
+
+/****************************************************/
+/* Class name:        HardwareSerial                */
+/* Class description: Console of the sketch, the    */
+/*                    host runs drop what it prints.*/
+/****************************************************/
+class HardwareSerial
+{
+  public:
+    void begin(unsigned long ulBaud) { (void)ulBaud; }
+    template <typename Printable>
+    void print(const Printable &pValue) { (void)pValue; }
+    template <typename Printable>
+    void println(const Printable &pValue) { (void)pValue; }
+    void println(void) {}
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,55 @@
+/**************************************************/
+/* File name:        Arduino_JSON.cpp             */
+/* File description: Host stand-in for the        */
+/*                   Arduino_JSON parser.         */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include "Arduino_JSON.h"
+
+JSONClass JSON;
+
+/****************************************************/
+/* Method name:        trimValue                    */
+/* Method description: Drops the blanks and quotes  */
+/*                     around a scalar.             */
+/*                                                  */
+/* Input params:       sValue - Scalar.             */
+/*                     (std::string)                */
+/* Output params:      Text. (std::string)          */
+/****************************************************/
+static std::string trimValue(std::string sValue)
+{
+  size_t stBegin = sValue.find_first_not_of(" \t\r\n\"");
+  size_t stEnd = sValue.find_last_not_of(" \t\r\n\"");
+  if (stBegin == std::string::npos) return "";
+  return sValue.substr(stBegin, stEnd - stBegin + 1);
+}
+
+JSONVar JSONVar::operator[](int iIndex) const
+{
+  if (iIndex < 0 || (int)vItems.size() <= iIndex) return JSONVar();
+  return JSONVar(vItems[iIndex]);
+}
+
+JSONVar JSONClass::parse(const char *cText)
+{
+  std::string sText(cText ? cText : "");
+  size_t stOpen = sText.find('[');
+  if (stOpen == std::string::npos) return JSONVar(trimValue(sText));
+
+  std::vector<std::string> vItems;
+  size_t stClose = sText.find(']', stOpen);
+  std::string sList = sText.substr(stOpen + 1, stClose == std::string::npos ? std::string::npos : stClose - stOpen - 1);
+  size_t stStart = 0;
+  while (stStart <= sList.size()) {
+    size_t stComma = sList.find(',', stStart);
+    if (stComma == std::string::npos) stComma = sList.size();
+    std::string sItem = trimValue(sList.substr(stStart, stComma - stStart));
+    if (!sItem.empty() || stComma < sList.size()) vItems.push_back(sItem);
+    stStart = stComma + 1;
+  }
+  return JSONVar(sText, vItems);
+}
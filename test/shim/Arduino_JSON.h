@@ -0,0 +1,53 @@
+/**************************************************/
+/* File name:        Arduino_JSON.h               */
+/* File description: Host stand-in for the        */
+/*                   Arduino_JSON parser, enough  */
+/*                   for the flat arrays of the   */
+/*                   cloud payloads.              */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef Arduino_JSON_h
+#define Arduino_JSON_h
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+/****************************************************/
+/* Class name:        JSONVar                       */
+/* Class description: A scalar as its text, or a    */
+/*                    flat array of scalars. Missing*/
+/*                    or non numeric values read as */
+/*                    0.                            */
+/****************************************************/
+class JSONVar
+{
+  private:
+    std::string sText;
+    std::vector<std::string> vItems;
+
+  public:
+    JSONVar() {}
+    explicit JSONVar(const std::string &sValue) : sText(sValue) {}
+    JSONVar(const std::string &sValue, const std::vector<std::string> &vValues) : sText(sValue), vItems(vValues) {}
+    JSONVar operator[](int iIndex) const;
+    operator int() const { return atoi(sText.c_str()); }
+    const char *c_str() const { return sText.c_str(); }
+};
+
+/****************************************************/
+/* Class name:        JSONClass                     */
+/* Class description: Parser, the JSON object.      */
+/****************************************************/
+class JSONClass
+{
+  public:
+    JSONVar parse(const char *cText);
+    JSONVar parse(const JSONVar &jvValue) { return parse(jvValue.c_str()); }
+};
+
+extern JSONClass JSON;
+
+#endif
@@ -0,0 +1,110 @@
+/**************************************************/
+/* File name:        HttpGetClient.cpp            */
+/* File description: Host stand-in for the        */
+/*                   HttpGetClient Class, linked  */
+/*                   instead of the socket one.   */
+/*                   Answers come from the source */
+/*                   set with shimSetHttpGetSource*/
+/*                   at the virtual time it gives.*/
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include "HttpGetClient.h"
+#include "Shim.h"
+
+static ShimHttpGetSource fnHttpGetSource = NULL;
+// Answer time and result of the request running on each client
+static std::map<const HttpGetClient *, std::pair<unsigned long, bool> > mPending;
+
+HttpGetClient::HttpGetClient()
+{
+  cHost[0] = '\0';
+  ui16Port = 80;
+  cRequest[0] = '\0';
+  stRequestLength = 0;
+  stRequestSent = 0;
+  cResponse[0] = '\0';
+  stResponseLength = 0;
+  pBody = cResponse;
+  iStatus = 0;
+  ui32Address = 0;
+  bResolved = false;
+  ulResolveMs = 0;
+  iSocket = -1;
+  iState = HTTP_GET_IDLE;
+  bConnecting = false;
+  bReused = false;
+  bKeepAlive = false;
+  ulStartMs = 0;
+  ulLastLatencyMs = 0;
+  ulFailed = 0;
+}
+
+bool HttpGetClient::begin(const char *cUrl, unsigned long ulNowMs)
+{
+  (void)ulNowMs;
+  // The whole URL is what the source is asked for
+  snprintf(cRequest, sizeof(cRequest), "%s", cUrl);
+  stRequestLength = strlen(cRequest);
+  bResolved = strncmp(cUrl, "http://", 7) == 0;
+  iState = HTTP_GET_IDLE;
+  return bResolved;
+}
+
+bool HttpGetClient::request(unsigned long ulNowMs)
+{
+  unsigned long ulReadyMs = ulNowMs + HTTP_GET_TIMEOUT_MS;
+  if (!bResolved || iState == HTTP_GET_BUSY) return false;
+  bool bAnswered = fnHttpGetSource && fnHttpGetSource(cRequest, ulNowMs, &ulReadyMs, cResponse, sizeof(cResponse));
+  // Without an answer the request fails at its timeout
+  if (!bAnswered || ulNowMs + HTTP_GET_TIMEOUT_MS < ulReadyMs) ulReadyMs = ulNowMs + HTTP_GET_TIMEOUT_MS;
+  mPending[this] = std::make_pair(ulReadyMs, bAnswered && ulReadyMs - ulNowMs < HTTP_GET_TIMEOUT_MS);
+  ulStartMs = ulNowMs;
+  iState = HTTP_GET_BUSY;
+  return true;
+}
+
+int HttpGetClient::poll(unsigned long ulNowMs)
+{
+  if (iState != HTTP_GET_BUSY || ulNowMs < mPending[this].first) return iState;
+  // Reported once, as the socket client does
+  iState = HTTP_GET_IDLE;
+  if (!mPending[this].second) {
+    ulFailed++;
+    return HTTP_GET_FAILED;
+  }
+  iStatus = 200;
+  pBody = cResponse;
+  ulLastLatencyMs = ulNowMs - ulStartMs;
+  return HTTP_GET_DONE;
+}
+
+int HttpGetClient::getStatus()
+{
+  return iStatus;
+}
+
+const char *HttpGetClient::getBody()
+{
+  return pBody;
+}
+
+unsigned long HttpGetClient::getLastLatency()
+{
+  return ulLastLatencyMs;
+}
+
+unsigned long HttpGetClient::getFailedCount()
+{
+  return ulFailed;
+}
+
+void shimSetHttpGetSource(ShimHttpGetSource fnSource)
+{
+  fnHttpGetSource = fnSource;
+}
@@ -0,0 +1,361 @@
+/**************************************************/
+/* File name:        HttpServer.cpp               */
+/* File description: Host stand-in for the        */
+/*                   HttpServer Class, linked     */
+/*                   instead of the socket one.   */
+/*                   Clients are opened with      */
+/*                   shimOpenHttpClient and read  */
+/*                   at a fixed rate in virtual   */
+/*                   time. Parts are pushed and   */
+/*                   skipped as on the device.    */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "HttpServer.h"
+#include "Shim.h"
+
+struct ShimHttpClient
+{
+  std::string sPath;
+  unsigned long ulBytesPerSecond;
+  int iConnection;
+  unsigned long ulParts;
+  unsigned long ulBytes;
+  unsigned long long ullBytesRead; // Includes the heads
+};
+
+static std::vector<ShimHttpClient> vClients;
+static std::deque<int> dWaitingClients;
+// Client on each connection, and whether the part it sends was counted
+static int iConnectionClients[HTTP_MAX_CONNECTIONS];
+static bool bPartCounted[HTTP_MAX_CONNECTIONS];
+
+HttpServer::HttpServer()
+{
+  iListenSocket = -1;
+  memset(hcConnections, 0, sizeof(hcConnections));
+  iRouteCount = 0;
+  fnNotFound = NULL;
+  iConnectionCount = 0;
+  iPeakConnectionCount = 0;
+  ulAccepted = 0;
+  ulRejected = 0;
+  ulSkippedParts = 0;
+  ulLastPollMs = 0;
+  ulLastAcceptPollIntervalMs = 0;
+  ulMaxAcceptPollIntervalMs = 0;
+  ulMaxResponseLatencyMs = 0;
+}
+
+bool HttpServer::on(const char *cPath, HttpHandler fnHandler)
+{
+  if (HTTP_MAX_ROUTES <= iRouteCount) return false;
+  cRoutePaths[iRouteCount] = cPath;
+  fnRouteHandlers[iRouteCount] = fnHandler;
+  iRouteCount++;
+  return true;
+}
+
+void HttpServer::onNotFound(HttpHandler fnHandler)
+{
+  fnNotFound = fnHandler;
+}
+
+bool HttpServer::begin(uint16_t ui16Port, unsigned long ulNowMs)
+{
+  iListenSocket = ui16Port;
+  ulLastPollMs = ulNowMs;
+  return true;
+}
+
+void HttpServer::acceptConnections(unsigned long ulNowMs)
+{
+  if (dWaitingClients.empty()) return;
+  ulLastAcceptPollIntervalMs = ulNowMs - ulLastPollMs;
+  if (ulMaxAcceptPollIntervalMs < ulLastAcceptPollIntervalMs) ulMaxAcceptPollIntervalMs = ulLastAcceptPollIntervalMs;
+  while (!dWaitingClients.empty()) {
+    int iClient = dWaitingClients.front();
+    dWaitingClients.pop_front();
+    int iFree = -1;
+    for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS && iFree < 0; iConnection++) {
+      if (hcConnections[iConnection].iState == HTTP_CONN_FREE) iFree = iConnection;
+    }
+    if (iFree < 0) {
+      ulRejected++;
+      continue;
+    }
+    HttpConnection *pConnection = &hcConnections[iFree];
+    memset(pConnection, 0, sizeof(*pConnection));
+    pConnection->iSocket = iClient;
+    pConnection->iState = HTTP_CONN_READING;
+    snprintf(pConnection->cRequest, sizeof(pConnection->cRequest), "%s", vClients[iClient].sPath.c_str());
+    pConnection->pMethod = "GET";
+    pConnection->pPath = pConnection->cRequest;
+    pConnection->pQuery = "";
+    pConnection->ulAcceptMs = ulNowMs;
+    pConnection->ulActivityMs = ulNowMs;
+    iConnectionClients[iFree] = iClient;
+    vClients[iClient].iConnection = iFree;
+    ulAccepted++;
+    iConnectionCount++;
+    if (iPeakConnectionCount < iConnectionCount) iPeakConnectionCount = iConnectionCount;
+    dispatchRequest(iFree, ulNowMs);
+  }
+}
+
+void HttpServer::dispatchRequest(int iConnection, unsigned long ulNowMs)
+{
+  (void)ulNowMs;
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  for (int iRoute = 0; iRoute < iRouteCount; iRoute++) {
+    if (strcmp(cRoutePaths[iRoute], pConnection->pPath) == 0) {
+      fnRouteHandlers[iRoute](this, iConnection);
+      return;
+    }
+  }
+  if (fnNotFound) fnNotFound(this, iConnection);
+  else send(iConnection, 404, "text/plain", "Not Found\n");
+}
+
+void HttpServer::writeConnection(int iConnection, unsigned long ulNowMs)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  ShimHttpClient *pClient = &vClients[iConnectionClients[iConnection]];
+  // What the client could have read since it came, minus what it did
+  unsigned long long ullBudget = (unsigned long long)pClient->ulBytesPerSecond * (ulNowMs - pConnection->ulAcceptMs) / 1000;
+  ullBudget = pClient->ullBytesRead < ullBudget ? ullBudget - pClient->ullBytesRead : 0;
+  while (ullBudget && pConnection->iOutputSegment < HTTP_OUTPUT_SEGMENTS) {
+    size_t stLeft = pConnection->stOutputLength[pConnection->iOutputSegment] - pConnection->stOutputSent;
+    size_t stRead = ullBudget < stLeft ? (size_t)ullBudget : stLeft;
+    pConnection->stOutputSent += stRead;
+    pClient->ullBytesRead += stRead;
+    ullBudget -= stRead;
+    if (pConnection->stOutputSent == pConnection->stOutputLength[pConnection->iOutputSegment]) {
+      pConnection->iOutputSegment++;
+      pConnection->stOutputSent = 0;
+    }
+  }
+  if (!isOutputDone(iConnection)) return;
+  pConnection->ulActivityMs = ulNowMs;
+  if (pConnection->iState == HTTP_CONN_WRITING) {
+    closeConnection(iConnection, true);
+  } else if (pConnection->pOutput[1] && !bPartCounted[iConnection]) {
+    bPartCounted[iConnection] = true;
+    pClient->ulParts++;
+    pClient->ulBytes += pConnection->stOutputLength[1];
+  }
+}
+
+void HttpServer::setOutput(int iConnection, const void *pHead, size_t stHeadLength, const void *pBody, size_t stBodyLength, const void *pTail, size_t stTailLength)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  pConnection->pOutput[0] = (const uint8_t *)pHead;
+  pConnection->stOutputLength[0] = pHead ? stHeadLength : 0;
+  pConnection->pOutput[1] = (const uint8_t *)pBody;
+  pConnection->stOutputLength[1] = pBody ? stBodyLength : 0;
+  pConnection->pOutput[2] = (const uint8_t *)pTail;
+  pConnection->stOutputLength[2] = pTail ? stTailLength : 0;
+  pConnection->iOutputSegment = 0;
+  pConnection->stOutputSent = 0;
+  bPartCounted[iConnection] = false;
+}
+
+bool HttpServer::isOutputDone(int iConnection)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  for (int iSegment = pConnection->iOutputSegment; iSegment < HTTP_OUTPUT_SEGMENTS; iSegment++) {
+    size_t stSent = (iSegment == pConnection->iOutputSegment) ? pConnection->stOutputSent : 0;
+    if (stSent < pConnection->stOutputLength[iSegment]) return false;
+  }
+  return true;
+}
+
+void HttpServer::closeConnection(int iConnection, bool bComplete)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  if (pConnection->iState == HTTP_CONN_FREE) return;
+  HttpDoneCallback fnDone = pConnection->fnDone;
+  pConnection->fnDone = NULL;
+  pConnection->iState = HTTP_CONN_FREE;
+  vClients[iConnectionClients[iConnection]].iConnection = -1;
+  iConnectionCount--;
+  if (fnDone) fnDone(iConnection, bComplete);
+}
+
+void HttpServer::poll(unsigned long ulNowMs)
+{
+  acceptConnections(ulNowMs);
+  ulLastPollMs = ulNowMs;
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    int iState = hcConnections[iConnection].iState;
+    if (iState == HTTP_CONN_WRITING || iState == HTTP_CONN_STREAMING) writeConnection(iConnection, ulNowMs);
+  }
+}
+
+const char *HttpServer::getMethod(int iConnection)
+{
+  return hcConnections[iConnection].pMethod;
+}
+
+const char *HttpServer::getPath(int iConnection)
+{
+  return hcConnections[iConnection].pPath;
+}
+
+const char *HttpServer::getQuery(int iConnection)
+{
+  return hcConnections[iConnection].pQuery;
+}
+
+int HttpServer::getArgCount(int iConnection)
+{
+  (void)iConnection;
+  return 0;
+}
+
+void HttpServer::send(int iConnection, int iCode, const char *cContentType, const char *cText)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  snprintf(pConnection->cBody, sizeof(pConnection->cBody), "%s", cText);
+  size_t stLength = strlen(pConnection->cBody);
+  int iHeadLength = snprintf(pConnection->cHead, sizeof(pConnection->cHead), "HTTP/1.1 %d\r\nContent-Type: %s\r\nContent-Length: %u\r\n\r\n",
+                             iCode, cContentType, (unsigned int)stLength);
+  setOutput(iConnection, pConnection->cHead, iHeadLength, pConnection->cBody, stLength, NULL, 0);
+  pConnection->iState = HTTP_CONN_WRITING;
+}
+
+void HttpServer::sendData(int iConnection, int iCode, const char *cContentType, const uint8_t *pData, size_t stLength, HttpDoneCallback fnDone)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  int iHeadLength = snprintf(pConnection->cHead, sizeof(pConnection->cHead), "HTTP/1.1 %d\r\nContent-Type: %s\r\nContent-Length: %u\r\n\r\n",
+                             iCode, cContentType, (unsigned int)stLength);
+  setOutput(iConnection, pConnection->cHead, iHeadLength, pData, stLength, NULL, 0);
+  pConnection->fnDone = fnDone;
+  pConnection->iState = HTTP_CONN_WRITING;
+}
+
+void HttpServer::beginStream(int iConnection, const char *cResponseHead, const char *cPartPrefix, const char *cPartTail, HttpDoneCallback fnDone)
+{
+  HttpConnection *pConnection = &hcConnections[iConnection];
+  setOutput(iConnection, cResponseHead, strlen(cResponseHead), NULL, 0, NULL, 0);
+  pConnection->pPartPrefix = cPartPrefix;
+  pConnection->pPartTail = cPartTail;
+  pConnection->fnDone = fnDone;
+  pConnection->iState = HTTP_CONN_STREAMING;
+}
+
+bool HttpServer::isStreamWaiting()
+{
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    if (hcConnections[iConnection].iState == HTTP_CONN_STREAMING && isOutputDone(iConnection)) return true;
+  }
+  return false;
+}
+
+bool HttpServer::isPartInUse(const uint8_t *pData)
+{
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    HttpConnection *pConnection = &hcConnections[iConnection];
+    if (pConnection->iState == HTTP_CONN_STREAMING && pConnection->pOutput[1] == pData &&
+        pConnection->iOutputSegment <= 1 && !isOutputDone(iConnection)) return true;
+  }
+  return false;
+}
+
+void HttpServer::pushStreamPart(const uint8_t *pData, size_t stLength)
+{
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    HttpConnection *pConnection = &hcConnections[iConnection];
+    if (pConnection->iState != HTTP_CONN_STREAMING) continue;
+    if (!isOutputDone(iConnection)) {
+      ulSkippedParts++;
+      continue;
+    }
+    int iHeadLength = snprintf(pConnection->cHead, HTTP_HEAD_BUFFER_SIZE, "%s%u\r\n\r\n",
+                               pConnection->pPartPrefix, (unsigned int)stLength);
+    if (HTTP_HEAD_BUFFER_SIZE <= iHeadLength) iHeadLength = HTTP_HEAD_BUFFER_SIZE - 1;
+    setOutput(iConnection, pConnection->cHead, iHeadLength, pData, stLength,
+              pConnection->pPartTail, strlen(pConnection->pPartTail));
+  }
+}
+
+void HttpServer::endStreams()
+{
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    if (hcConnections[iConnection].iState == HTTP_CONN_STREAMING) closeConnection(iConnection, false);
+  }
+}
+
+int HttpServer::getStreamCount()
+{
+  int iStreams = 0;
+  for (int iConnection = 0; iConnection < HTTP_MAX_CONNECTIONS; iConnection++) {
+    if (hcConnections[iConnection].iState == HTTP_CONN_STREAMING) iStreams++;
+  }
+  return iStreams;
+}
+
+int HttpServer::getConnectionCount()
+{
+  return iConnectionCount;
+}
+
+int HttpServer::getPeakConnectionCount()
+{
+  return iPeakConnectionCount;
+}
+
+unsigned long HttpServer::getAcceptedCount()
+{
+  return ulAccepted;
+}
+
+unsigned long HttpServer::getRejectedCount()
+{
+  return ulRejected;
+}
+
+unsigned long HttpServer::getSkippedPartCount()
+{
+  return ulSkippedParts;
+}
+
+unsigned long HttpServer::getLastAcceptPollInterval()
+{
+  return ulLastAcceptPollIntervalMs;
+}
+
+unsigned long HttpServer::getMaxAcceptPollInterval()
+{
+  return ulMaxAcceptPollIntervalMs;
+}
+
+unsigned long HttpServer::getMaxResponseLatency()
+{
+  return ulMaxResponseLatencyMs;
+}
+
+int shimOpenHttpClient(const char *cPath, unsigned long ulBytesPerSecond)
+{
+  ShimHttpClient shcClient = { cPath, ulBytesPerSecond, -1, 0, 0, 0 };
+  vClients.push_back(shcClient);
+  dWaitingClients.push_back(vClients.size() - 1);
+  return vClients.size() - 1;
+}
+
+unsigned long shimGetHttpClientParts(int iClient)
+{
+  return vClients[iClient].ulParts;
+}
+
+unsigned long shimGetHttpClientBytes(int iClient)
+{
+  return vClients[iClient].ulBytes;
+}
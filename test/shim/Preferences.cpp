@@ -0,0 +1,54 @@
+/**************************************************/
+/* File name:        Preferences.cpp              */
+/* File description: Host stand-in for the NVS    */
+/*                   preferences, kept in memory. */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <map>
+#include <vector>
+#include "Preferences.h"
+
+static std::map<std::string, std::vector<uint8_t> > mStore;
+
+bool Preferences::begin(const char *cName, bool bReadOnlyMode)
+{
+  sNamespace = cName;
+  bReadOnly = bReadOnlyMode;
+  return true;
+}
+
+void Preferences::end(void)
+{
+  sNamespace.clear();
+}
+
+int32_t Preferences::getInt(const char *cKey, int32_t i32Default)
+{
+  int32_t i32Value = i32Default;
+  getBytes(cKey, &i32Value, sizeof(i32Value));
+  return i32Value;
+}
+
+size_t Preferences::putInt(const char *cKey, int32_t i32Value)
+{
+  return putBytes(cKey, &i32Value, sizeof(i32Value));
+}
+
+size_t Preferences::getBytes(const char *cKey, void *pBuffer, size_t stLength)
+{
+  std::map<std::string, std::vector<uint8_t> >::const_iterator itValue = mStore.find(sNamespace + "/" + cKey);
+  if (sNamespace.empty() || itValue == mStore.end() || stLength < itValue->second.size()) return 0;
+  memcpy(pBuffer, itValue->second.data(), itValue->second.size());
+  return itValue->second.size();
+}
+
+size_t Preferences::putBytes(const char *cKey, const void *pValue, size_t stLength)
+{
+  if (sNamespace.empty() || bReadOnly) return 0;
+  const uint8_t *pBytes = (const uint8_t *)pValue;
+  mStore[sNamespace + "/" + cKey] = std::vector<uint8_t>(pBytes, pBytes + stLength);
+  return stLength;
+}
@@ -0,0 +1,36 @@
+/**************************************************/
+/* File name:        Preferences.h                */
+/* File description: Host stand-in for the NVS    */
+/*                   preferences, kept in memory. */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef Preferences_h
+#define Preferences_h
+#include <string>
+#include "Arduino.h"
+
+/****************************************************/
+/* Class name:        Preferences                   */
+/* Class description: Keys of one namespace, every  */
+/*                    object shares the same store. */
+/****************************************************/
+class Preferences
+{
+  private:
+    std::string sNamespace;
+    bool bReadOnly;
+
+  public:
+    Preferences() : bReadOnly(true) {}
+    bool begin(const char *cName, bool bReadOnlyMode = false);
+    void end(void);
+    int32_t getInt(const char *cKey, int32_t i32Default = 0);
+    size_t putInt(const char *cKey, int32_t i32Value);
+    size_t getBytes(const char *cKey, void *pBuffer, size_t stLength);
+    size_t putBytes(const char *cKey, const void *pValue, size_t stLength);
+};
+
+#endif
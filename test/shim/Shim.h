@@ -0,0 +1,193 @@
+/**************************************************/
+/* File name:        Shim.h                       */
+/* File description: Controls of the host shims:  */
+/*                   the virtual clock, the tasks,*/
+/*                   the camera, sonar, PWM,      */
+/*                   timer, WiFi and HTTP         */
+/*                   stand-ins.                   */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef Shim_h
+#define Shim_h
+#include "esp_camera.h"
+
+// Frame source of esp_camera_fb_get, may block like the driver does
+typedef camera_fb_t *(*ShimCameraGrab)(void);
+// Called by the loop thread before it waits on a task, with the ticks
+typedef void (*ShimWaitHook)(unsigned long ulTicks);
+// Echo duration in us for pulseIn, 0 for no echo before the timeout
+typedef unsigned long (*ShimPulseSource)(uint8_t ui8Pin, unsigned long ulTimeoutUs);
+// Every duty written, at the time of the write
+typedef void (*ShimLedcObserver)(unsigned long ulTimeMs, uint8_t ui8Channel, uint32_t ui32Duty);
+// Answer to a GET of the URL sent at ulRequestMs, false if there is none
+typedef bool (*ShimHttpGetSource)(const char *cUrl, unsigned long ulRequestMs, unsigned long *pReadyMs,
+                                  char *cBody, size_t stBodySize);
+
+/****************************************************/
+/* Method name:        shimSetMillis,               */
+/*                     shimAdvanceMillis            */
+/* Method description: Sets or moves the time that  */
+/*                     millis returns.              */
+/*                                                  */
+/* Input params:       ulMs - Time in ms. (unsigned */
+/*                     long)                        */
+/* Output params:                                   */
+/****************************************************/
+void shimSetMillis(unsigned long ulMs);
+void shimAdvanceMillis(unsigned long ulMs);
+
+/****************************************************/
+/* Method name:        shimSetTaskSync              */
+/* Method description: Makes a notified task run    */
+/*                     until it blocks again before */
+/*                     the notifier goes on, so a   */
+/*                     run only depends on virtual  */
+/*                     time. Frame sources must then*/
+/*                     block through shimBlockTask. */
+/*                                                  */
+/* Input params:       bSync - On. (bool)           */
+/*                     fnWaitHook - Called before   */
+/*                     the loop waits, can be NULL. */
+/*                     (ShimWaitHook)               */
+/* Output params:                                   */
+/****************************************************/
+void shimSetTaskSync(bool bSync, ShimWaitHook fnWaitHook);
+
+/****************************************************/
+/* Method name:        shimBlockTask,               */
+/*                     shimUnblockTask,             */
+/*                     shimWaitTasksBlocked         */
+/* Method description: A task counts as blocked from*/
+/*                     shimBlockTask until another  */
+/*                     thread calls shimUnblockTask */
+/*                     for it. Notification waits   */
+/*                     count by themselves. The last*/
+/*                     one waits until every task is*/
+/*                     blocked.                     */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void shimBlockTask(void);
+void shimUnblockTask(void);
+void shimWaitTasksBlocked(void);
+
+/****************************************************/
+/* Method name:        shimSetCamera                */
+/* Method description: Sets what esp_camera_init    */
+/*                     returns and where the frames */
+/*                     come from.                   */
+/*                                                  */
+/* Input params:       eInitResult - Init result.   */
+/*                     (esp_err_t)                  */
+/*                     fnGrab - Frame source, NULL  */
+/*                     returns no frames.           */
+/*                     (ShimCameraGrab)             */
+/* Output params:                                   */
+/****************************************************/
+void shimSetCamera(esp_err_t eInitResult, ShimCameraGrab fnGrab);
+
+/****************************************************/
+/* Method name:        camera observers             */
+/* Method description: What the code under test did */
+/*                     with the driver.             */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:      Last init configuration,     */
+/*                     init and deinit counts, and  */
+/*                     whether the driver runs.     */
+/****************************************************/
+const camera_config_t &shimGetCameraConfig(void);
+int shimGetCameraInits(void);
+int shimGetCameraDeinits(void);
+bool shimIsCameraRunning(void);
+
+/****************************************************/
+/* Method name:        shimSetPulseSource           */
+/* Method description: Sets where pulseIn reads its */
+/*                     echoes, NULL times out.      */
+/*                                                  */
+/* Input params:       fnSource - Source.           */
+/*                     (ShimPulseSource)            */
+/* Output params:                                   */
+/****************************************************/
+void shimSetPulseSource(ShimPulseSource fnSource);
+
+/****************************************************/
+/* Method name:        shimSetLedcObserver,         */
+/*                     shimGetLedcDuty              */
+/* Method description: Reports the duties written,  */
+/*                     or the last one of a channel.*/
+/*                                                  */
+/* Input params:       fnObserver - Observer, can be*/
+/*                     NULL. (ShimLedcObserver)     */
+/*                     ui8Channel - Channel.        */
+/*                     (uint8_t)                    */
+/* Output params:      Duty. (uint32_t)             */
+/****************************************************/
+void shimSetLedcObserver(ShimLedcObserver fnObserver);
+uint32_t shimGetLedcDuty(uint8_t ui8Channel);
+
+/****************************************************/
+/* Method name:        shimRunTimers                */
+/* Method description: Fires the timer alarms due up*/
+/*                     to now, each with the clock  */
+/*                     the observers see set to its */
+/*                     own time.                    */
+/*                                                  */
+/* Input params:                                    */
+/* Output params:                                   */
+/****************************************************/
+void shimRunTimers(void);
+
+/****************************************************/
+/* Method name:        shimSetWiFiConnectTime       */
+/* Method description: Time WiFi.begin takes to     */
+/*                     connect.                     */
+/*                                                  */
+/* Input params:       ulMs - Time in ms. (unsigned */
+/*                     long)                        */
+/* Output params:                                   */
+/****************************************************/
+void shimSetWiFiConnectTime(unsigned long ulMs);
+
+/****************************************************/
+/* Method name:        shimSetHttpGetSource         */
+/* Method description: Sets where HttpGetClient     */
+/*                     gets its answers from.       */
+/*                                                  */
+/* Input params:       fnSource - Source.           */
+/*                     (ShimHttpGetSource)          */
+/* Output params:                                   */
+/****************************************************/
+void shimSetHttpGetSource(ShimHttpGetSource fnSource);
+
+/****************************************************/
+/* Method name:        shimOpenHttpClient           */
+/* Method description: A client that requests the   */
+/*                     path at the next server poll */
+/*                     and reads at a fixed rate.   */
+/*                                                  */
+/* Input params:       cPath - Path. (const char*)  */
+/*                     ulBytesPerSecond - Rate.     */
+/*                     (unsigned long)              */
+/* Output params:      Client number. (int)         */
+/****************************************************/
+int shimOpenHttpClient(const char *cPath, unsigned long ulBytesPerSecond);
+
+/****************************************************/
+/* Method name:        shimGetHttpClientParts,      */
+/*                     shimGetHttpClientBytes       */
+/* Method description: Stream parts and bytes a     */
+/*                     client read in full.         */
+/*                                                  */
+/* Input params:       iClient - Client. (int)      */
+/* Output params:      Count. (unsigned long)       */
+/****************************************************/
+unsigned long shimGetHttpClientParts(int iClient);
+unsigned long shimGetHttpClientBytes(int iClient);
+
+#endif
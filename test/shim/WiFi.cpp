@@ -0,0 +1,41 @@
+/**************************************************/
+/* File name:        WiFi.cpp                     */
+/* File description: Host stand-in for the WiFi   */
+/*                   station, in virtual time.    */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include "WiFi.h"
+#include "Shim.h"
+
+WiFiClass WiFi;
+static unsigned long ulWiFiConnectMs = 800;
+static uint8_t ui8Bssid[6] = {0x02, 0x55, 0x52, 0x53, 0x00, 0x01};
+
+int WiFiClass::begin(const char *cSsid, const char *cPassword, int32_t i32Channel, const uint8_t *pBssid)
+{
+  (void)cSsid;
+  (void)cPassword;
+  (void)i32Channel;
+  (void)pBssid;
+  bBegun = true;
+  ulBeginMs = millis();
+  return WL_DISCONNECTED;
+}
+
+int WiFiClass::status(void)
+{
+  return bBegun && ulWiFiConnectMs <= millis() - ulBeginMs ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+uint8_t *WiFiClass::BSSID(void)
+{
+  return ui8Bssid;
+}
+
+void shimSetWiFiConnectTime(unsigned long ulMs)
+{
+  ulWiFiConnectMs = ulMs;
+}
@@ -0,0 +1,66 @@
+/**************************************************/
+/* File name:        WiFi.h                       */
+/* File description: Host stand-in for the WiFi   */
+/*                   station the sketch uses, it  */
+/*                   connects after a set time.   */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef WiFi_h
+#define WiFi_h
+#include "Arduino.h"
+
+#define WIFI_STA                         1
+#define WL_CONNECTED                     3
+#define WL_DISCONNECTED                  6
+
+/****************************************************/
+/* Class name:        IPAddress                     */
+/* Class description: IPv4 address.                 */
+/****************************************************/
+class IPAddress
+{
+  private:
+    uint8_t ui8Bytes[4];
+
+  public:
+    IPAddress(uint8_t ui8A = 0, uint8_t ui8B = 0, uint8_t ui8C = 0, uint8_t ui8D = 0)
+    {
+      ui8Bytes[0] = ui8A;
+      ui8Bytes[1] = ui8B;
+      ui8Bytes[2] = ui8C;
+      ui8Bytes[3] = ui8D;
+    }
+    uint8_t operator[](int iIndex) const { return ui8Bytes[iIndex]; }
+};
+
+/****************************************************/
+/* Class name:        WiFiClass                     */
+/* Class description: Station that is connected     */
+/*                    shimSetWiFiConnectTime after  */
+/*                    each begin.                   */
+/****************************************************/
+class WiFiClass
+{
+  private:
+    bool bBegun;
+    unsigned long ulBeginMs;
+
+  public:
+    WiFiClass() : bBegun(false), ulBeginMs(0) {}
+    void persistent(bool bPersistent) { (void)bPersistent; }
+    bool mode(int iMode) { (void)iMode; return true; }
+    bool config(IPAddress ipLocal, IPAddress ipGateway, IPAddress ipSubnet) { (void)ipLocal; (void)ipGateway; (void)ipSubnet; return true; }
+    int begin(const char *cSsid, const char *cPassword, int32_t i32Channel = 0, const uint8_t *pBssid = NULL);
+    bool disconnect(void) { bBegun = false; return true; }
+    int status(void);
+    int32_t channel(void) { return 6; }
+    uint8_t *BSSID(void);
+    IPAddress localIP(void) { return IPAddress(192, 168, 0, 50); }
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,15 @@
+/**************************************************/
+/* File name:        esp_attr.h                   */
+/* File description: Host stand-in for the ESP-IDF*/
+/*                   placement attributes.        */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef esp_attr_h
+#define esp_attr_h
+
+#define IRAM_ATTR
+
+#endif
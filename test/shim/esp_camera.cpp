@@ -0,0 +1,76 @@
+/**************************************************/
+/* File name:        esp_camera.cpp               */
+/* File description: Host stand-in for the        */
+/*                   esp32-camera driver, frames  */
+/*                   come from the test.          */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <string.h>
+#include "esp_camera.h"
+#include "Shim.h"
+
+static esp_err_t eCameraInitResult = ESP_OK;
+static ShimCameraGrab fnCameraGrab = NULL;
+static camera_config_t ccCameraConfig;
+static int iCameraInits = 0;
+static int iCameraDeinits = 0;
+static bool bCameraRunning = false;
+
+esp_err_t esp_camera_init(const camera_config_t *config)
+{
+  iCameraInits++;
+  memcpy(&ccCameraConfig, config, sizeof(ccCameraConfig));
+  bCameraRunning = (eCameraInitResult == ESP_OK);
+  return eCameraInitResult;
+}
+
+esp_err_t esp_camera_deinit(void)
+{
+  iCameraDeinits++;
+  bCameraRunning = false;
+  return ESP_OK;
+}
+
+camera_fb_t *esp_camera_fb_get(void)
+{
+  if (!bCameraRunning || !fnCameraGrab) {
+    // The real call takes time even when it fails, loops on it must end
+    shimAdvanceMillis(1);
+    return NULL;
+  }
+  return fnCameraGrab();
+}
+
+void esp_camera_fb_return(camera_fb_t *fb)
+{
+  (void)fb;
+}
+
+void shimSetCamera(esp_err_t eInitResult, ShimCameraGrab fnGrab)
+{
+  eCameraInitResult = eInitResult;
+  fnCameraGrab = fnGrab;
+}
+
+const camera_config_t &shimGetCameraConfig(void)
+{
+  return ccCameraConfig;
+}
+
+int shimGetCameraInits(void)
+{
+  return iCameraInits;
+}
+
+int shimGetCameraDeinits(void)
+{
+  return iCameraDeinits;
+}
+
+bool shimIsCameraRunning(void)
+{
+  return bCameraRunning;
+}
@@ -0,0 +1,13 @@
+/**************************************************/
+/* File name:        esp_log.h                    */
+/* File description: Host stand-in for the ESP-IDF*/
+/*                   log header.                  */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef esp_log_h
+#define esp_log_h
+
+#endif
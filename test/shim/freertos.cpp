@@ -0,0 +1,194 @@
+/**************************************************/
+/* File name:        freertos.cpp                 */
+/* File description: Host stand-in for the        */
+/*                   FreeRTOS tasks, notifications*/
+/*                   and queues, on threads. A    */
+/*                   timed out wait moves the     */
+/*                   virtual clock by its ticks.  */
+/*                   With the task sync on, a     */
+/*                   notified task runs until it  */
+/*                   blocks again, as if it was   */
+/*                   the only other core.         */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "Shim.h"
+
+// Frames from the tests come at once, a longer real wait only slows them down
+#define SHIM_MAX_REAL_WAIT_MS            100
+
+struct ShimTask
+{
+  std::mutex mLock;
+  std::condition_variable cvNotified;
+  uint32_t ui32Notifications;
+  bool bBlocked;
+};
+
+struct ShimQueue
+{
+  std::mutex mLock;
+  std::condition_variable cvChanged;
+  std::deque<std::vector<uint8_t> > dItems;
+  size_t stLength;
+  size_t stItemSize;
+};
+
+static thread_local ShimTask *pCurrentTask = NULL;
+static std::atomic<int> aiTasks(0);
+static std::atomic<int> aiBlockedTasks(0);
+static bool bTaskSync = false;
+static ShimWaitHook fnTaskWaitHook = NULL;
+
+/****************************************************/
+/* Method name:        waitFor                      */
+/* Method description: Waits on a condition for the */
+/*                     given ticks, moving the      */
+/*                     virtual clock if they run    */
+/*                     out.                         */
+/*                                                  */
+/* Input params:       lock - Held lock.            */
+/*                     cvCondition - Condition.     */
+/*                     fnReady - Predicate.         */
+/*                     xTicks - Ticks to wait.      */
+/*                     (TickType_t)                 */
+/* Output params:      true if ready. (bool)        */
+/****************************************************/
+template <typename Predicate>
+static bool waitFor(std::unique_lock<std::mutex> &lock, std::condition_variable &cvCondition, Predicate fnReady, TickType_t xTicks)
+{
+  // The hook can make the awaited item come, a task can not wait on itself
+  if (!pCurrentTask && fnTaskWaitHook && xTicks && !fnReady()) fnTaskWaitHook(xTicks);
+  if (xTicks == portMAX_DELAY) {
+    cvCondition.wait(lock, fnReady);
+    return true;
+  }
+  unsigned long ulRealMs = xTicks < SHIM_MAX_REAL_WAIT_MS ? xTicks : SHIM_MAX_REAL_WAIT_MS;
+  if (cvCondition.wait_for(lock, std::chrono::milliseconds(ulRealMs), fnReady)) return true;
+  shimAdvanceMillis(xTicks);
+  return false;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth,
+                                   void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask,
+                                   BaseType_t xCoreID)
+{
+  (void)pcName;
+  (void)usStackDepth;
+  (void)uxPriority;
+  (void)xCoreID;
+  ShimTask *pTask = new ShimTask();
+  pTask->ui32Notifications = 0;
+  pTask->bBlocked = false;
+  aiTasks++;
+  if (pvCreatedTask) *pvCreatedTask = pTask;
+  // Tasks never return, the thread lives until the test exits
+  std::thread([pTask, pvTaskCode, pvParameters]() {
+    pCurrentTask = pTask;
+    pvTaskCode(pvParameters);
+  }).detach();
+  if (bTaskSync) shimWaitTasksBlocked();
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+  ShimTask *pTask = pCurrentTask;
+  std::unique_lock<std::mutex> lock(pTask->mLock);
+  // The notifier unblocks it, so a count of all blocked tasks stays true
+  if (!pTask->ui32Notifications) {
+    pTask->bBlocked = true;
+    aiBlockedTasks++;
+  }
+  bool bNotified = waitFor(lock, pTask->cvNotified, [pTask]() { return 0 < pTask->ui32Notifications; }, xTicksToWait);
+  if (pTask->bBlocked) {
+    pTask->bBlocked = false;
+    aiBlockedTasks--;
+  }
+  if (!bNotified) return 0;
+  uint32_t ui32Count = pTask->ui32Notifications;
+  pTask->ui32Notifications = xClearCountOnExit ? 0 : ui32Count - 1;
+  return ui32Count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+  {
+    std::lock_guard<std::mutex> lock(xTaskToNotify->mLock);
+    xTaskToNotify->ui32Notifications++;
+    if (xTaskToNotify->bBlocked) {
+      xTaskToNotify->bBlocked = false;
+      aiBlockedTasks--;
+    }
+    xTaskToNotify->cvNotified.notify_all();
+  }
+  if (bTaskSync) shimWaitTasksBlocked();
+  return pdPASS;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+  ShimQueue *pQueue = new ShimQueue();
+  pQueue->stLength = uxQueueLength;
+  pQueue->stItemSize = uxItemSize;
+  return pQueue;
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+  delete xQueue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+  std::unique_lock<std::mutex> lock(xQueue->mLock);
+  if (!waitFor(lock, xQueue->cvChanged, [xQueue]() { return xQueue->dItems.size() < xQueue->stLength; }, xTicksToWait)) return pdFAIL;
+  const uint8_t *pItem = (const uint8_t *)pvItemToQueue;
+  xQueue->dItems.push_back(std::vector<uint8_t>(pItem, pItem + xQueue->stItemSize));
+  xQueue->cvChanged.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+  std::unique_lock<std::mutex> lock(xQueue->mLock);
+  if (!waitFor(lock, xQueue->cvChanged, [xQueue]() { return !xQueue->dItems.empty(); }, xTicksToWait)) return pdFAIL;
+  memcpy(pvBuffer, xQueue->dItems.front().data(), xQueue->stItemSize);
+  xQueue->dItems.pop_front();
+  xQueue->cvChanged.notify_all();
+  return pdPASS;
+}
+
+void shimSetTaskSync(bool bSync, ShimWaitHook fnWaitHook)
+{
+  bTaskSync = bSync;
+  fnTaskWaitHook = fnWaitHook;
+}
+
+void shimBlockTask(void)
+{
+  aiBlockedTasks++;
+}
+
+void shimUnblockTask(void)
+{
+  aiBlockedTasks--;
+}
+
+void shimWaitTasksBlocked(void)
+{
+  while (aiBlockedTasks.load() < aiTasks.load()) std::this_thread::yield();
+}
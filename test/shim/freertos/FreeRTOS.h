@@ -0,0 +1,37 @@
+/**************************************************/
+/* File name:        FreeRTOS.h                   */
+/* File description: Host stand-in for the        */
+/*                   FreeRTOS types the URS code  */
+/*                   uses, tasks are threads and  */
+/*                   a tick is one ms.            */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef FreeRTOS_h
+#define FreeRTOS_h
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                          0
+#define pdTRUE                           1
+#define pdFAIL                           0
+#define pdPASS                           1
+#define portMAX_DELAY                    ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS               1
+#define pdMS_TO_TICKS(ms)                ((TickType_t)(ms))
+
+// Spin lock shared by the loop and the timer interrupt
+typedef struct { volatile int iLocked; } portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED     { 0 }
+#define portENTER_CRITICAL(pMux)         while (__atomic_exchange_n(&(pMux)->iLocked, 1, __ATOMIC_ACQUIRE)) {}
+#define portEXIT_CRITICAL(pMux)          __atomic_store_n(&(pMux)->iLocked, 0, __ATOMIC_RELEASE)
+#define portENTER_CRITICAL_ISR(pMux)     portENTER_CRITICAL(pMux)
+#define portEXIT_CRITICAL_ISR(pMux)      portEXIT_CRITICAL(pMux)
+
+#endif
@@ -0,0 +1,15 @@
+/**************************************************/
+/* File name:        pgmspace.h                   */
+/* File description: Host stand-in, flash strings */
+/*                   are plain memory.            */
+/* Author name:      Richard Netto                */
+/* Creation date:    19/10/2026                   */
+/* Revision date:    19/10/2026                   */
+/**************************************************/
+
+#ifndef pgmspace_h
+#define pgmspace_h
+
+#define PROGMEM
+
+#endif